@@ -36,6 +36,25 @@ namespace stdx
 		{
 			throw std::logic_error("Unsupported operation");
 		}
+
+		//事件循环数量
+		virtual size_t loop_count() const
+		{
+			return 0;
+		}
+
+		//事件循环统计(poller统计与执行统计合并)
+		virtual stdx::poller_stats_info stats_at(size_t index)
+		{
+			NO_USED(index);
+			throw std::logic_error("Unsupported operation");
+		}
+
+		//所有事件循环共享的任务队列中等待执行的任务数
+		virtual size_t shared_pending_tasks()
+		{
+			throw std::logic_error("Unsupported operation");
+		}
 	};
 
 	class _McmpThreadPool:public stdx::basic_thread_pool
@@ -98,6 +117,10 @@ namespace stdx
 	public:
 		_IoThreadPool(uint32_t num_threads);
 
+#ifndef WIN32
+		_IoThreadPool(uint32_t num_threads,stdx::poller_dispatcher<key_t> dispatcher);
+#endif
+
 		~_IoThreadPool();
 
 		virtual void run(std::function<void()>&& task) override;
@@ -108,7 +131,18 @@ namespace stdx
 		{
 			return m_poller;
 		}
+
+		virtual size_t loop_count() const override
+		{
+			return m_stats.size();
+		}
+
+		virtual stdx::poller_stats_info stats_at(size_t index) override;
+
+		virtual size_t shared_pending_tasks() override;
 	private:
+		void _Init(uint32_t num_threads);
+
 		void _Join();
 
 		void _Run(std::function<void()> task);
@@ -120,6 +154,7 @@ namespace stdx
 		poller_t m_poller;
 		stdx::cancel_token m_token;
 		std::vector<std::shared_ptr<std::thread>> m_threads;
+		std::vector<stdx::poller_stats> m_stats;
 #ifndef WIN32
 		stdx::spin_lock m_lock;
 		std::list<std::function<void()>> m_tasks;
@@ -283,6 +318,27 @@ namespace stdx
 		{
 			return m_impl->get_poller();
 		}
+
+		size_t loop_count() const
+		{
+			return m_impl->loop_count();
+		}
+
+		stdx::poller_stats_info stats_at(size_t index)
+		{
+			return m_impl->stats_at(index);
+		}
+
+		size_t shared_pending_tasks()
+		{
+			return m_impl->shared_pending_tasks();
+		}
+
+		//事件循环阻塞前忙轮询spin_us微秒,0表示关闭
+		void set_busy_poll(uint32_t spin_us)
+		{
+			get_poller().set_busy_poll(spin_us);
+		}
 	private:
 
 	};
@@ -300,5 +356,9 @@ namespace stdx
 
 	extern stdx::io_thread_pool make_io_thread_pool(uint32_t size);
 
+#ifndef WIN32
+	extern stdx::io_thread_pool make_io_thread_pool(uint32_t size,stdx::poller_dispatcher<stdx::basic_thread_pool::key_t> dispatcher);
+#endif
+
 	extern stdx::io_thread_pool threadpool;
 }
\ No newline at end of file
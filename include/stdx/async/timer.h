@@ -0,0 +1,103 @@
+#pragma once
+#include <stdx/env.h>
+#include <stdx/async/spin_lock.h>
+#include <memory>
+#include <functional>
+
+namespace stdx
+{
+	//一次性定时器,在线程池的事件循环中计时,不占用线程
+	//Linux使用timerfd,到期或取消后关闭
+	class _Timer:public std::enable_shared_from_this<stdx::_Timer>
+	{
+		using self_t = stdx::_Timer;
+		using lock_t = stdx::spin_lock;
+	public:
+		_Timer(std::function<void()> fn);
+
+		~_Timer();
+
+		DELETE_COPY(_Timer);
+
+		DELETE_MOVE(_Timer);
+
+		//开始计时,到期后在线程池中执行回调
+		void start(uint64_t ms);
+
+		//取消后回调不再执行,计时资源尽快释放
+		void cancel();
+	private:
+		std::function<void()> m_fn;
+		lock_t m_lock;
+		bool m_cancel;
+		bool m_fired;
+#ifdef WIN32
+		HANDLE m_handle;
+		//到期前保持存活
+		std::shared_ptr<self_t> m_self;
+#else
+		int m_fd;
+#endif
+
+		void _Fire();
+
+		//立即到期
+		void _Expire();
+	};
+
+	class timer
+	{
+		using impl_t = std::shared_ptr<stdx::_Timer>;
+		using self_t = stdx::timer;
+	public:
+		timer()
+			:m_impl(nullptr)
+		{}
+
+		timer(const impl_t& impl)
+			:m_impl(impl)
+		{}
+
+		timer(const self_t& other)
+			:m_impl(other.m_impl)
+		{}
+
+		timer(self_t&& other) noexcept
+			:m_impl(std::move(other.m_impl))
+		{}
+
+		~timer() = default;
+
+		self_t& operator=(const self_t& other)
+		{
+			m_impl = other.m_impl;
+			return *this;
+		}
+
+		self_t& operator=(self_t&& other) noexcept
+		{
+			m_impl = std::move(other.m_impl);
+			return *this;
+		}
+
+		bool operator==(const self_t& other) const
+		{
+			return m_impl == other.m_impl;
+		}
+
+		operator bool() const
+		{
+			return (bool)m_impl;
+		}
+
+		void cancel()
+		{
+			return m_impl->cancel();
+		}
+	private:
+		impl_t m_impl;
+	};
+
+	//ms毫秒后执行fn,不需要时调用cancel
+	extern stdx::timer make_timer(uint64_t ms, std::function<void()> fn);
+}
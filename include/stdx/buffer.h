@@ -3,6 +3,7 @@
 #include <memory>
 #include <stdx/string.h>
 #include <atomic>
+#include <vector>
 
 namespace stdx
 {
@@ -199,9 +200,139 @@ namespace stdx
 	private:
 		impl_t m_impl;
 	};
+
+	//缓存区视图
+	//持有缓存区的引用,表示其中[offset,offset+size)的部分
+	struct buffer_view
+	{
+		buffer_view()
+			:buffer()
+			,offset(0)
+			,size(0)
+		{}
+
+		buffer_view(const stdx::buffer &buf)
+			:buffer(buf)
+			,offset(0)
+			,size(buf.size())
+		{}
+
+		buffer_view(const stdx::buffer &buf,size_t off,size_t len)
+			:buffer(buf)
+			,offset(off)
+			,size(len)
+		{}
+
+		buffer_view(const stdx::buffer_view &other)
+			:buffer(other.buffer)
+			,offset(other.offset)
+			,size(other.size)
+		{}
+
+		~buffer_view() = default;
+
+		stdx::buffer_view& operator=(const stdx::buffer_view& other)
+		{
+			buffer = other.buffer;
+			offset = other.offset;
+			size = other.size;
+			return *this;
+		}
+
+		char* data()
+		{
+			return (char*)buffer + offset;
+		}
+
+		const char* data() const
+		{
+			return (const char*)buffer + offset;
+		}
+
+		stdx::buffer buffer;
+		size_t offset;
+		size_t size;
+	};
 }
 
 namespace stdx
 {
 	stdx::buffer make_buffer(size_t size=4096);
 }
+
+namespace stdx
+{
+	//可增长的输出缓存区
+	//小数据复制到连续的输出块中,大块数据以视图引用,结果可直接用于聚集发送
+	class output_buffer
+	{
+		using self_t = stdx::output_buffer;
+	public:
+		output_buffer(size_t block_size = 4096);
+
+		output_buffer(const self_t& other);
+
+		output_buffer(self_t&& other) noexcept;
+
+		~output_buffer() = default;
+
+		self_t& operator=(const self_t& other);
+
+		self_t& operator=(self_t&& other) noexcept;
+
+		void append(const char* data, size_t size);
+
+		//以0结尾的字符串
+		void append(const char* str);
+
+		void append(const std::string& str)
+		{
+			append(str.data(), str.size());
+		}
+
+		//以UTF-8写入
+		void append(const stdx::string& str);
+
+		void push_back(char ch)
+		{
+			append(&ch, 1);
+		}
+
+		//引用视图,不复制,发送完成前不能修改
+		void append_ref(const stdx::buffer_view& view);
+
+		//预留size字节的连续空间,写入后调用commit
+		char* reserve(size_t size);
+
+		void commit(size_t size);
+
+		size_t size() const
+		{
+			return m_size;
+		}
+
+		bool empty() const
+		{
+			return m_size == 0;
+		}
+
+		const std::vector<stdx::buffer_view>& views() const
+		{
+			return m_views;
+		}
+
+		//取出所有视图,之后缓存区为空
+		std::vector<stdx::buffer_view> release();
+
+		//复制为连续的数据
+		std::string to_string() const;
+
+		void clear();
+	private:
+		std::vector<stdx::buffer_view> m_views;
+		size_t m_size;
+		size_t m_block_size;
+		//m_views的最后一块是可以继续写入的输出块
+		bool m_tail_open;
+	};
+}
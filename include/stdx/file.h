@@ -64,6 +64,8 @@ namespace stdx
 			memset(&m_ol, 0, sizeof(OVERLAPPED));
 #else
 			is_io_operation = false;
+			is_persistent = false;
+			sock_err = 0;
 #endif
 		}
 
@@ -82,6 +84,9 @@ namespace stdx
 #ifdef LINUX
 		int32_t op_code;
 		int err_code;
+#ifdef STDX_USE_NATIVE_AIO
+		iocb cb;
+#endif
 #endif
 };
 	//文件读取完成事件
@@ -287,6 +292,11 @@ namespace stdx
 		}
 	private:
 		void prepare_callback(stdx::file_io_context *context);
+#if (defined LINUX) && (defined STDX_USE_NATIVE_AIO)
+		aiocp_t m_aiocp;
+
+		void _Submit(stdx::file_io_context* context);
+#endif
 	};
 
 	//文件IO服务
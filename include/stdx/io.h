@@ -181,6 +181,7 @@ namespace stdx
 #include <sys/eventfd.h>
 #include <sys/ioctl.h>
 #include <sys/stat.h>
+#include <sys/socket.h>
 #include <fcntl.h>
 #include <unistd.h>
 #include <unordered_map>
@@ -295,22 +296,49 @@ namespace stdx
 
 	extern int io_cancel(aio_context_t ctx_id, struct iocb* iocb, struct io_event* result);
 #define INVALID_EVENTFD -1
+#ifndef STDX_NATIVE_AIO_BATCH
+#define STDX_NATIVE_AIO_BATCH 64
+#endif
+	extern void aio_prepare_read(iocb *cb, int fd, char* buf, size_t size, int64_t offset, int resfd, void* ptr);
+
+	extern void aio_prepare_write(iocb *cb, int fd, char* buf, size_t size, int64_t offset, int resfd, void* ptr);
+
 	extern void aio_read(aio_context_t context, int fd, char* buf, size_t size, int64_t offset, int resfd, void* ptr);
 
 	extern void aio_write(aio_context_t context, int fd, char* buf, size_t size, int64_t offset, int resfd, void* ptr);
 
+	extern int make_eventfd(int flags);
+
+	//Native AIO完成端口
+	//push排队iocb,flush合并提交(每次最多batch个)
+	//start之后通过resfd(eventfd)在threadpool的事件循环中批量收割
 	template<typename _IOContext>
-	class _AIOCP
+	class _AIOCP:public std::enable_shared_from_this<stdx::_AIOCP<_IOContext>>
 	{
+		using self_t = stdx::_AIOCP<_IOContext>;
 	public:
-		_AIOCP(unsigned nr_events = 2048)
+		using handler_t = std::function<void(_IOContext*, int64_t)>;
+
+		_AIOCP(unsigned nr_events = 2048, size_t batch = STDX_NATIVE_AIO_BATCH)
 			:m_ctxid(0)
+			,m_eventfd(INVALID_EVENTFD)
+			,m_batch(batch ? batch : 1)
+			,m_lock()
+			,m_queue()
+			,m_handler()
 		{
 			memset(&m_ctxid, 0, sizeof(aio_context_t));
 			io_setup(nr_events, &m_ctxid);
 		}
 		~_AIOCP()
 		{
+			if (m_eventfd != INVALID_EVENTFD)
+			{
+				stdx::threadpool.get_poller().unbind(m_eventfd, [](int fd)
+					{
+						::close(fd);
+					});
+			}
 			io_destroy(m_ctxid);
 		}
 
@@ -380,17 +408,160 @@ namespace stdx
 		{
 			return m_ctxid;
 		}
+
+		int get_eventfd() const
+		{
+			return m_eventfd;
+		}
+
+		//开始在事件循环中收割完成事件
+		void start(handler_t handler)
+		{
+			if (m_eventfd != INVALID_EVENTFD)
+			{
+				return;
+			}
+			m_handler = handler;
+			m_eventfd = stdx::make_eventfd(EFD_NONBLOCK);
+			stdx::threadpool.get_poller().bind(m_eventfd);
+			std::weak_ptr<self_t> weak = this->shared_from_this();
+			stdx::stand_context* reaper = new stdx::stand_context;
+			reaper->events = stdx::epoll_events::in;
+			reaper->key = m_eventfd;
+			reaper->is_io_operation = true;
+			reaper->is_persistent = false;
+			reaper->io_operation = [](stdx::stand_context* cont)
+			{
+				eventfd_t val = 0;
+				if (::eventfd_read(cont->key, &val) == -1)
+				{
+					//EAGAIN: wait for completions,others: stopped
+					return errno != EAGAIN && errno != EWOULDBLOCK;
+				}
+				return true;
+			};
+			reaper->execute = [weak](stdx::stand_context* cont)
+			{
+				std::shared_ptr<self_t> impl = weak.lock();
+				if (!impl)
+				{
+					delete cont;
+					return;
+				}
+				impl->reap();
+				try
+				{
+					stdx::threadpool.get_poller().post(cont);
+				}
+				catch (const std::exception& err)
+				{
+					DBG_VAR(err);
+#ifdef DEBUG
+					::printf("[Native AIO]Post reaper fail: %s\n", err.what());
+#endif
+					delete cont;
+				}
+			};
+			stdx::threadpool.get_poller().post(reaper);
+		}
+
+		//排队iocb,返回true时需要调用flush
+		bool push(iocb* cb)
+		{
+			std::unique_lock<stdx::spin_lock> lock(m_lock);
+			m_queue.push_back(cb);
+			return m_queue.size() == 1;
+		}
+
+		//合并提交所有排队的iocb
+		void flush()
+		{
+			std::vector<iocb*> queue;
+			{
+				std::unique_lock<stdx::spin_lock> lock(m_lock);
+				std::swap(queue, m_queue);
+			}
+			size_t pos = 0;
+			while (pos < queue.size())
+			{
+				size_t nr = (std::min)(m_batch, queue.size() - pos);
+				int r = io_submit(m_ctxid, (long)nr, queue.data() + pos);
+				if (r < 1)
+				{
+					//the first iocb is invalid or the context is busy
+					int err = (r == 0) ? EAGAIN : errno;
+					_Complete((_IOContext*)queue[pos]->aio_data, -err);
+					pos += 1;
+					continue;
+				}
+				pos += (size_t)r;
+			}
+		}
+
+		//收割所有已完成的事件
+		size_t reap()
+		{
+			io_event evs[STDX_NATIVE_AIO_BATCH];
+			const long nr = (long)stdx::sizeof_array(evs);
+			timespec tm;
+			tm.tv_sec = 0;
+			tm.tv_nsec = 0;
+			size_t count = 0;
+			while (true)
+			{
+				int r = io_getevents(m_ctxid, 0, nr, evs, &tm);
+				if (r < 1)
+				{
+					break;
+				}
+				for (int i = 0; i < r; ++i)
+				{
+					_Complete((_IOContext*)evs[i].data, evs[i].res);
+				}
+				count += (size_t)r;
+				if (r < nr)
+				{
+					break;
+				}
+			}
+			return count;
+		}
 	private:
 		aio_context_t m_ctxid;
+		int m_eventfd;
+		size_t m_batch;
+		stdx::spin_lock m_lock;
+		std::vector<iocb*> m_queue;
+		handler_t m_handler;
+
+		void _Complete(_IOContext* context, int64_t res)
+		{
+			try
+			{
+				m_handler(context, res);
+			}
+			catch (const std::exception& err)
+			{
+				DBG_VAR(err);
+#ifdef DEBUG
+				::printf("[Native AIO]Completion error: %s\n", err.what());
+#endif
+			}
+		}
 	};
 	template<typename _IOContext>
 	class aiocp
 	{
 		using impl_t = std::shared_ptr<_AIOCP<_IOContext>>;
 	public:
+		using handler_t = typename _AIOCP<_IOContext>::handler_t;
+
 		aiocp(unsigned nr_events)
 			:m_impl(std::make_shared<_AIOCP<_IOContext>>(nr_events))
 		{}
+		aiocp(unsigned nr_events,size_t batch)
+			:m_impl(std::make_shared<_AIOCP<_IOContext>>(nr_events,batch))
+		{}
 		aiocp(const aiocp<_IOContext>& other)
 			:m_impl(other.m_impl)
 		{}
@@ -416,6 +587,31 @@ namespace stdx
 			return m_impl->get(res, ms);
 		}
 
+		int get_eventfd() const
+		{
+			return m_impl->get_eventfd();
+		}
+
+		void start(handler_t handler)
+		{
+			return m_impl->start(handler);
+		}
+
+		bool push(iocb* cb)
+		{
+			return m_impl->push(cb);
+		}
+
+		void flush()
+		{
+			return m_impl->flush();
+		}
+
+		size_t reap()
+		{
+			return m_impl->reap();
+		}
+
 		bool operator==(const aiocp& other) const
 		{
 			return m_impl == other.m_impl;
@@ -437,12 +633,14 @@ namespace stdx
 		stdx::epoll_event_model model;
 		std::list<_IOContext*> out_contexts;
 		std::list<_IOContext*> in_contexts;
+		//等待错误队列(如MSG_ZEROCOPY完成通知)的context
+		std::list<_IOContext*> err_contexts;
 		bool ready_in;
 		bool ready_out;
+		//使用过错误队列,单独的EPOLLERR不再视为致命错误
+		bool use_errqueue;
 	};
 
-	extern int make_eventfd(int flags);
-
 	extern int make_semaphore_eventfd(int flags);
 
 	template<typename _IOContext>
@@ -461,6 +659,10 @@ namespace stdx
 			, m_tasks()
 			, m_completions()
 			, m_wokeup(false)
+			, m_stats()
+			, m_busy_poll_ns(0)
+			, m_spinning(false)
+			, m_noticed(false)
 		{
 			epoll_event ev;
 			ev.events = stdx::epoll_events::in | stdx::epoll_events::et;
@@ -482,7 +684,16 @@ namespace stdx
 				return cont;
 			}
 			epoll_event ev[16];
-			int r = m_epoll.wait(ev,stdx::sizeof_array(ev), -1);
+			if (m_busy_poll_ns.load(std::memory_order_relaxed))
+			{
+				bool noticed = false;
+				cont = _BusyPoll(ev, stdx::sizeof_array(ev), noticed);
+				if (cont || noticed)
+				{
+					return cont;
+				}
+			}
+			int r = _Wait(ev, stdx::sizeof_array(ev), -1);
 			if (r > 0)
 			{
 				for (int i = 0; i < r; i++)
@@ -502,7 +713,7 @@ namespace stdx
 				return cont;
 			}
 			epoll_event ev[16];
-			int r = m_epoll.wait(ev,stdx::sizeof_array(ev), timeout_ms);
+			int r = _Wait(ev, stdx::sizeof_array(ev), timeout_ms);
 			if (r < 0)
 			{
 				return nullptr;
@@ -520,6 +731,12 @@ namespace stdx
 			bool wokeup = true;
 			{
 				std::unique_lock<lock_t> lock(m_ev_lock);
+				if (m_spinning)
+				{
+					//the loop is busy polling,no need to signal eventfd
+					m_noticed = true;
+					return;
+				}
 				std::swap(m_wokeup, wokeup);
 			}
 			if (!wokeup)
@@ -548,25 +765,32 @@ namespace stdx
 					if (ev.model.is_err_or_hup)
 					{
 						//clean context
-						p->io_operation(p);
-						m_completions.push_back(p);
+						_CleanContext(p);
 						return;
 					}
 					//get events
 					uint32_t events = p->events;
+					if (events & stdx::epoll_events::err)
+					{
+						ev.use_errqueue = true;
+					}
 					if (events & stdx::epoll_events::in)
 					{
 						if (ev.in_contexts.empty())
 						{
 							if (ev.ready_in)
 							{
-								bool r = p->io_operation(p);
-								ev.ready_in = false;
+								bool r = p->is_persistent ? _RunPersistent(p) : p->io_operation(p);
+								//completed without EAGAIN,the fd may still be readable
+								ev.ready_in = r;
 								if (r)
 								{
 									m_completions.push_back(p);
 									return;
 								}
+								//got EAGAIN,the next edge will arrive by itself
+								ev.in_contexts.push_back(p);
+								return;
 							}
 							ev.in_contexts.push_back(p);
 							_ResetFd(ev);
@@ -589,12 +813,26 @@ namespace stdx
 								ev.ready_out = false;
 							}
 							ev.out_contexts.push_back(p);
+							//the out edge may have been consumed already(e.g. by connect)
+							_ResetFd(ev);
 							return;
 						}
 						ev.out_contexts.push_back(p);
 						_ResetFd(ev);
 						return;
 					}
+					else if (events & stdx::epoll_events::err)
+					{
+						ev.use_errqueue = true;
+						//通知可能已经在队列中
+						if (ev.err_contexts.empty() && p->io_operation(p))
+						{
+							m_completions.push_back(p);
+							return;
+						}
+						ev.err_contexts.push_back(p);
+						return;
+					}
 				});
 		}
 
@@ -602,14 +840,23 @@ namespace stdx
 		{
 			_RunInLoop([this](int fd) mutable
 				{
-					stdx::epoll_context_list<_IOContext> ev;
+					auto it = m_map.find(fd);
+					if (it == m_map.end() || it->second.model.is_err_or_hup)
+					{
+						stdx::epoll_context_list<_IOContext> ev;
+						ev.use_errqueue = false;
+						m_map[fd] = std::move(ev);
+						it = m_map.find(fd);
+					}
+					//rebinding resets the model(e.g. after listen or connect)
+					//but keeps the contexts already queued on the fd
+					stdx::epoll_context_list<_IOContext>& ev = it->second;
 					ev.ready_in = false;
 					ev.ready_out = false;
 					_InitModel(ev.model, fd);
 					try
 					{
-						m_map[fd] = std::move(ev);
-						m_epoll.add_event(fd, &(ev.model.ev));
+						m_epoll.add_or_update_event(fd, &(ev.model.ev));
 					}
 					catch (const std::exception &ex)
 					{
@@ -654,17 +901,38 @@ namespace stdx
 					try
 					{
 						m_epoll.del_event(fd);
+					}
+					catch (const std::exception& err)
+					{
+						DBG_VAR(err);
+#ifdef DEBUG
+						::printf("[EpollProactor]Remove event failure: %s\n", err.what());
+#endif
+					}
+					try
+					{
 						deleter(fd);
 					}
 					catch (const std::exception& err)
 					{
 						DBG_VAR(err);
 #ifdef DEBUG
-						::printf("[EpollProactor]Remove event or delete fd failure: %s\n", err.what());
+						::printf("[EpollProactor]Delete fd failure: %s\n", err.what());
 #endif
 					}
 				}, object, deleter);
 		}
+
+		virtual stdx::poller_stats_info stats_at(size_t index) const override
+		{
+			NO_USED(index);
+			return stdx::poller_stats_info(m_stats);
+		}
+
+		virtual void set_busy_poll(uint32_t spin_us) override
+		{
+			m_busy_poll_ns.store(static_cast<uint64_t>(spin_us) * 1000, std::memory_order_relaxed);
+		}
 	private:
 
 		void __RunInLoop(task_t &&task)
@@ -673,6 +941,12 @@ namespace stdx
 			{
 				std::unique_lock<lock_t> lock(m_ev_lock);
 				m_tasks.push_back(std::move(task));
+				m_stats.pending_tasks.store(m_tasks.size(), std::memory_order_relaxed);
+				if (m_spinning)
+				{
+					//the loop is busy polling and will pick it up
+					return;
+				}
 				std::swap(m_wokeup, wokeup);
 			}
 			if (!wokeup)
@@ -715,69 +989,170 @@ namespace stdx
 			{
 				_IOContext* p = m_completions.front();
 				m_completions.pop_front();
+				m_stats.pending_completions.store(m_completions.size(), std::memory_order_relaxed);
 				return p;
 			}
 			return nullptr;
 		}
 
-		void _HandleIoEvent(epoll_event& ev)
+		int _Wait(epoll_event* ev, int maxevents, int timeout)
 		{
-			int fd = ev.data.fd;
-			stdx::epoll_context_list<_IOContext>& ev_ = m_map[fd];
-			if (ev.events & stdx::epoll_events::in)
+			uint64_t begin = stdx::poller_stats::now_ns();
+			int r = m_epoll.wait(ev, maxevents, timeout);
+			if (timeout != 0 || r > 0)
+			{
+				//empty spins are not counted
+				m_stats.add_wait(stdx::poller_stats::now_ns() - begin, r > 0 ? (size_t)r : 0);
+			}
+			return r;
+		}
+
+		//以0超时轮询直到有完成事件,被notice或用完预算
+		_IOContext* _BusyPoll(epoll_event* ev, int maxevents, bool& noticed)
+		{
+			uint64_t budget = m_busy_poll_ns.load(std::memory_order_relaxed);
+			{
+				std::unique_lock<lock_t> lock(m_ev_lock);
+				m_spinning = true;
+			}
+			uint64_t begin = stdx::poller_stats::now_ns();
+			_IOContext* cont = nullptr;
+			while (true)
 			{
-				if (!ev_.in_contexts.empty())
 				{
-					_IOContext* cont = ev_.in_contexts.front();
-					//I/O operation
-					if (cont->io_operation(cont))
-					{
-						//I/O operation finish
-						ev_.in_contexts.pop_front();
-						m_completions.push_back(cont);
-						if (!ev_.in_contexts.empty())
-						{
-							_ResetFd(ev_);
-						}
-					}
+					std::unique_lock<lock_t> lock(m_ev_lock);
+					noticed = m_noticed;
+					m_noticed = false;
 				}
-				else
+				_HandleTasks();
+				cont = _CheckCompletions();
+				if (cont || noticed)
 				{
-					ev_.ready_in = true;
+					break;
+				}
+				int r = _Wait(ev, maxevents, 0);
+				for (int i = 0; i < r; i++)
+				{
+					_HandleEv(ev[i]);
+				}
+				cont = _CheckCompletions();
+				if (cont || stdx::poller_stats::now_ns() - begin >= budget)
+				{
+					break;
 				}
 			}
-			//handle out event
-			if (ev.events & stdx::epoll_events::out)
+			bool need_wakeup = false;
 			{
-				if (!ev_.out_contexts.empty())
+				std::unique_lock<lock_t> lock(m_ev_lock);
+				m_spinning = false;
+				noticed = noticed || m_noticed;
+				m_noticed = false;
+				//tasks posted after the last check were not signalled
+				if (!m_tasks.empty() && !m_wokeup)
 				{
-					_IOContext* cont = ev_.out_contexts.front();
-					//I/O operation
-					if (cont->io_operation(cont))
-					{
-						//I/O operation finish
-						ev_.out_contexts.pop_front();
-						m_completions.push_back(cont);
-						if (!ev_.out_contexts.empty())
-						{
-							_ResetFd(ev_);
-						}
-					}
+					m_wokeup = true;
+					need_wakeup = true;
+				}
+			}
+			if (need_wakeup)
+			{
+				_WokenUpFd();
+			}
+			return cont;
+		}
+
+		//返回false表示遇到EAGAIN,队列清空时fd可能仍然就绪
+		bool _DrainContexts(std::list<_IOContext*>& contexts)
+		{
+			while (!contexts.empty())
+			{
+				_IOContext* cont = contexts.front();
+				//I/O operation
+				if (!(cont->is_persistent ? _RunPersistent(cont) : cont->io_operation(cont)))
+				{
+					return false;
 				}
-				else
+				//I/O operation finish
+				contexts.pop_front();
+				m_completions.push_back(cont);
+			}
+			return true;
+		}
+
+		//返回false表示该fd未使用错误队列或发生了套接字错误
+		bool _HandleErrQueue(epoll_event& ev)
+		{
+			stdx::epoll_context_list<_IOContext>& ev_ = m_map[ev.data.fd];
+			if (!ev_.use_errqueue)
+			{
+				return false;
+			}
+			try
+			{
+				//等待中的context先读取错误队列中的通知
+				_DrainContexts(ev_.err_contexts);
+			}
+			catch (const std::exception& err)
+			{
+				DBG_VAR(err);
+#ifdef DEBUG
+				::printf("[EpollProactor]Handle error queue fail: %s\n", err.what());
+#endif
+			}
+			//通知之外的套接字错误(如对端重置)按错误处理
+			int so_err = 0;
+			socklen_t len = sizeof(so_err);
+			if (::getsockopt(ev.data.fd, SOL_SOCKET, SO_ERROR, &so_err, &len) == 0 && so_err != 0)
+			{
+				//错误已被SO_ERROR取走,只让队列中的操作以该错误结束,fd仍可使用
+				_CleanContexts(ev_, so_err);
+				return true;
+			}
+			try
+			{
+				if (ev.events & (stdx::epoll_events::in | stdx::epoll_events::out))
 				{
-					ev_.ready_out = true;
+					_HandleIoEvent(ev);
 				}
 			}
+			catch (const std::exception& err)
+			{
+				DBG_VAR(err);
+#ifdef DEBUG
+				::printf("[EpollProactor]Handle IO Event Fail: %s\n", err.what());
+#endif
+			}
+			return true;
+		}
+
+		void _HandleIoEvent(epoll_event& ev)
+		{
+			int fd = ev.data.fd;
+			stdx::epoll_context_list<_IOContext>& ev_ = m_map[fd];
+			if (ev.events & stdx::epoll_events::in)
+			{
+				//一个边沿内依次完成队列中的context,直到EAGAIN
+				ev_.ready_in = _DrainContexts(ev_.in_contexts);
+			}
+			//handle out event
+			if (ev.events & stdx::epoll_events::out)
+			{
+				ev_.ready_out = _DrainContexts(ev_.out_contexts);
+			}
 		}
 
 		void _HandleEv(epoll_event &ev)
 		{
 			if (ev.data.fd == m_eventfd)
 			{
+				m_stats.wakeups.fetch_add(1, std::memory_order_relaxed);
 				_HandleTasks();
 				return;
 			}
+			else if ((ev.events & stdx::epoll_events::err) && !(ev.events & stdx::epoll_events::hup) && _HandleErrQueue(ev))
+			{
+				//error queue notification,the fd is still usable
+			}
 			else if (ev.events & (stdx::epoll_events::err | stdx::epoll_events::hup))
 			{
 				//has error(s)
@@ -801,22 +1176,63 @@ namespace stdx
 			}
 		}
 
-		void _CleanContexts(stdx::epoll_context_list<_IOContext>& ev)
+		//持久注册:读到EAGAIN为止,每块数据就地execute
+		//返回true表示注册已结束(出错或被execute取消),需要走完成队列
+		bool _RunPersistent(_IOContext* cont)
 		{
-			auto* contexts = &(ev.in_contexts);
-			for (auto begin = contexts->begin(), end = contexts->end(); begin != end; ++begin)
+			while (cont->io_operation(cont))
 			{
-				(*begin)->io_operation(*begin);
-				m_completions.push_back(*begin);
+				if (cont->is_persistent)
+				{
+					try
+					{
+						cont->execute(cont);
+					}
+					catch (const std::exception& err)
+					{
+						DBG_VAR(err);
+#ifdef DEBUG
+						::printf("[EpollProactor]Persistent execute fail: %s\n", err.what());
+#endif
+					}
+				}
+				if (!cont->is_persistent)
+				{
+					return true;
+				}
+			}
+			return false;
+		}
+
+		void _CleanContext(_IOContext* cont)
+		{
+			if (cont->is_persistent)
+			{
+				//先交付剩余数据
+				if (!_RunPersistent(cont))
+				{
+					cont->is_persistent = false;
+				}
 			}
-			contexts->clear();
-			contexts = &(ev.out_contexts);
-			for (auto begin = contexts->begin(), end = contexts->end(); begin != end; ++begin)
+			else
+			{
+				cont->io_operation(cont);
+			}
+			m_completions.push_back(cont);
+		}
+
+		void _CleanContexts(stdx::epoll_context_list<_IOContext>& ev, int sock_err = 0)
+		{
+			std::list<_IOContext*>* lists[] = { &(ev.in_contexts),&(ev.out_contexts),&(ev.err_contexts) };
+			for (size_t i = 0; i < stdx::sizeof_array(lists); ++i)
 			{
-				(*begin)->io_operation(*begin);
-				m_completions.push_back(*begin);
+				for (auto begin = lists[i]->begin(), end = lists[i]->end(); begin != end; ++begin)
+				{
+					(*begin)->sock_err = sock_err;
+					_CleanContext(*begin);
+				}
+				lists[i]->clear();
 			}
-			contexts->clear();
 		}
 
 		void _CleanFd(int fd)
@@ -846,6 +1262,7 @@ namespace stdx
 				std::unique_lock<lock_t> lock(m_ev_lock);
 				std::swap(tasks, m_tasks);
 				m_wokeup = false;
+				m_stats.pending_tasks.store(0, std::memory_order_relaxed);
 			}
 			if (tasks.empty())
 			{
@@ -853,6 +1270,7 @@ namespace stdx
 			}
 			for (auto begin = tasks.begin(),end = tasks.end();begin != end;begin++)
 			{
+				uint64_t start = stdx::poller_stats::now_ns();
 				try
 				{
 					if (*begin)
@@ -866,7 +1284,9 @@ namespace stdx
 					::printf("[EpollProactor]Execute task error: %s\n", err.what());
 #endif
 				}
+				m_stats.add_task(stdx::poller_stats::now_ns() - start);
 			}
+			m_stats.pending_completions.store(m_completions.size(), std::memory_order_relaxed);
 		}
 
 		stdx::epoll m_epoll;
@@ -876,6 +1296,10 @@ namespace stdx
 		std::list<task_t> m_tasks;
 		std::list<_IOContext*> m_completions;
 		bool m_wokeup;
+		stdx::poller_stats m_stats;
+		std::atomic_uint64_t m_busy_poll_ns;
+		bool m_spinning;
+		bool m_noticed;
 	};
 
 	template<typename _IOContext>
@@ -885,17 +1309,19 @@ namespace stdx
 	}
 
 	template<typename _IOContext>
-	inline stdx::io_poller<_IOContext> make_epoll_multipoller(size_t num_of_poller)
+	inline stdx::io_poller<_IOContext> make_epoll_multipoller(size_t num_of_poller,stdx::poller_dispatcher<int> dispatcher)
 	{
-		return stdx::make_multipoller<stdx::_EpollProactor<_IOContext>>(num_of_poller, [](const int& fd, size_t size)
-			{
-				size_t index = fd % size;
-				return index;
-			}, [](_IOContext *cont)
+		return stdx::make_multipoller<stdx::_EpollProactor<_IOContext>>(num_of_poller, dispatcher, [](_IOContext *cont)
 			{
 				return cont->key;
 			});
 	}
+
+	template<typename _IOContext>
+	inline stdx::io_poller<_IOContext> make_epoll_multipoller(size_t num_of_poller)
+	{
+		return stdx::make_epoll_multipoller<_IOContext>(num_of_poller, stdx::make_least_bound_poller_dispatcher<int>());
+	}
 }
 
 #undef _ThrowLinuxError
@@ -0,0 +1,281 @@
+#pragma once
+#include <stdx/net/socket.h>
+#include <stdx/async/spin_lock.h>
+
+//复制写入使用的输出块大小
+#ifndef STDX_WRITE_BUFFER_SIZE
+#define STDX_WRITE_BUFFER_SIZE 16384
+#endif
+
+//待发送数据达到该大小时立即发送
+#ifndef STDX_WRITE_FLUSH_THRESHOLD
+#define STDX_WRITE_FLUSH_THRESHOLD 65536
+#endif
+
+//不小于该大小的buffer直接引用,不复制
+#ifndef STDX_WRITE_COPY_LIMIT
+#define STDX_WRITE_COPY_LIMIT 4096
+#endif
+
+//读缓冲区的最大大小(单行或read_exact的上限)
+#ifndef STDX_READ_BUFFER_MAX_SIZE
+#define STDX_READ_BUFFER_MAX_SIZE 1048576
+#endif
+
+namespace stdx
+{
+	//合并小的写入,在事件循环处理完当前任务后或达到阈值时用一次聚集发送
+	class _BufferedSocketWriter:public std::enable_shared_from_this<stdx::_BufferedSocketWriter>
+	{
+		using self_t = stdx::_BufferedSocketWriter;
+		using lock_t = stdx::spin_lock;
+	public:
+		_BufferedSocketWriter(const stdx::socket& sock, size_t threshold);
+
+		~_BufferedSocketWriter() = default;
+
+		DELETE_COPY(_BufferedSocketWriter);
+
+		DELETE_MOVE(_BufferedSocketWriter);
+
+		//复制数据到输出缓冲区
+		void write(const char* data, size_t size);
+
+		//大buffer直接引用,发送完成前不能修改
+		void write(stdx::buffer buf, size_t size);
+
+		//完成时,调用flush之前写入的数据都已发送
+		stdx::task<void> flush();
+
+		size_t pending_size();
+
+		stdx::socket socket() const
+		{
+			return m_socket;
+		}
+	private:
+		stdx::socket m_socket;
+		size_t m_threshold;
+		lock_t m_lock;
+		std::vector<stdx::buffer_view> m_pending;
+		size_t m_pending_size;
+		//m_pending的最后一块是可以继续复制的输出块
+		bool m_tail_open;
+		bool m_sending;
+		bool m_flush_scheduled;
+		std::exception_ptr m_error;
+		//等待m_pending发送完成
+		std::vector<stdx::task_completion_event<void>> m_waiters;
+		//等待正在发送的批次完成
+		std::vector<stdx::task_completion_event<void>> m_sending_waiters;
+
+		void _Append(const char* data, size_t size);
+
+		void _Schedule(std::unique_lock<lock_t>& lock);
+
+		void _Send(std::unique_lock<lock_t>& lock);
+
+		void _OnSent(std::exception_ptr error);
+	};
+
+	class buffered_socket_writer
+	{
+		using impl_t = std::shared_ptr<stdx::_BufferedSocketWriter>;
+		using self_t = stdx::buffered_socket_writer;
+	public:
+		buffered_socket_writer()
+			:m_impl(nullptr)
+		{}
+
+		buffered_socket_writer(const impl_t& impl)
+			:m_impl(impl)
+		{}
+
+		buffered_socket_writer(const self_t& other)
+			:m_impl(other.m_impl)
+		{}
+
+		buffered_socket_writer(self_t&& other) noexcept
+			:m_impl(std::move(other.m_impl))
+		{}
+
+		~buffered_socket_writer() = default;
+
+		self_t& operator=(const self_t& other)
+		{
+			m_impl = other.m_impl;
+			return *this;
+		}
+
+		self_t& operator=(self_t&& other) noexcept
+		{
+			m_impl = std::move(other.m_impl);
+			return *this;
+		}
+
+		bool operator==(const self_t& other) const
+		{
+			return m_impl == other.m_impl;
+		}
+
+		operator bool() const
+		{
+			return (bool)m_impl;
+		}
+
+		void write(const char* data, size_t size)
+		{
+			return m_impl->write(data, size);
+		}
+
+		void write(stdx::buffer buf, size_t size)
+		{
+			return m_impl->write(buf, size);
+		}
+
+		stdx::task<void> flush()
+		{
+			return m_impl->flush();
+		}
+
+		size_t pending_size()
+		{
+			return m_impl->pending_size();
+		}
+
+		stdx::socket socket() const
+		{
+			return m_impl->socket();
+		}
+	private:
+		impl_t m_impl;
+	};
+
+	extern stdx::buffered_socket_writer make_buffered_socket_writer(const stdx::socket& sock, size_t threshold = STDX_WRITE_FLUSH_THRESHOLD);
+
+	//可复用的读缓冲区
+	//同一时间只能有一个读操作,返回的视图在下一次读之前有效
+	class _BufferedSocketReader:public std::enable_shared_from_this<stdx::_BufferedSocketReader>
+	{
+		using self_t = stdx::_BufferedSocketReader;
+	public:
+		_BufferedSocketReader(const stdx::socket& sock, size_t size, size_t max_size);
+
+		~_BufferedSocketReader() = default;
+
+		DELETE_COPY(_BufferedSocketReader);
+
+		DELETE_MOVE(_BufferedSocketReader);
+
+		//读到delimiter为止,视图包含delimiter
+		stdx::task<stdx::buffer_view> read_until(const std::string& delimiter);
+
+		stdx::task<stdx::buffer_view> read_exact(size_t size);
+
+		//返回已缓冲的数据,没有时接收一次
+		stdx::task<stdx::buffer_view> read_some();
+
+		size_t buffered_size() const
+		{
+			return m_end - m_begin;
+		}
+
+		stdx::socket socket() const
+		{
+			return m_socket;
+		}
+	private:
+		stdx::socket m_socket;
+		stdx::buffer m_buf;
+		//[m_begin,m_end)为未读数据
+		size_t m_begin;
+		size_t m_end;
+		size_t m_max_size;
+
+		stdx::buffer_view _Take(size_t size);
+
+		//保证m_begin之后至少有size字节的空间
+		bool _Reserve(size_t size);
+
+		void _Fill(std::function<void(std::exception_ptr)> callback);
+
+		void _ReadUntil(std::string delimiter, size_t scanned, stdx::task_completion_event<stdx::buffer_view> ce);
+
+		void _ReadExact(size_t size, stdx::task_completion_event<stdx::buffer_view> ce);
+	};
+
+	class buffered_socket_reader
+	{
+		using impl_t = std::shared_ptr<stdx::_BufferedSocketReader>;
+		using self_t = stdx::buffered_socket_reader;
+	public:
+		buffered_socket_reader()
+			:m_impl(nullptr)
+		{}
+
+		buffered_socket_reader(const impl_t& impl)
+			:m_impl(impl)
+		{}
+
+		buffered_socket_reader(const self_t& other)
+			:m_impl(other.m_impl)
+		{}
+
+		buffered_socket_reader(self_t&& other) noexcept
+			:m_impl(std::move(other.m_impl))
+		{}
+
+		~buffered_socket_reader() = default;
+
+		self_t& operator=(const self_t& other)
+		{
+			m_impl = other.m_impl;
+			return *this;
+		}
+
+		self_t& operator=(self_t&& other) noexcept
+		{
+			m_impl = std::move(other.m_impl);
+			return *this;
+		}
+
+		bool operator==(const self_t& other) const
+		{
+			return m_impl == other.m_impl;
+		}
+
+		operator bool() const
+		{
+			return (bool)m_impl;
+		}
+
+		stdx::task<stdx::buffer_view> read_until(const std::string& delimiter)
+		{
+			return m_impl->read_until(delimiter);
+		}
+
+		stdx::task<stdx::buffer_view> read_exact(size_t size)
+		{
+			return m_impl->read_exact(size);
+		}
+
+		stdx::task<stdx::buffer_view> read_some()
+		{
+			return m_impl->read_some();
+		}
+
+		size_t buffered_size() const
+		{
+			return m_impl->buffered_size();
+		}
+
+		stdx::socket socket() const
+		{
+			return m_impl->socket();
+		}
+	private:
+		impl_t m_impl;
+	};
+
+	extern stdx::buffered_socket_reader make_buffered_socket_reader(const stdx::socket& sock, size_t size = 4096, size_t max_size = STDX_READ_BUFFER_MAX_SIZE);
+}
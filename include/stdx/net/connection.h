@@ -27,6 +27,9 @@ namespace stdx
 
 		virtual stdx::task<void> write_file(stdx::file_handle file) = 0;
 
+		//发送文件的[offset,offset+length),length为0时发送到文件末尾,prefix在文件之前发送
+		virtual stdx::task<void> write_file(stdx::file_handle file, uint64_t offset, uint64_t length, stdx::buffer_view prefix) = 0;
+
 		INTERFACE_CLASS_HELPER(basic_connection);
 	};
 
@@ -102,6 +105,11 @@ namespace stdx
 			return m_impl->write_file(file);
 		}
 
+		stdx::task<void> write_file(stdx::file_handle file, uint64_t offset, uint64_t length, stdx::buffer_view prefix = stdx::buffer_view())
+		{
+			return m_impl->write_file(file, offset, length, prefix);
+		}
+
 		bool operator==(const self_t& other) const
 		{
 			return m_impl == other.m_impl;
@@ -0,0 +1,171 @@
+#pragma once
+#include <stdx/net/socket.h>
+#include <stdx/async/spin_lock.h>
+#include <stdx/async/cancel_token.h>
+#include <stdx/async/timer.h>
+#include <unordered_map>
+#include <list>
+#include <queue>
+
+//每个远端地址的最大连接数(包括空闲、使用中和连接中的连接)
+#ifndef STDX_POOL_MAX_PER_HOST
+#define STDX_POOL_MAX_PER_HOST 16
+#endif
+
+//空闲连接的存活时间(毫秒)
+#ifndef STDX_POOL_IDLE_TIMEOUT
+#define STDX_POOL_IDLE_TIMEOUT 60000
+#endif
+
+namespace stdx
+{
+	struct _ConnectionPoolHost
+	{
+		_ConnectionPoolHost()
+			:count(0)
+			,idle()
+			,waiters()
+		{}
+
+		~_ConnectionPoolHost() = default;
+
+		struct idle_connection
+		{
+			stdx::socket sock;
+			uint64_t release_tick;
+		};
+
+		//该地址已有的连接数
+		size_t count;
+		//最近归还的在尾部
+		std::list<idle_connection> idle;
+		std::queue<stdx::task_completion_event<stdx::socket>> waiters;
+	};
+
+	//按远端地址复用已连接的socket
+	class _ConnectionPool:public std::enable_shared_from_this<stdx::_ConnectionPool>
+	{
+		using self_t = stdx::_ConnectionPool;
+		using lock_t = stdx::spin_lock;
+		using host_t = stdx::_ConnectionPoolHost;
+	public:
+		_ConnectionPool(const stdx::network_io_service& io_service, size_t max_per_host, uint64_t idle_timeout_ms);
+
+		~_ConnectionPool();
+
+		DELETE_COPY(_ConnectionPool);
+
+		DELETE_MOVE(_ConnectionPool);
+
+		//优先复用空闲连接,达到上限时等待其他连接归还
+		stdx::task<stdx::socket> get(const stdx::socket_addr& addr);
+
+		//归还连接,reusable为false时关闭连接(例如响应没有读完或对端要求关闭)
+		void release(const stdx::socket_addr& addr, stdx::socket sock, bool reusable = true);
+
+		//关闭超时的空闲连接,有空闲连接时由定时器调用
+		void evict_idle();
+
+		size_t idle_count(const stdx::socket_addr& addr);
+
+		void close();
+	private:
+		stdx::network_io_service m_io_service;
+		size_t m_max_per_host;
+		uint64_t m_idle_timeout;
+		lock_t m_lock;
+		std::unordered_map<std::string, host_t> m_hosts;
+		stdx::cancel_token m_token;
+		//只在有空闲连接时计时,没有空闲连接时不占用poller
+		bool m_evict_armed;
+		stdx::timer m_evict_timer;
+
+		static std::string _Key(const stdx::socket_addr& addr);
+
+		void _Connect(const stdx::socket_addr& addr, stdx::task_completion_event<stdx::socket> ce);
+
+		//连接关闭后,让等待者使用空出的名额
+		void _OnClosed(const stdx::socket_addr& addr);
+
+		//在ms毫秒后淘汰空闲连接
+		void _ArmEvict(uint64_t ms);
+
+		//淘汰后按最早归还的空闲连接重新计时,没有空闲连接时停止
+		void _OnEvictTimer();
+	};
+
+	class connection_pool
+	{
+		using impl_t = std::shared_ptr<stdx::_ConnectionPool>;
+		using self_t = stdx::connection_pool;
+	public:
+		connection_pool()
+			:m_impl(nullptr)
+		{}
+
+		connection_pool(const impl_t& impl)
+			:m_impl(impl)
+		{}
+
+		connection_pool(const self_t& other)
+			:m_impl(other.m_impl)
+		{}
+
+		connection_pool(self_t&& other) noexcept
+			:m_impl(std::move(other.m_impl))
+		{}
+
+		~connection_pool() = default;
+
+		self_t& operator=(const self_t& other)
+		{
+			m_impl = other.m_impl;
+			return *this;
+		}
+
+		self_t& operator=(self_t&& other) noexcept
+		{
+			m_impl = std::move(other.m_impl);
+			return *this;
+		}
+
+		bool operator==(const self_t& other) const
+		{
+			return m_impl == other.m_impl;
+		}
+
+		operator bool() const
+		{
+			return (bool)m_impl;
+		}
+
+		stdx::task<stdx::socket> get(const stdx::socket_addr& addr)
+		{
+			return m_impl->get(addr);
+		}
+
+		void release(const stdx::socket_addr& addr, stdx::socket sock, bool reusable = true)
+		{
+			return m_impl->release(addr, sock, reusable);
+		}
+
+		void evict_idle()
+		{
+			return m_impl->evict_idle();
+		}
+
+		size_t idle_count(const stdx::socket_addr& addr)
+		{
+			return m_impl->idle_count(addr);
+		}
+
+		void close()
+		{
+			return m_impl->close();
+		}
+	private:
+		impl_t m_impl;
+	};
+
+	extern stdx::connection_pool make_connection_pool(const stdx::network_io_service& io_service, size_t max_per_host = STDX_POOL_MAX_PER_HOST, uint64_t idle_timeout_ms = STDX_POOL_IDLE_TIMEOUT);
+}
@@ -4,7 +4,10 @@
 #include <stdx/datetime.h>
 #include <unordered_map>
 #include <stdx/nullable.h>
+#include <stdx/buffer.h>
+#include <stdx/async/task.h>
 #include <vector>
+#include <atomic>
 namespace stdx
 {
 	enum class http_method
@@ -29,6 +32,9 @@ namespace stdx
 
 	extern stdx::string http_version_string(stdx::http_version version);
 
+	//返回静态的UTF-8字符串,不分配内存
+	extern const char* http_u8_version_string(stdx::http_version version);
+
 	extern stdx::http_version make_http_version_by_string(const stdx::string &str);
 
 	extern stdx::string http_method_string(stdx::http_method method);
@@ -56,6 +62,22 @@ namespace stdx
 
 	extern stdx::string http_status_message(stdx::http_status_code_t code);
 
+	//返回静态的UTF-8字符串,不分配内存
+	extern const char* http_u8_status_message(stdx::http_status_code_t code);
+
+	//预先生成的状态行(包含CRLF),状态码不在[100,600)时返回nullptr
+	extern const char* http_status_line(stdx::http_version version, stdx::http_status_code_t code, size_t& size);
+
+	//当前时间的Date头部值(IMF-fixdate),每个线程每秒最多格式化一次
+	//返回的指针在当前线程下次调用前有效
+	extern const char* http_date_value();
+
+	//把time格式化为IMF-fixdate,buf至少30字节,返回长度(29)
+	extern size_t http_format_date(time_t time, char* buf);
+
+	//解析IMF-fixdate,格式错误时返回false
+	extern bool http_parse_date(const std::string& value, time_t& time);
+
 	using http_max_age_t = uint64_t;
 
 	struct http_cookie
@@ -175,6 +197,15 @@ namespace stdx
 		void set_cache_type(stdx::http_cache_control_type type);
 	};
 
+	//解析器记录的头部字段在原始头部中的位置
+	struct http_raw_field
+	{
+		size_t name_offset;
+		size_t name_size;
+		size_t value_offset;
+		size_t value_size;
+	};
+
 	struct http_header
 	{
 		using map_t = std::unordered_map<stdx::string, stdx::string>;
@@ -197,6 +228,9 @@ namespace stdx
 
 		virtual stdx::string to_string() const;
 
+		//以UTF-8直接写入输出缓存区,不包含结束的空行
+		virtual void serialize_into(stdx::output_buffer& out) const;
+
 		const stdx::http_version &version() const;
 
 		stdx::http_version& version();
@@ -239,9 +273,30 @@ namespace stdx
 		const_iterator_t cend();
 
 		bool is_keepalive() const;
+
+		//使用解析器记录的字段位置,访问头部时才转换为stdx::string
+		void assign_raw(const std::shared_ptr<std::string>& raw, std::vector<stdx::http_raw_field>&& fields);
+
+		//按名称(不区分大小写)查找UTF-8值,不会转换整个头部
+		bool raw_value(const std::string& name, std::string& value) const;
+	protected:
+		//可以在多个线程中同时调用,只有一个线程执行转换,其他线程等待转换完成
+		void _Materialize() const;
+
+		virtual void _AddRawHeader(stdx::string&& name, stdx::string&& value) const;
 	private:
+		enum raw_state
+		{
+			raw_none = 0,		//没有待转换的原始头部
+			raw_pending = 1,	//等待转换
+			raw_converting = 2	//正在转换
+		};
 		stdx::http_version m_version;
-		map_t m_headers;
+		mutable map_t m_headers;
+		//转换后仍然保留,转换期间raw_value可以继续读取
+		std::shared_ptr<std::string> m_raw;
+		std::vector<stdx::http_raw_field> m_raw_fields;
+		mutable std::atomic<int> m_raw_state;
 	};
 
 	struct http_request_header:public stdx::http_header
@@ -271,6 +326,8 @@ namespace stdx
 
 		virtual stdx::string to_string() const override;
 
+		virtual void serialize_into(stdx::output_buffer& out) const override;
+
 		stdx::http_method& method();
 		const stdx::http_method& method() const;
 
@@ -281,10 +338,12 @@ namespace stdx
 		const std::list<stdx::http_cookie>& cookies()const;
 
 		static stdx::http_request_header from_string(const stdx::string& str);
+	protected:
+		virtual void _AddRawHeader(stdx::string&& name, stdx::string&& value) const override;
 	private:
 		stdx::http_method m_method;
 		stdx::string m_request_url;
-		std::list<stdx::http_cookie> m_cookies;
+		mutable std::list<stdx::http_cookie> m_cookies;
 	};
 
 	struct http_response_header:public stdx::http_header
@@ -310,6 +369,8 @@ namespace stdx
 
 		virtual stdx::string to_string() const override;
 
+		virtual void serialize_into(stdx::output_buffer& out) const override;
+
 		stdx::http_status_code_t& status_code();
 		const stdx::http_status_code_t& status_code() const;
 
@@ -331,6 +392,9 @@ namespace stdx
 		virtual ~http_body() = default;
 		virtual std::vector<byte_t> to_bytes() const = 0;
 		virtual bool empty() const = 0;
+
+		//默认通过to_bytes写入
+		virtual void serialize_into(stdx::output_buffer& out) const;
 	};
 
 	struct http_parameter
@@ -747,11 +811,86 @@ namespace stdx
 
 	using http_form_ptr = std::shared_ptr<stdx::http_form>;
 
+	//不小于该大小的请求体片段在发送时直接引用,不复制
+#ifndef STDX_HTTP_BODY_REF_SIZE
+#define STDX_HTTP_BODY_REF_SIZE 4096
+#endif
+
+	//由引用计数的buffer片段组成的请求体存储
+	//片段可以直接引用外部的buffer,发送时作为聚集发送的一部分,需要连续数据时才合并(结果会缓存)
+	struct http_body_rope
+	{
+		using self_t = stdx::http_body_rope;
+		using byte_t = unsigned char;
+	public:
+		http_body_rope();
+
+		http_body_rope(const self_t& other);
+
+		http_body_rope(self_t&& other) noexcept;
+
+		~http_body_rope() = default;
+
+		self_t& operator=(const self_t& other);
+
+		self_t& operator=(self_t&& other) noexcept;
+
+		//复制到最后一个片段的末尾
+		void append(const byte_t* data, size_t size);
+
+		//复制为新的片段
+		void push(const byte_t* data, size_t size);
+
+		//引用为新的片段,之后不能修改视图中的数据
+		void push(const stdx::buffer_view& view);
+
+		//移除最后一个片段
+		void pop();
+
+		size_t size() const
+		{
+			return m_size;
+		}
+
+		bool empty() const
+		{
+			return m_size == 0;
+		}
+
+		const std::vector<stdx::buffer_view>& segments() const
+		{
+			return m_segments;
+		}
+
+		//合并后的数据,在下次修改前有效
+		const std::vector<byte_t>& flatten() const;
+
+		std::string to_u8_string() const;
+
+		//大片段直接引用
+		void serialize_segment(stdx::output_buffer& out, const stdx::buffer_view& segment) const;
+	private:
+		std::vector<stdx::buffer_view> m_segments;
+		size_t m_size;
+		//最后一个片段由自己分配,可以在末尾继续写入
+		bool m_tail_writable;
+		mutable std::vector<byte_t> m_flat;
+		mutable bool m_flat_valid;
+
+		void _Changed();
+	};
+
 	struct http_response_body:public stdx::http_body
 	{
 	public:
 		virtual ~http_response_body() = default;
 
+		//默认复制数据,http_identity_body和http_chunk_body直接引用
+		virtual void push(const stdx::buffer_view& view)
+		{
+			push((const byte_t*)view.data(), view.size);
+		}
+
 		virtual std::vector<byte_t> data() const = 0;
 
 		virtual stdx::string data_as_string() const = 0;
@@ -791,6 +930,11 @@ namespace stdx
 
 		virtual std::vector<byte_t> to_bytes() const override;
 
+		virtual void serialize_into(stdx::output_buffer& out) const override;
+
+		//请求体的字节数,不复制数据
+		size_t size() const;
+
 		virtual bool empty() const override;
 
 		virtual std::vector<byte_t> data() const override;
@@ -801,6 +945,8 @@ namespace stdx
 
 		virtual void push(const std::vector<byte_t>& buffer) override;
 
+		virtual void push(const stdx::buffer_view& view) override;
+
 		virtual void pop() override;
 
 		virtual stdx::string body_type() const override;
@@ -808,8 +954,13 @@ namespace stdx
 		stdx::string& body_type();
 
 		virtual void push(const stdx::string& str) override;
+
+		const std::vector<stdx::buffer_view>& segments() const
+		{
+			return m_data.segments();
+		}
 	private:
-		std::list<std::vector<byte_t>> m_data;
+		stdx::http_body_rope m_data;
 		stdx::string m_body_type;
 	};
 
@@ -841,6 +992,8 @@ namespace stdx
 
 		virtual std::vector<byte_t> to_bytes() const override;
 
+		virtual void serialize_into(stdx::output_buffer& out) const override;
+
 		virtual bool empty() const override;
 
 		virtual std::vector<byte_t> data() const override;
@@ -851,10 +1004,19 @@ namespace stdx
 
 		virtual void push(const std::vector<byte_t>& buffer) override;
 
+		//作为一个块,不复制
+		virtual void push(const stdx::buffer_view& view) override;
+
 		virtual void pop() override;
 
 		stdx::string& trailer() const;
 
+		//每个片段是一个块
+		const std::vector<stdx::buffer_view>& segments() const
+		{
+			return m_data.segments();
+		}
+
 		virtual stdx::string body_type() const override
 		{
 			return U("chunked");
@@ -862,7 +1024,7 @@ namespace stdx
 
 		virtual void push(const stdx::string& str) override;
 	private:
-		std::list<std::vector<byte_t>> m_data;
+		stdx::http_body_rope m_data;
 		mutable stdx::string m_trailer;
 	};
 
@@ -875,6 +1037,9 @@ namespace stdx
 
 		virtual std::vector<byte_t> to_bytes() const;
 
+		//写入输出缓存区,避免生成中间的字符串和字节数组
+		virtual void serialize_into(stdx::output_buffer& out) const;
+
 		virtual stdx::http_header& header() = 0;
 
 		virtual const stdx::http_header& header() const = 0;
@@ -886,6 +1051,17 @@ namespace stdx
 
 	using http_msg_ptr = std::shared_ptr<stdx::http_msg>;
 
+	//流式请求体,由连接实现
+	INTERFACE_CLASS http_body_reader
+	{
+		INTERFACE_CLASS_HELPER(http_body_reader);
+
+		//size为0表示请求体已读完
+		virtual stdx::task<stdx::buffer_view> read_chunk() = 0;
+	};
+
+	using http_body_reader_ptr = std::shared_ptr<stdx::http_body_reader>;
+
 	class http_request:public http_msg
 	{
 		using header_t = std::shared_ptr<stdx::http_request_header>;
@@ -974,6 +1150,8 @@ namespace stdx
 
 		virtual std::vector<byte_t> to_bytes() const override;
 
+		virtual void serialize_into(stdx::output_buffer& out) const override;
+
 		static stdx::http_request from_bytes(const std::vector<unsigned char> &bytes);
 
 		static stdx::http_request from_bytes(const std::string& bytes);
@@ -982,9 +1160,31 @@ namespace stdx
 		{
 			return m_form && m_header;
 		}
+
+		//流式请求体模式下,form为空,请求体通过read_body_chunk读取
+		bool is_body_streaming() const
+		{
+			return (bool)m_body_reader;
+		}
+
+		stdx::task<stdx::buffer_view> read_body_chunk();
+
+		void set_body_reader(const stdx::http_body_reader_ptr& reader)
+		{
+			m_body_reader = reader;
+		}
+
+		const stdx::http_body_reader_ptr& body_reader() const
+		{
+			return m_body_reader;
+		}
 	private:
 		mutable header_t m_header;
 		body_t m_form;
+		stdx::http_body_reader_ptr m_body_reader;
+
+		//补充Content-Type和Content-Length
+		void _PrepareHeader(size_t body_size) const;
 	};
 
 	extern stdx::http_urlencoded_form make_http_urlencoded_form(const std::vector<unsigned char>& bytes);
@@ -1079,6 +1279,8 @@ namespace stdx
 
 		virtual std::vector<byte_t> to_bytes() const override;
 
+		virtual void serialize_into(stdx::output_buffer& out) const override;
+
 		virtual stdx::http_header& header() override;
 
 		virtual const stdx::http_header& header() const override;
@@ -1098,5 +1300,14 @@ namespace stdx
 	private:
 		mutable header_t m_header;
 		body_t m_body;
+
+		//补充Content-Length或Transfer-Encoding
+		void _PrepareHeader(size_t body_size) const;
+
+		//chunked响应把Trailer指定的头部移到尾部
+		void _PrepareTrailer() const;
+
+		//写入头部和结束的空行,自动生成的头部使用预先生成的片段
+		void _SerializeHeader(stdx::output_buffer& out, size_t body_size) const;
 	};
 }
\ No newline at end of file
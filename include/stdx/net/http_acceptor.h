@@ -11,14 +11,21 @@ namespace stdx
 		using base_t = stdx::basic_socket_acceptor<stdx::http_request, stdx::http_response>;
 		using connection_t = typename base_t::connection_t;
 	public:
-		basic_http_acceptor(stdx::socket sock,size_t max_size);
+		basic_http_acceptor(stdx::socket sock,size_t max_size,bool stream_body = false);
+
+		basic_http_acceptor(std::vector<stdx::socket> socks,size_t max_size,bool stream_body = false);
 
 		virtual ~basic_http_acceptor() =default;
 	protected:
 		virtual connection_t make_connection(stdx::socket sock) override;
 	private:
 		size_t m_max_size;
+		bool m_stream_body;
 	};
 
-	extern stdx::http_acceptor make_http_acceptor(stdx::network_io_service io_service, stdx::ipv4_addr addr,size_t max_size);
+	//stream_body为true时请求体不受max_size限制,由处理函数按块读取
+	extern stdx::http_acceptor make_http_acceptor(stdx::network_io_service io_service, stdx::socket_addr addr,size_t max_size,bool stream_body = false);
+
+	//每个事件循环一个监听socket(SO_REUSEPORT),num为0时使用事件循环的数量
+	extern stdx::http_acceptor make_reuse_port_http_acceptor(stdx::network_io_service io_service, stdx::socket_addr addr, size_t max_size, size_t num = 0, bool stream_body = false);
 }
\ No newline at end of file
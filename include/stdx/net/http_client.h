@@ -0,0 +1,103 @@
+#pragma once
+#include <stdx/net/connection_pool.h>
+#include <stdx/net/http_connection.h>
+
+//响应头和响应体的大小上限
+#ifndef STDX_HTTP_CLIENT_MAX_SIZE
+#define STDX_HTTP_CLIENT_MAX_SIZE 8*1024*1024
+#endif
+
+//读取响应使用的接收缓冲区大小
+#ifndef STDX_HTTP_CLIENT_RECV_SIZE
+#define STDX_HTTP_CLIENT_RECV_SIZE 16384
+#endif
+
+namespace stdx
+{
+	//通过连接池复用keep-alive连接发送请求
+	//每个连接同一时间只有一个请求,响应读完后归还连接
+	class _HttpClient:public std::enable_shared_from_this<stdx::_HttpClient>
+	{
+		using self_t = stdx::_HttpClient;
+	public:
+		_HttpClient(const stdx::connection_pool& pool, uint64_t max_size);
+
+		~_HttpClient() = default;
+
+		DELETE_COPY(_HttpClient);
+
+		DELETE_MOVE(_HttpClient);
+
+		//没有Host时使用addr补充
+		stdx::task<stdx::http_response> send(const stdx::socket_addr& addr, const stdx::http_request& req);
+
+		void close();
+	private:
+		stdx::connection_pool m_pool;
+		uint64_t m_max_size;
+
+		void _Read(const stdx::socket_addr& addr, stdx::socket sock, stdx::http_response_parser parser, stdx::buffer buf, bool keepalive, stdx::task_completion_event<stdx::http_response> ce);
+	};
+
+	class http_client
+	{
+		using impl_t = std::shared_ptr<stdx::_HttpClient>;
+		using self_t = stdx::http_client;
+	public:
+		http_client()
+			:m_impl(nullptr)
+		{}
+
+		http_client(const impl_t& impl)
+			:m_impl(impl)
+		{}
+
+		http_client(const self_t& other)
+			:m_impl(other.m_impl)
+		{}
+
+		http_client(self_t&& other) noexcept
+			:m_impl(std::move(other.m_impl))
+		{}
+
+		~http_client() = default;
+
+		self_t& operator=(const self_t& other)
+		{
+			m_impl = other.m_impl;
+			return *this;
+		}
+
+		self_t& operator=(self_t&& other) noexcept
+		{
+			m_impl = std::move(other.m_impl);
+			return *this;
+		}
+
+		bool operator==(const self_t& other) const
+		{
+			return m_impl == other.m_impl;
+		}
+
+		operator bool() const
+		{
+			return (bool)m_impl;
+		}
+
+		stdx::task<stdx::http_response> send(const stdx::socket_addr& addr, const stdx::http_request& req)
+		{
+			return m_impl->send(addr, req);
+		}
+
+		void close()
+		{
+			return m_impl->close();
+		}
+	private:
+		impl_t m_impl;
+	};
+
+	extern stdx::http_client make_http_client(const stdx::connection_pool& pool, uint64_t max_size = STDX_HTTP_CLIENT_MAX_SIZE);
+
+	extern stdx::http_client make_http_client(const stdx::network_io_service& io_service, uint64_t max_size = STDX_HTTP_CLIENT_MAX_SIZE, size_t max_per_host = STDX_POOL_MAX_PER_HOST, uint64_t idle_timeout_ms = STDX_POOL_IDLE_TIMEOUT);
+}
@@ -1,18 +1,78 @@
 #pragma once
 #include <stdx/net/socket_connection.h>
 #include <stdx/net/http_parser.h>
+#include <stdx/async/timer.h>
+#include <atomic>
+
+//序列化响应的输出块大小,大多数响应只需要一块
+#ifndef STDX_HTTP_OUTPUT_BLOCK_SIZE
+#define STDX_HTTP_OUTPUT_BLOCK_SIZE 4096
+#endif
+
+//流式请求体超过该时间(毫秒)没有被读取时丢弃,然后继续读取下一个请求
+#ifndef STDX_HTTP_BODY_IDLE_TIMEOUT
+#define STDX_HTTP_BODY_IDLE_TIMEOUT 30000
+#endif
 
 namespace stdx
 {
 	using http_connection = stdx::connection<stdx::http_request,stdx::http_response>;
 
-	using http_client = stdx::connection<stdx::http_response, stdx::http_request>;
+	//按需从socket读取流式请求体,读完、析构或被丢弃时完成wait_done
+	class _HttpBodyReader:public stdx::http_body_reader,public std::enable_shared_from_this<stdx::_HttpBodyReader>
+	{
+		using self_t = stdx::_HttpBodyReader;
+		enum body_state
+		{
+			idle = 0,
+			reading = 1,
+			done = 2,
+			discarded = 3
+		};
+	public:
+		_HttpBodyReader(const stdx::http_request_parser& parser, const stdx::socket& sock, const stdx::buffer& buf, uint64_t id);
+
+		~_HttpBodyReader();
+
+		DELETE_COPY(_HttpBodyReader);
+
+		DELETE_MOVE(_HttpBodyReader);
+
+		//请求体读完后返回空视图
+		virtual stdx::task<stdx::buffer_view> read_chunk() override;
+
+		stdx::task<void> wait_done();
+
+		//没有正在进行的读取且空闲超过idle_ms时丢弃请求体
+		//已完成(包括本次丢弃)时返回true
+		bool discard_if_idle(uint64_t now, uint64_t idle_ms);
+
+		//由连接在等待请求体时调用,到期检查空闲,仍在读取时重新计时
+		void watch_idle(uint64_t idle_ms);
+	private:
+		stdx::http_request_parser m_parser;
+		stdx::socket m_socket;
+		stdx::buffer m_buf;
+		uint64_t m_id;
+		std::atomic<int> m_state;
+		std::atomic<uint64_t> m_active_tick;
+		stdx::task_completion_event<void> m_done_event;
+		stdx::spin_lock m_timer_lock;
+		stdx::timer m_idle_timer;
+
+		bool _Current() const;
+
+		void _Read(stdx::task_completion_event<stdx::buffer_view> ce);
+
+		void _Done();
+	};
 
 	class basic_http_connection:public stdx::basic_socket_connection<stdx::http_request,stdx::http_response>
 	{
 		using base_t = stdx::basic_socket_connection<stdx::http_request, stdx::http_response>;
 	public:
-		basic_http_connection(const stdx::socket &sock,uint64_t max_size);
+		//stream_body为true时请求体不缓冲,通过http_request::read_body_chunk读取
+		basic_http_connection(const stdx::socket &sock,uint64_t max_size,bool stream_body = false);
 
 		virtual ~basic_http_connection() = default;
 
@@ -25,8 +85,11 @@ namespace stdx
 		stdx::http_request_parser m_parser;
 	private:
 		void _Read(std::function<void(stdx::http_request,std::exception_ptr)> callback);
+
+		//取出请求,流式请求体附加读取器
+		stdx::http_request _Pop();
 		stdx::buffer m_read_buf;
 	};
 
-	extern stdx::http_connection make_http_connection(const stdx::socket &sock,uint64_t max_size);
+	extern stdx::http_connection make_http_connection(const stdx::socket &sock,uint64_t max_size,bool stream_body = false);
 }
\ No newline at end of file
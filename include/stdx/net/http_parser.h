@@ -9,19 +9,143 @@ namespace stdx
 	{
 		wait_header,
 		wait_body,
+		stream_body,
+		chunked_body,
+		until_close,
 		finish,
 		error
 	};
 
+	enum class http_header_scan_state
+	{
+		method,
+		url,
+		version,
+		line_lf,
+		field_start,
+		name,
+		value_start,
+		value,
+		value_lf,
+		end_lf,
+		done,
+		error
+	};
+
+	//逐字节扫描请求头,可在任意位置中断并在收到更多数据后继续
+	//只记录各部分在头部缓冲区中的位置,不复制
+	//status_line为true时扫描响应头:method为版本,url为状态码,version为原因短语
+	struct http_header_scanner
+	{
+		http_header_scanner()
+			:status_line(false)
+			,state(stdx::http_header_scan_state::method)
+			,method_end(0)
+			,url_begin(0)
+			,url_end(0)
+			,version_begin(0)
+			,version_end(0)
+			,value_end(0)
+			,field()
+			,fields()
+		{}
+
+		bool status_line;
+		stdx::http_header_scan_state state;
+		size_t method_end;
+		size_t url_begin;
+		size_t url_end;
+		size_t version_begin;
+		size_t version_end;
+		//当前值去掉尾部空白后的结束位置
+		size_t value_end;
+		stdx::http_raw_field field;
+		std::vector<stdx::http_raw_field> fields;
+
+		//base为data[0]在头部缓冲区中的位置,返回消耗的字节数
+		//返回后state为done表示头部结束,为error表示格式错误
+		size_t scan(const char* data, size_t size, size_t base);
+
+		//status_line保持不变
+		void reset();
+	};
+
+	enum class http_chunk_decode_state
+	{
+		size,
+		extension,
+		size_lf,
+		data,
+		data_cr,
+		data_lf,
+		trailer_start,
+		trailer,
+		end_lf,
+		done,
+		error
+	};
+
+	//增量解码Transfer-Encoding: chunked
+	//块数据不复制,由调用者从返回的位置取出
+	struct http_chunk_decoder
+	{
+		http_chunk_decoder()
+			:state(stdx::http_chunk_decode_state::size)
+			,chunk_size(0)
+			,chunk_remain(0)
+			,size_digits(0)
+			,total(0)
+			,trailer_size(0)
+			,max_chunk_size(0)
+			,max_total(0)
+			,max_trailer_size(0)
+		{}
+
+		stdx::http_chunk_decode_state state;
+		uint64_t chunk_size;
+		uint64_t chunk_remain;
+		size_t size_digits;
+		//已解码的请求体大小
+		uint64_t total;
+		size_t trailer_size;
+		//为0表示不限制
+		uint64_t max_chunk_size;
+		uint64_t max_total;
+		size_t max_trailer_size;
+
+		//返回消耗的字节数,其中[body,body+body_size)为块数据
+		//每次最多返回一段块数据;返回后state为done表示请求体结束,为error表示格式错误或超出限制
+		size_t decode(const char* data, size_t size, const char*& body, size_t& body_size);
+
+		//限制保持不变
+		void reset();
+	};
+
 	struct http_request_parser_model
 	{
 		stdx::http_parser_state state;
 		std::list<stdx::http_request> requests;
 		std::string header_buffer;
+		stdx::http_header_scanner scanner;
 		std::string body_buffer;
 		std::string arg;
+		//arg中已消耗的字节数
+		size_t arg_pos = 0;
 		std::shared_ptr<stdx::http_request_header> header;
 		uint64_t max_size = 8*1024*1024;
+		//流式请求体:头部完成后立即输出请求,请求体按块取出,不受max_size限制
+		bool stream_body = false;
+		//丢弃当前流式请求体的剩余部分
+		bool discard_body = false;
+		uint64_t body_remain = 0;
+		//当前流式请求体的编号,从1开始
+		uint64_t body_id = 0;
+		std::list<stdx::buffer_view> body_chunks;
+		//与requests对应,0表示请求体不是流式的
+		std::list<uint64_t> request_body_ids;
+		//流式请求体的总大小上限,0表示不限制
+		uint64_t max_stream_size = 0;
+		stdx::http_chunk_decoder chunk_decoder;
 	};
 
 	using http_request_parser_state_machine = stdx::state_machine<stdx::http_request_parser_model>;
@@ -52,8 +176,21 @@ namespace stdx
 
 		void _CheckArg() const;
 
+		//arg中未消耗的数据
+		const char* _ArgData() const;
+
+		size_t _ArgSize() const;
+
+		void _Consume(size_t size);
+
+		//开始解析下一个请求
+		stdx::http_request_parser_state_machine _NextRequest();
+
 		uint64_t _GetBodySize() const;
 
+		//Transfer-Encoding为chunked时返回true,不支持的编码抛出invalid_argument
+		bool _IsChunked() const;
+
 		stdx::http_form_ptr _MakeForm();
 
 		std::shared_ptr<stdx::http_request_header> _MakeHeader();
@@ -61,6 +198,9 @@ namespace stdx
 		void _FinishParse(const stdx::http_form_ptr &form);
 
 		void _FinishParse();
+
+		//流式请求体:先输出只有头部的请求
+		void _StreamParse();
 	};
 
 	class _HttpRequestParserWaitHeaderState:public stdx::_HttpRequestParserState
@@ -87,6 +227,30 @@ namespace stdx
 
 	};
 
+	class _HttpRequestParserStreamBodyState:public stdx::_HttpRequestParserState
+	{
+		using base_t = stdx::_HttpRequestParserState;
+	public:
+		_HttpRequestParserStreamBodyState(const model_ptr_t model);
+		~_HttpRequestParserStreamBodyState() = default;
+
+		virtual stdx::http_request_parser_state_machine move_next() override;
+	private:
+
+	};
+
+	class _HttpRequestParserChunkedBodyState:public stdx::_HttpRequestParserState
+	{
+		using base_t = stdx::_HttpRequestParserState;
+	public:
+		_HttpRequestParserChunkedBodyState(const model_ptr_t model);
+		~_HttpRequestParserChunkedBodyState() = default;
+
+		virtual stdx::http_request_parser_state_machine move_next() override;
+	private:
+
+	};
+
 	class _HttpRequestParserFinishState:public stdx::_HttpRequestParserState
 	{
 		using base_t = stdx::_HttpRequestParserState;
@@ -97,6 +261,9 @@ namespace stdx
 		virtual stdx::http_request_parser_state_machine move_next() override;
 
 		virtual bool is_end() const override;
+
+		//请求体块取完之前不解析下一个请求
+		virtual bool movable() const override;
 	private:
 
 	};
@@ -142,9 +309,231 @@ namespace stdx
 		bool operator==(const self_t& other);
 
 		operator bool() const;
+
+		void set_stream_body(bool enable);
+
+		//流式请求体的总大小上限,0表示不限制
+		void set_max_stream_size(uint64_t size);
+
+		//下一个请求的流式请求体编号,0表示不是流式的
+		uint64_t front_body_id() const;
+
+		//当前流式请求体的编号
+		uint64_t body_id() const;
+
+		//当前流式请求体还有数据未取出
+		bool body_streaming() const;
+
+		bool body_chunk_ready() const;
+
+		stdx::buffer_view pop_body_chunk();
+
+		//丢弃当前流式请求体的剩余部分
+		void skip_body();
 	private:
 		std::shared_ptr<stdx::http_request_parser_model> m_model;
-		stdx::http_request_parser_state_machine m_state_machine;
+		//副本共享同一个状态机
+		std::shared_ptr<stdx::http_request_parser_state_machine> m_state_machine;
+
+		void _Run();
+
+		bool _InStreamBody() const;
+	};
+
+	struct http_response_parser_model
+	{
+		stdx::http_parser_state state;
+		std::list<stdx::http_response> responses;
+		std::string header_buffer;
+		stdx::http_header_scanner scanner;
+		std::string arg;
+		//arg中已消耗的字节数
+		size_t arg_pos = 0;
+		std::shared_ptr<stdx::http_response_header> header;
+		stdx::http_response_body_ptr body;
+		uint64_t max_size = 8*1024*1024;
+		uint64_t body_remain = 0;
+		//以连接关闭结束时已收到的响应体大小
+		uint64_t body_size = 0;
+		//已发送请求的方法,与响应按顺序对应
+		std::list<stdx::http_method> methods;
+		//连接已关闭,以连接关闭结束的响应体完成
+		bool closed = false;
+		stdx::http_chunk_decoder chunk_decoder;
+	};
+
+	using http_response_parser_state_machine = stdx::state_machine<stdx::http_response_parser_model>;
+
+	class _HttpResponseParserState:public stdx::basic_state_machine<stdx::http_response_parser_model>
+	{
+	protected:
+		using model_t = stdx::http_response_parser_model;
+		using model_ptr_t = std::shared_ptr<model_t>;
+	private:
+		using base_t = stdx::basic_state_machine<stdx::http_response_parser_model>;
+	public:
+		_HttpResponseParserState(const model_ptr_t model);
+
+		virtual ~_HttpResponseParserState() = default;
+
+		virtual model_t& state() override;
+
+		virtual const model_t& state() const override;
+
+		virtual stdx::http_response_parser_state_machine reset() override;
+
+		virtual bool is_end() const override;
+
+		virtual bool movable() const override;
+	protected:
+		model_ptr_t m_model;
+
+		void _CheckArg() const;
+
+		const char* _ArgData() const;
+
+		size_t _ArgSize() const;
+
+		void _Consume(size_t size);
+
+		stdx::http_response_parser_state_machine _NextResponse();
+
+		std::shared_ptr<stdx::http_response_header> _MakeHeader();
+
+		//响应体按收到的片段保存,不合并
+		void _PushBody(const char* data, size_t size);
+
+		void _FinishParse();
+
+		stdx::http_response_parser_state_machine _Error();
+	};
+
+	class _HttpResponseParserWaitHeaderState:public stdx::_HttpResponseParserState
+	{
+		using base_t = stdx::_HttpResponseParserState;
+	public:
+		_HttpResponseParserWaitHeaderState(const model_ptr_t model);
+		~_HttpResponseParserWaitHeaderState() = default;
+
+		virtual stdx::http_response_parser_state_machine move_next() override;
+	private:
+
+	};
+
+	class _HttpResponseParserWaitBodyState:public stdx::_HttpResponseParserState
+	{
+		using base_t = stdx::_HttpResponseParserState;
+	public:
+		_HttpResponseParserWaitBodyState(const model_ptr_t model);
+		~_HttpResponseParserWaitBodyState() = default;
+
+		virtual stdx::http_response_parser_state_machine move_next() override;
+	private:
+
+	};
+
+	class _HttpResponseParserChunkedBodyState:public stdx::_HttpResponseParserState
+	{
+		using base_t = stdx::_HttpResponseParserState;
+	public:
+		_HttpResponseParserChunkedBodyState(const model_ptr_t model);
+		~_HttpResponseParserChunkedBodyState() = default;
+
+		virtual stdx::http_response_parser_state_machine move_next() override;
+	private:
+
+	};
+
+	//没有Content-Length和chunked时,响应体到连接关闭为止
+	class _HttpResponseParserUntilCloseState:public stdx::_HttpResponseParserState
+	{
+		using base_t = stdx::_HttpResponseParserState;
+	public:
+		_HttpResponseParserUntilCloseState(const model_ptr_t model);
+		~_HttpResponseParserUntilCloseState() = default;
+
+		virtual stdx::http_response_parser_state_machine move_next() override;
+
+		virtual bool movable() const override;
+	private:
+
+	};
+
+	class _HttpResponseParserFinishState:public stdx::_HttpResponseParserState
+	{
+		using base_t = stdx::_HttpResponseParserState;
+	public:
+		_HttpResponseParserFinishState(const model_ptr_t model);
+		~_HttpResponseParserFinishState() = default;
+
+		virtual stdx::http_response_parser_state_machine move_next() override;
+
+		virtual bool is_end() const override;
+	private:
+
+	};
+
+	class _HttpResponseParserErrorState :public stdx::_HttpResponseParserState
+	{
+		using base_t = stdx::_HttpResponseParserState;
+	public:
+		_HttpResponseParserErrorState(const model_ptr_t model);
+		~_HttpResponseParserErrorState() = default;
+
+		virtual stdx::http_response_parser_state_machine move_next() override;
+
+		virtual bool is_end() const override;
+
+		//出错后丢弃之后的数据
+		virtual bool movable() const override;
+	private:
+
+	};
+
+	//增量解析响应,支持Content-Length、chunked和以连接关闭结束的响应体
+	//max_size限制头部和整个响应体的大小
+	class http_response_parser
+	{
+		using self_t = stdx::http_response_parser;
+	public:
+		http_response_parser(uint64_t max_size);
+
+		http_response_parser(const self_t &other);
+
+		http_response_parser(self_t&& other) noexcept;
+
+		~http_response_parser() = default;
+
+		self_t& operator=(const self_t& other);
+
+		self_t& operator=(self_t&& other) noexcept;
+
+		//发送请求前调用,HEAD请求的响应没有响应体
+		//没有记录时按GET处理
+		void expect(stdx::http_method method);
+
+		void push(stdx::buffer buf,size_t size);
+
+		//连接已关闭,完成以连接关闭结束的响应,未完成的其他响应视为错误
+		void close();
+
+		size_t finish_count() const;
+
+		bool error() const;
+
+		//没有未取出的响应,也没有解析到一半的数据
+		bool idle() const;
+
+		stdx::http_response pop();
+
+		bool operator==(const self_t& other);
+
+		operator bool() const;
+	private:
+		std::shared_ptr<stdx::http_response_parser_model> m_model;
+		std::shared_ptr<stdx::http_response_parser_state_machine> m_state_machine;
+
+		void _Run();
 	};
 
 	class parse_error:public std::logic_error
@@ -0,0 +1,28 @@
+#pragma once
+#include <stdx/env.h>
+
+//定义STDX_DISABLE_SIMD时只使用标量实现
+#ifndef STDX_DISABLE_SIMD
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define STDX_HTTP_SCAN_X86
+#endif
+#endif
+
+namespace stdx
+{
+	//返回[begin,end)中第一个小于limit或等于0x7f(DEL)的字节,没有时返回end
+	//limit为0x21时用于请求行(遇到空格、CR、LF停止),为0x20时用于头部值(遇到HTAB、CR、LF停止)
+	//运行时选择AVX2/SSE2/标量实现
+	extern const char* http_find_ctl(const char* begin, const char* end, unsigned char limit);
+
+	//当前使用的实现:"avx2","sse2"或"scalar"
+	extern const char* http_scan_kernel_name();
+
+	//RFC7230 tchar
+	extern const bool http_token_table[256];
+
+	inline bool is_http_token_char(unsigned char ch)
+	{
+		return http_token_table[ch];
+	}
+}
@@ -0,0 +1,146 @@
+#pragma once
+#include <stdx/net/http_connection.h>
+#include <stdx/async/spin_lock.h>
+#include <unordered_map>
+#include <list>
+
+//缓存的已打开文件数
+#ifndef STDX_HTTP_STATIC_CACHE_SIZE
+#define STDX_HTTP_STATIC_CACHE_SIZE 1024
+#endif
+
+//缓存的文件在该时间(毫秒)内不重新检查是否修改
+#ifndef STDX_HTTP_STATIC_REVALIDATE
+#define STDX_HTTP_STATIC_REVALIDATE 1000
+#endif
+
+namespace stdx
+{
+	//已打开的文件和由元数据生成的验证器,创建后不再修改
+	struct _HttpStaticFile
+	{
+		stdx::file_handle file;
+		uint64_t size;
+		time_t mtime;
+		uint64_t inode;
+		std::string etag;
+		std::string last_modified;
+		const char* content_type;
+	};
+
+	//在root目录下处理GET和HEAD请求
+	//文件内容通过send_file发送,支持单个Range、ETag/Last-Modified和304
+	class _HttpStaticFileHandler
+	{
+		using self_t = stdx::_HttpStaticFileHandler;
+		using lock_t = stdx::spin_lock;
+		using file_ptr_t = std::shared_ptr<stdx::_HttpStaticFile>;
+		using lru_t = std::list<std::string>;
+
+		struct cache_entry
+		{
+			file_ptr_t file;
+			uint64_t check_tick;
+			lru_t::iterator lru;
+		};
+	public:
+		_HttpStaticFileHandler(const stdx::string& root, size_t cache_size, uint64_t revalidate_ms);
+
+		~_HttpStaticFileHandler() = default;
+
+		DELETE_COPY(_HttpStaticFileHandler);
+
+		DELETE_MOVE(_HttpStaticFileHandler);
+
+		//写入响应(包括404、405等错误响应),完成时响应已发送
+		stdx::task<void> handle(stdx::http_connection conn, const stdx::http_request& req);
+
+		//关闭缓存的文件
+		void clear();
+	private:
+		std::string m_root;
+		size_t m_cache_size;
+		uint64_t m_revalidate;
+		lock_t m_lock;
+		//最近使用的在头部
+		lru_t m_lru;
+		std::unordered_map<std::string, cache_entry> m_cache;
+
+		//把请求路径映射到root下的文件,包含..时返回false
+		bool _MapPath(const stdx::string& url, std::string& path) const;
+
+		//文件不存在或不是普通文件时返回nullptr
+		file_ptr_t _Open(const std::string& path);
+
+		void _Erase(const std::string& path);
+
+		static const char* _ContentType(const std::string& path);
+
+		static bool _MatchEtag(const std::string& value, const std::string& etag);
+
+		//返回1表示使用[begin,end],0表示忽略Range,-1表示范围不能满足
+		static int _ParseRange(const std::string& value, uint64_t size, uint64_t& begin, uint64_t& end);
+
+		static stdx::task<void> _Write(stdx::http_connection conn, const stdx::http_response& res);
+	};
+
+	class http_static_file_handler
+	{
+		using impl_t = std::shared_ptr<stdx::_HttpStaticFileHandler>;
+		using self_t = stdx::http_static_file_handler;
+	public:
+		http_static_file_handler()
+			:m_impl(nullptr)
+		{}
+
+		http_static_file_handler(const impl_t& impl)
+			:m_impl(impl)
+		{}
+
+		http_static_file_handler(const self_t& other)
+			:m_impl(other.m_impl)
+		{}
+
+		http_static_file_handler(self_t&& other) noexcept
+			:m_impl(std::move(other.m_impl))
+		{}
+
+		~http_static_file_handler() = default;
+
+		self_t& operator=(const self_t& other)
+		{
+			m_impl = other.m_impl;
+			return *this;
+		}
+
+		self_t& operator=(self_t&& other) noexcept
+		{
+			m_impl = std::move(other.m_impl);
+			return *this;
+		}
+
+		bool operator==(const self_t& other) const
+		{
+			return m_impl == other.m_impl;
+		}
+
+		operator bool() const
+		{
+			return (bool)m_impl;
+		}
+
+		stdx::task<void> handle(stdx::http_connection conn, const stdx::http_request& req)
+		{
+			return m_impl->handle(conn, req);
+		}
+
+		void clear()
+		{
+			return m_impl->clear();
+		}
+	private:
+		impl_t m_impl;
+	};
+
+	extern stdx::http_static_file_handler make_http_static_file_handler(const stdx::string& root, size_t cache_size = STDX_HTTP_STATIC_CACHE_SIZE, uint64_t revalidate_ms = STDX_HTTP_STATIC_REVALIDATE);
+}
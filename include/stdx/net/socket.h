@@ -31,7 +31,29 @@
 #include <netinet/in.h>
 #include <arpa/inet.h>
 #include<sys/sendfile.h>
+#include <sys/uio.h>
+#include <sys/un.h>
 #define _STDX_HAS_SOCKET
+//recv_from_batch默认的单个数据报缓冲区大小
+#ifndef STDX_DATAGRAM_SIZE
+#define STDX_DATAGRAM_SIZE 2048
+#endif
+//单次recvmmsg/sendmmsg的数据报上限
+#ifndef STDX_DATAGRAM_BATCH
+#define STDX_DATAGRAM_BATCH 64
+#endif
+//一次可读事件最多accept的连接数
+#ifndef STDX_ACCEPT_BATCH
+#define STDX_ACCEPT_BATCH 64
+#endif
+//开启zerocopy后,不小于该大小的send使用MSG_ZEROCOPY
+#ifndef STDX_ZEROCOPY_THRESHOLD
+#define STDX_ZEROCOPY_THRESHOLD 16384
+#endif
+//send_file每轮最多发送的字节数,超过后让出事件循环
+#ifndef STDX_SENDFILE_CHUNK
+#define STDX_SENDFILE_CHUNK 1048576
+#endif
 #define _ThrowLinuxError auto _ERROR_CODE = errno;\
 						 throw std::system_error(std::error_code(_ERROR_CODE,std::system_category())); 
 #endif // LINUX
@@ -90,6 +112,9 @@ namespace stdx
 	{
 		ip = AF_INET,		//IPv4
 		ipv6 = AF_INET6		//IPv6
+#ifdef LINUX
+		,unix_domain = AF_UNIX	//Unix域
+#endif
 	};
 
 	int forward_protocol(const stdx::protocol& protocol);
@@ -304,11 +329,11 @@ namespace stdx
 		stdx::string ip() const
 		{
 #ifdef WIN32
-			wchar_t buf[39];
-			InetNtopW(stdx::forward_addr_family(stdx::addr_family::ipv6), &(m_handle.sin6_addr), buf, 39);
+			wchar_t buf[INET6_ADDRSTRLEN];
+			InetNtopW(stdx::forward_addr_family(stdx::addr_family::ipv6), &(m_handle.sin6_addr), buf, INET6_ADDRSTRLEN);
 #else
-			char buf[39];
-			inet_ntop(stdx::forward_addr_family(stdx::addr_family::ipv6), &(m_handle.sin6_addr), buf, 39);
+			char buf[INET6_ADDRSTRLEN];
+			inet_ntop(stdx::forward_addr_family(stdx::addr_family::ipv6), &(m_handle.sin6_addr), buf, INET6_ADDRSTRLEN);
 #endif
 			return stdx::string(buf);
 		}
@@ -339,8 +364,281 @@ namespace stdx
 #endif
 	};
 
+	//统一的socket地址(IPv4/IPv6/Unix域)
+	//可由ipv4_addr/ipv6_addr隐式构造
+	class socket_addr
+	{
+	public:
+#ifdef WIN32
+		using storage_t = SOCKADDR_STORAGE;
+		using length_t = int;
+#else
+		using storage_t = sockaddr_storage;
+		using length_t = socklen_t;
+#endif
+		socket_addr()
+			:m_handle()
+			,m_len(0)
+		{
+			memset(&m_handle, 0, sizeof(storage_t));
+		}
+
+		socket_addr(stdx::ipv4_addr addr)
+			:m_handle()
+			,m_len(sizeof(sockaddr_in))
+		{
+			memset(&m_handle, 0, sizeof(storage_t));
+			memcpy(&m_handle, (sockaddr*)addr, sizeof(sockaddr_in));
+		}
+
+		socket_addr(stdx::ipv6_addr addr)
+			:m_handle()
+			,m_len(sizeof(sockaddr_in6))
+		{
+			memset(&m_handle, 0, sizeof(storage_t));
+			memcpy(&m_handle, (sockaddr*)addr, sizeof(sockaddr_in6));
+		}
+
+		socket_addr(const sockaddr* addr, length_t len)
+			:m_handle()
+			,m_len(len)
+		{
+			memset(&m_handle, 0, sizeof(storage_t));
+			if (m_len > (length_t)sizeof(storage_t))
+			{
+				m_len = sizeof(storage_t);
+			}
+			memcpy(&m_handle, addr, m_len);
+		}
+
+		socket_addr(const socket_addr& other)
+			:m_handle(other.m_handle)
+			,m_len(other.m_len)
+		{}
+
+		~socket_addr() = default;
+
+		socket_addr& operator=(const socket_addr& other)
+		{
+			m_handle = other.m_handle;
+			m_len = other.m_len;
+			return *this;
+		}
+
+#ifdef LINUX
+		//Unix域地址,以'@'开头表示抽象命名空间
+		static socket_addr unix_path(const stdx::string& path)
+		{
+			socket_addr addr;
+			sockaddr_un* un = (sockaddr_un*)&addr.m_handle;
+			un->sun_family = AF_UNIX;
+			const char* str = path.c_str();
+			size_t len = 0;
+			while (str[len] != '\0')
+			{
+				len += 1;
+			}
+			if (len >= sizeof(un->sun_path))
+			{
+				throw std::invalid_argument("unix socket path is too long");
+			}
+			memcpy(un->sun_path, str, len);
+			if (len != 0 && un->sun_path[0] == '@')
+			{
+				un->sun_path[0] = '\0';
+				addr.m_len = (length_t)(offsetof(sockaddr_un, sun_path) + len);
+			}
+			else
+			{
+				addr.m_len = (length_t)(offsetof(sockaddr_un, sun_path) + len + 1);
+			}
+			return addr;
+		}
+#endif
+
+		int family() const
+		{
+			return m_handle.ss_family;
+		}
+
+		bool is_ipv4() const
+		{
+			return family() == AF_INET;
+		}
+
+		bool is_ipv6() const
+		{
+			return family() == AF_INET6;
+		}
+
+		bool is_unix() const
+		{
+#ifdef LINUX
+			return family() == AF_UNIX;
+#else
+			return false;
+#endif
+		}
+
+		operator sockaddr* ()
+		{
+			return (sockaddr*)&m_handle;
+		}
+
+		const sockaddr* data() const
+		{
+			return (const sockaddr*)&m_handle;
+		}
+
+		length_t length() const
+		{
+			return m_len;
+		}
+
+		//供accept/recvfrom等填充地址后设置长度
+		void length(length_t len)
+		{
+			m_len = len;
+		}
+
+		constexpr static length_t capacity = sizeof(storage_t);
+
+		//Unix域地址返回0
+		uint16_t port() const
+		{
+			if (is_ipv4())
+			{
+				return ntohs(((const sockaddr_in*)&m_handle)->sin_port);
+			}
+			if (is_ipv6())
+			{
+				return ntohs(((const sockaddr_in6*)&m_handle)->sin6_port);
+			}
+			return 0;
+		}
+
+		stdx::string ip() const
+		{
+			if (is_ipv4())
+			{
+				return to_ipv4().ip();
+			}
+			if (is_ipv6())
+			{
+				return to_ipv6().ip();
+			}
+			return stdx::string();
+		}
+
+#ifdef LINUX
+		stdx::string path() const
+		{
+			if (!is_unix() || m_len <= (length_t)offsetof(sockaddr_un, sun_path))
+			{
+				return stdx::string();
+			}
+			const sockaddr_un* un = (const sockaddr_un*)&m_handle;
+			size_t len = m_len - offsetof(sockaddr_un, sun_path);
+			if (un->sun_path[0] == '\0')
+			{
+				std::string abstract_path(un->sun_path, len);
+				abstract_path[0] = '@';
+				return stdx::string(abstract_path.c_str());
+			}
+			size_t n = 0;
+			while (n < len && un->sun_path[n] != '\0')
+			{
+				n += 1;
+			}
+			len = n;
+			return stdx::string(std::string(un->sun_path, len).c_str());
+		}
+#endif
+
+		//IPv4映射的IPv6地址(双栈监听)也会转换为IPv4
+		stdx::ipv4_addr to_ipv4() const
+		{
+			if (is_ipv6())
+			{
+				const sockaddr_in6* addr6 = (const sockaddr_in6*)&m_handle;
+				if (IN6_IS_ADDR_V4MAPPED(&addr6->sin6_addr))
+				{
+					sockaddr_in addr;
+					memset(&addr, 0, sizeof(sockaddr_in));
+					addr.sin_family = AF_INET;
+					addr.sin_port = addr6->sin6_port;
+					memcpy(&addr.sin_addr, ((const char*)&addr6->sin6_addr) + 12, 4);
+					return stdx::ipv4_addr(addr);
+				}
+			}
+			if (!is_ipv4())
+			{
+				return stdx::ipv4_addr();
+			}
+			sockaddr_in addr;
+			memcpy(&addr, &m_handle, sizeof(sockaddr_in));
+			return stdx::ipv4_addr(addr);
+		}
+
+		stdx::ipv6_addr to_ipv6() const
+		{
+			if (!is_ipv6())
+			{
+				return stdx::ipv6_addr();
+			}
+			sockaddr_in6 addr;
+			memcpy(&addr, &m_handle, sizeof(sockaddr_in6));
+			return stdx::ipv6_addr(addr);
+		}
+
+		bool operator==(const stdx::socket_addr& other) const
+		{
+			return (m_len == other.m_len) && (memcmp(&m_handle, &other.m_handle, m_len) == 0);
+		}
+
+		bool operator!=(const stdx::socket_addr& other) const
+		{
+			return !(*this == other);
+		}
+	private:
+		storage_t m_handle;
+		length_t m_len;
+	};
+
+#ifdef LINUX
+	//MSG_ZEROCOPY通知编号,只在socket所在的事件循环中访问
+	struct zerocopy_state
+	{
+		zerocopy_state()
+			:next_id(0)
+			,done(0)
+			,pending()
+		{}
+		//下一次zerocopy发送的编号
+		uint32_t next_id;
+		//小于done的编号均已完成
+		uint32_t done;
+		//乱序到达的完成区间
+		std::vector<std::pair<uint32_t, uint32_t>> pending;
+	};
+#endif
+
+	struct network_send_event;
+	struct network_recv_event;
+	struct network_accept_event;
+
+	//每个线程缓存的空闲network_io_context数量
+#ifndef STDX_IO_CONTEXT_CACHE_SIZE
+#define STDX_IO_CONTEXT_CACHE_SIZE 256
+#endif
+
 	struct network_io_context:public stdx::stand_context
 	{
+		//从线程(事件循环)的空闲链表分配
+		static void* operator new(size_t size);
+
+		static void operator delete(void* ptr) noexcept;
+
 		network_io_context()
 			:stdx::stand_context()
 		{
@@ -348,6 +646,9 @@ namespace stdx
 			std::memset(&m_ol, 0, sizeof(OVERLAPPED));
 #else
 			is_io_operation = true;
+			is_persistent = false;
+			sock_err = 0;
+			same_loop = false;
 #endif
 		}
 
@@ -355,6 +656,8 @@ namespace stdx
 #ifndef WIN32
 		int code;
 		ssize_t err_code;
+		//accepted socket stays on the listener's loop
+		bool same_loop;
 #endif 
 #ifdef WIN32
 		SOCKET this_socket;
@@ -363,17 +666,43 @@ namespace stdx
 		int this_socket;
 		int target_socket;
 #endif
-		ipv4_addr addr;
+		stdx::socket_addr addr;
 		stdx::buffer buf;
+		//scatter/gather buffers
+		std::vector<stdx::buffer_view> bufs;
 #ifdef WIN32
 		WSABUF buffer;
+		std::vector<WSABUF> buffers;
+		//TransmitFile的前缀
+		TRANSMIT_FILE_BUFFERS transmit_buffers;
 #else
 		size_t send_size;
 		size_t send_offset;
+		//批量数据报/连接的地址(与bufs或accepted一一对应)
+		std::vector<stdx::socket_addr> addrs;
+		//accept_batch接受的连接
+		std::vector<int> accepted;
+		//MSG_ZEROCOPY:编号区间[zc_begin,zc_end)与发送阶段的错误
+		std::shared_ptr<stdx::zerocopy_state> zerocopy;
+		uint32_t zc_begin;
+		uint32_t zc_end;
+		ssize_t zc_err;
+		//send_file:文件偏移与剩余字节数(前缀使用send_offset/send_size)
+		off_t file_offset;
+		uint64_t file_remain;
+		//管道使用dup出的fd(target_socket),空管道时在该fd上等待可读
+		bool file_is_pipe;
+		//持久注册的取消标记,每次读取之前检查
+		std::shared_ptr<stdx::cancel_token> cancel;
 #endif
 		stdx::socket_size_t size;
 		
 		std::function <void(network_io_context*, std::exception_ptr)> callback;
+		//回调槽:callback不捕获状态,用户回调移入这里,避免包装带来的堆分配
+		std::function<void(network_send_event, std::exception_ptr)> send_callback;
+		std::function<void(network_recv_event, std::exception_ptr)> recv_callback;
+		std::function<void(network_accept_event, std::exception_ptr)> accept_callback;
+		std::function<void(std::exception_ptr)> done_callback;
 	};
 
 #ifdef LINUX
@@ -390,7 +719,15 @@ namespace stdx
 			sendfile = 64,
 			sendto_ipv6 = 128,
 			recvfrom_ipv6 = 256,
-			accept_ipv6 = 512
+			accept_ipv6 = 512,
+			sendv = 1024,
+			recvv = 2048,
+			recvfrom_batch = 4096,
+			sendto_batch = 8192,
+			accept_batch = 16384,
+			send_zerocopy = 32768,
+			zerocopy_wait = 65536,
+			sendfile_wait = 131072
 		};
 	};
 #endif
@@ -485,9 +822,12 @@ namespace stdx
 
 		stdx::buffer buffer;
 		size_t size;
-		stdx::ipv4_addr addr;
+		stdx::socket_addr addr;
 	};
 
+	//数据报(buffer,size,addr),收到的数据报可直接回发
+	using network_datagram = stdx::network_recv_event;
+
 	struct network_accept_event
 	{
 		network_accept_event()
@@ -525,7 +865,7 @@ namespace stdx
 #else
 		int accept;
 #endif // WIN32
-		ipv4_addr addr;
+		stdx::socket_addr addr;
 	};
 	
 	class _NetworkIOService
@@ -558,22 +898,32 @@ namespace stdx
 
 		void send_file(socket_t sock, file_handle_t file_with_cache, std::function<void(std::exception_ptr)> callback);
 
+		//发送文件的[offset,offset+length)部分,length为0表示到文件末尾
+		//prefix(如响应头)先于文件内容发送
+		void send_file(socket_t sock, file_handle_t file_with_cache, uint64_t offset, uint64_t length, stdx::buffer_view prefix, std::function<void(std::exception_ptr)> callback);
+
+		//聚集发送(sendmsg/WSASend)
+		void send(socket_t sock, std::vector<stdx::buffer_view> bufs, std::function<void(network_send_event, std::exception_ptr)> callback);
+
 		//接收数据
 		void recv(socket_t sock, stdx::buffer buf, std::function<void(network_recv_event, std::exception_ptr)> callback);
 
+		//分散接收(recvmsg/WSARecv)
+		void recv(socket_t sock, std::vector<stdx::buffer_view> bufs, std::function<void(network_recv_event, std::exception_ptr)> callback);
+
 		void listen(socket_t sock, int backlog);
 
-		void bind(socket_t sock, ipv4_addr& addr);
+		void bind(socket_t sock, const socket_addr& addr);
 
-		void send_to(socket_t sock, const ipv4_addr& addr, stdx::buffer buf, const socket_size_t& size, std::function<void(stdx::network_send_event, std::exception_ptr)> callback);
+		void send_to(socket_t sock, const socket_addr& addr, stdx::buffer buf, const socket_size_t& size, std::function<void(stdx::network_send_event, std::exception_ptr)> callback);
 
 		void recv_from(socket_t sock, stdx::buffer buf, std::function<void(network_recv_event, std::exception_ptr)> callback);
 
 		void close(socket_t sock);
 
-		ipv4_addr get_local_addr(socket_t sock) const;
+		socket_addr get_local_addr(socket_t sock) const;
 
-		ipv4_addr get_remote_addr(socket_t sock) const;
+		socket_addr get_remote_addr(socket_t sock) const;
 #ifdef WIN32
 
 		static void _GetAcceptEx(SOCKET s, LPFN_ACCEPTEX *ptr);
@@ -586,13 +936,50 @@ namespace stdx
 
 		void _SetLoopBackFastPath(socket_t s);
 #endif
-		void accept_ex(socket_t sock, std::function<void(network_accept_event, std::exception_ptr)> callback);
+		void accept_ex(socket_t sock, std::function<void(network_accept_event, std::exception_ptr)> callback, bool same_loop = false);
 
-		void connect_ex(socket_t sock,stdx::ipv4_addr addr,std::function<void(std::exception_ptr)> callback);
+		void connect_ex(socket_t sock,stdx::socket_addr addr,std::function<void(std::exception_ptr)> callback);
 
 		static const uint32_t loop_num;
 
 		void set_keepalive(socket_t sock,bool opt);
+
+		//IPV6_V6ONLY,关闭后IPv6 socket同时接受IPv4连接(双栈)
+		void set_v6only(socket_t sock, bool opt);
+
+		//非阻塞检查空闲连接:未被对端关闭且没有未读数据
+		bool is_idle_alive(socket_t sock) const;
+
+#ifdef LINUX
+		void set_reuse_port(socket_t sock, bool opt);
+
+		//将socket绑定到指定的事件循环
+		void bind_loop(socket_t sock, size_t index);
+
+		//SO_BUSY_POLL(微秒)
+		void set_busy_poll(socket_t sock, uint32_t us);
+
+		//recvmmsg,每个buffer接收一个数据报,bufs为空时立即以空结果完成
+		void recv_from_batch(socket_t sock, std::vector<stdx::buffer> bufs, std::function<void(std::vector<stdx::network_recv_event>, std::exception_ptr)> callback);
+
+		//sendmmsg,回调参数为已发送的数据报数量,datagrams为空时立即完成
+		void send_to_batch(socket_t sock, std::vector<stdx::network_datagram> datagrams, std::function<void(size_t, std::exception_ptr)> callback);
+
+		//持久接收:一次注册,每块数据回调一次,直到取消或出错
+		void recv_until(socket_t sock, stdx::buffer buf, stdx::cancel_token token, std::function<void(network_recv_event, std::exception_ptr)> callback);
+
+		//accept直到EAGAIN或达到budget,一次回调交付
+		void accept_batch(socket_t sock, size_t budget, std::function<void(std::vector<network_accept_event>, std::exception_ptr)> callback, bool same_loop = false);
+
+		//持久accept:每个可读事件交付一批连接,直到取消或出错
+		void accept_until(socket_t sock, size_t budget, stdx::cancel_token token, std::function<void(std::vector<network_accept_event>, std::exception_ptr)> callback, bool same_loop = false);
+
+		//SO_ZEROCOPY
+		void set_zerocopy(socket_t sock, bool opt);
+
+		//MSG_ZEROCOPY发送,buffer持有到内核完成通知后才回调
+		void send_zerocopy(socket_t sock, std::shared_ptr<stdx::zerocopy_state> state, stdx::buffer buf, const stdx::socket_size_t& size, std::function<void(network_send_event, std::exception_ptr)> callback);
+#endif
 #ifdef WIN32
 	public:
 		static LPFN_ACCEPTEX m_accept_ex;
@@ -610,11 +997,31 @@ namespace stdx
 		static void _SetNonBlocking(socket_t sock);
 
 		static void _SetReuseAddr(socket_t sock);
+
+		//从skip字节处开始填充iovec,返回iovec数量
+		static size_t _MakeIovec(stdx::network_io_context* context, iovec* iov, size_t max, size_t skip, size_t& bytes);
+
+		static stdx::network_io_context* _MakeAcceptBatch(socket_t sock, size_t budget, bool same_loop);
+
+		//读取错误队列中的zerocopy通知,返回[zc_begin,zc_end)是否全部完成
+		static bool _ReapZerocopy(stdx::network_io_context* context);
+
+		//从事件循环中移除send_file dup出的管道fd并关闭
+		static void _ReleaseSendFilePipe(int fd);
 #endif
 
 	private:
 		void prepare_callback(stdx::network_io_context *context);
 
+		//完成回调,依次调用对应的回调槽
+		static void _CompleteSend(stdx::network_io_context* context, std::exception_ptr error);
+
+		static void _CompleteRecv(stdx::network_io_context* context, std::exception_ptr error);
+
+		static void _CompleteAccept(stdx::network_io_context* context, std::exception_ptr error);
+
+		static void _CompleteDone(stdx::network_io_context* context, std::exception_ptr error);
+
 #ifdef WIN32
 		static DWORD recv_flag;
 #endif
@@ -665,17 +1072,32 @@ namespace stdx
 			m_impl->send_file(sock, file_with_cache, callback);
 		}
 
+		void send_file(socket_t sock, file_handle_t file_with_cache, uint64_t offset, uint64_t length, stdx::buffer_view prefix, std::function<void(std::exception_ptr)>&& callback)
+		{
+			m_impl->send_file(sock, file_with_cache, offset, length, prefix, std::move(callback));
+		}
+
+		void send(socket_t sock, std::vector<stdx::buffer_view> bufs, std::function<void(network_send_event, std::exception_ptr)>&& callback)
+		{
+			m_impl->send(sock, std::move(bufs), std::move(callback));
+		}
+
 		void recv(socket_t sock, stdx::buffer buf, std::function<void(network_recv_event, std::exception_ptr)>&& callback)
 		{
 			m_impl->recv(sock,buf, callback);
 		}
 
-		void accept_ex(socket_t sock, std::function<void(network_accept_event, std::exception_ptr)> &&callback)
+		void recv(socket_t sock, std::vector<stdx::buffer_view> bufs, std::function<void(network_recv_event, std::exception_ptr)>&& callback)
+		{
+			m_impl->recv(sock, std::move(bufs), std::move(callback));
+		}
+
+		void accept_ex(socket_t sock, std::function<void(network_accept_event, std::exception_ptr)> &&callback, bool same_loop = false)
 		{
-			return m_impl->accept_ex(sock,callback);
+			return m_impl->accept_ex(sock,callback,same_loop);
 		}
 
-		void connect_ex(socket_t sock,stdx::ipv4_addr &addr, std::function<void(std::exception_ptr)> &&callback)
+		void connect_ex(socket_t sock,const stdx::socket_addr &addr, std::function<void(std::exception_ptr)> &&callback)
 		{
 			return m_impl->connect_ex(sock,addr,callback);
 		}
@@ -685,12 +1107,12 @@ namespace stdx
 			m_impl->listen(sock, backlog);
 		}
 
-		void bind(socket_t sock, ipv4_addr& addr)
+		void bind(socket_t sock, const socket_addr& addr)
 		{
 			m_impl->bind(sock, addr);
 		}
 
-		void send_to(socket_t sock, const ipv4_addr& addr,stdx::buffer buf, const socket_size_t& size, std::function<void(stdx::network_send_event, std::exception_ptr)>&& callback)
+		void send_to(socket_t sock, const socket_addr& addr,stdx::buffer buf, const socket_size_t& size, std::function<void(stdx::network_send_event, std::exception_ptr)>&& callback)
 		{
 			m_impl->send_to(sock, addr,buf, size, std::move(callback));
 		}
@@ -705,12 +1127,12 @@ namespace stdx
 			m_impl->close(sock);
 		}
 
-		ipv4_addr get_local_addr(socket_t sock) const
+		socket_addr get_local_addr(socket_t sock) const
 		{
 			return m_impl->get_local_addr(sock);
 		}
 
-		ipv4_addr get_remote_addr(socket_t sock) const
+		socket_addr get_remote_addr(socket_t sock) const
 		{
 			return m_impl->get_remote_addr(sock);
 		}
@@ -728,6 +1150,68 @@ namespace stdx
 		{
 			return m_impl->set_keepalive(sock, opt);
 		}
+
+		bool is_idle_alive(socket_t sock) const
+		{
+			return m_impl->is_idle_alive(sock);
+		}
+
+		void set_v6only(socket_t sock, bool opt)
+		{
+			return m_impl->set_v6only(sock, opt);
+		}
+
+#ifdef LINUX
+		void set_reuse_port(socket_t sock, bool opt)
+		{
+			return m_impl->set_reuse_port(sock, opt);
+		}
+
+		void bind_loop(socket_t sock, size_t index)
+		{
+			return m_impl->bind_loop(sock, index);
+		}
+
+		void set_busy_poll(socket_t sock, uint32_t us)
+		{
+			return m_impl->set_busy_poll(sock, us);
+		}
+
+		void recv_from_batch(socket_t sock, std::vector<stdx::buffer> bufs, std::function<void(std::vector<stdx::network_recv_event>, std::exception_ptr)>&& callback)
+		{
+			m_impl->recv_from_batch(sock, std::move(bufs), std::move(callback));
+		}
+
+		void send_to_batch(socket_t sock, std::vector<stdx::network_datagram> datagrams, std::function<void(size_t, std::exception_ptr)>&& callback)
+		{
+			m_impl->send_to_batch(sock, std::move(datagrams), std::move(callback));
+		}
+
+		void recv_until(socket_t sock, stdx::buffer buf, stdx::cancel_token token, std::function<void(network_recv_event, std::exception_ptr)>&& callback)
+		{
+			m_impl->recv_until(sock, buf, token, std::move(callback));
+		}
+
+		void accept_batch(socket_t sock, size_t budget, std::function<void(std::vector<network_accept_event>, std::exception_ptr)>&& callback, bool same_loop = false)
+		{
+			m_impl->accept_batch(sock, budget, std::move(callback), same_loop);
+		}
+
+		void accept_until(socket_t sock, size_t budget, stdx::cancel_token token, std::function<void(std::vector<network_accept_event>, std::exception_ptr)>&& callback, bool same_loop = false)
+		{
+			m_impl->accept_until(sock, budget, token, std::move(callback), same_loop);
+		}
+
+		void set_zerocopy(socket_t sock, bool opt)
+		{
+			return m_impl->set_zerocopy(sock, opt);
+		}
+
+		void send_zerocopy(socket_t sock, std::shared_ptr<stdx::zerocopy_state> state, stdx::buffer buf, const stdx::socket_size_t& size, std::function<void(network_send_event, std::exception_ptr)>&& callback)
+		{
+			m_impl->send_zerocopy(sock, state, buf, size, std::move(callback));
+		}
+#endif
 	private:
 		impl_t m_impl;
 	};
@@ -756,16 +1240,22 @@ namespace stdx
 
 		stdx::task<void> send_file(file_handle_t file_handle);
 
+		stdx::task<void> send_file(file_handle_t file_handle, uint64_t offset, uint64_t length, stdx::buffer_view prefix = stdx::buffer_view());
 
-		stdx::task<stdx::network_send_event> send_to(const ipv4_addr& addr, stdx::buffer buf, const socket_size_t& size);
+
+		stdx::task<stdx::network_send_event> send_to(const socket_addr& addr, stdx::buffer buf, const socket_size_t& size);
 
 
 		stdx::task<stdx::network_recv_event> recv(stdx::buffer buf);
 
+		stdx::task<stdx::network_send_event> send(std::vector<stdx::buffer_view> bufs);
+
+		stdx::task<stdx::network_recv_event> recv(std::vector<stdx::buffer_view> bufs);
+
 
 		stdx::task<stdx::network_recv_event> recv_from(stdx::buffer buf);
 
-		void bind(ipv4_addr& addr)
+		void bind(const socket_addr& addr)
 		{
 			m_io_service.bind(m_handle, addr);
 		}
@@ -779,19 +1269,19 @@ namespace stdx
 
 		void close();
 
-		stdx::task<void> connect(ipv4_addr& addr);
+		stdx::task<void> connect(const socket_addr& addr);
 
 		io_service_t io_service() const
 		{
 			return m_io_service;
 		}
 
-		ipv4_addr local_addr() const
+		socket_addr local_addr() const
 		{
 			return m_io_service.get_local_addr(m_handle);
 		}
 
-		ipv4_addr remote_addr() const
+		socket_addr remote_addr() const
 		{
 			return m_io_service.get_remote_addr(m_handle);
 		}
@@ -804,6 +1294,33 @@ namespace stdx
 
 		void set_keepalive(bool opt);
 
+		void set_v6only(bool opt);
+
+		bool is_idle_alive() const
+		{
+			return m_io_service.is_idle_alive(m_handle);
+		}
+
+#ifdef LINUX
+		void set_reuse_port(bool opt);
+
+		//绑定到指定的事件循环,接受的连接也留在该循环
+		void bind_loop(size_t index);
+
+		void set_busy_poll(uint32_t us);
+
+		stdx::task<std::vector<stdx::network_recv_event>> recv_from_batch(std::vector<stdx::buffer> bufs);
+
+		stdx::task<std::vector<stdx::network_recv_event>> recv_from_batch(size_t n, size_t size = STDX_DATAGRAM_SIZE);
+
+		stdx::task<size_t> send_to_batch(std::vector<stdx::network_datagram> datagrams);
+
+		stdx::task<std::vector<stdx::network_accept_event>> accept_batch(size_t budget = STDX_ACCEPT_BATCH);
+
+		//开启后不小于STDX_ZEROCOPY_THRESHOLD的send使用MSG_ZEROCOPY
+		void set_zerocopy(bool opt);
+#endif
+
 		socket_t native_handle() const
 		{
 			return m_handle;
@@ -811,6 +1328,10 @@ namespace stdx
 	private:
 		io_service_t m_io_service;
 		std::atomic<socket_t> m_handle;
+		bool m_same_loop;
+#ifdef LINUX
+		std::shared_ptr<stdx::zerocopy_state> m_zerocopy;
+#endif
 	};
 
 	struct network_connected_event;
@@ -851,7 +1372,7 @@ namespace stdx
 			return m_impl->init(addr_family, sock_type, protocol);
 		}
 
-		void bind(ipv4_addr& addr)
+		void bind(const socket_addr& addr)
 		{
 			m_impl->bind(addr);
 		}
@@ -868,12 +1389,12 @@ namespace stdx
 			m_impl->close();
 		}
 
-		ipv4_addr local_addr() const
+		socket_addr local_addr() const
 		{
 			return m_impl->local_addr();
 		}
 
-		ipv4_addr remote_addr() const
+		socket_addr remote_addr() const
 		{
 			return m_impl->remote_addr();
 		}
@@ -888,7 +1409,13 @@ namespace stdx
 			return m_impl->send_file(file_with_cache);
 		}
 
-		stdx::task<network_send_event> send_to(const ipv4_addr& addr, stdx::buffer buf, const socket_size_t& size)
+		//发送文件的[offset,offset+length)部分,length为0表示到文件末尾
+		stdx::task<void> send_file(file_handle_t file_with_cache, uint64_t offset, uint64_t length, stdx::buffer_view prefix = stdx::buffer_view())
+		{
+			return m_impl->send_file(file_with_cache, offset, length, prefix);
+		}
+
+		stdx::task<network_send_event> send_to(const socket_addr& addr, stdx::buffer buf, const socket_size_t& size)
 		{
 			return m_impl->send_to(addr,buf, size);
 		}
@@ -898,6 +1425,18 @@ namespace stdx
 			return m_impl->recv(buf);
 		}
 
+		//一次系统调用发送多个缓存区,总长度为0时立即以0字节完成
+		stdx::task<network_send_event> send(std::vector<stdx::buffer_view> bufs)
+		{
+			return m_impl->send(std::move(bufs));
+		}
+
+		//一次系统调用接收到多个缓存区,总长度为0时立即以0字节完成
+		stdx::task<network_recv_event> recv(std::vector<stdx::buffer_view> bufs)
+		{
+			return m_impl->recv(std::move(bufs));
+		}
+
 		stdx::task<network_recv_event> recv_from(stdx::buffer buf)
 		{
 			return m_impl->recv_from(buf);
@@ -920,7 +1459,7 @@ namespace stdx
 			return (bool)m_impl;
 		}
 
-		stdx::task<void> connect(stdx::ipv4_addr& addr)
+		stdx::task<void> connect(const stdx::socket_addr& addr)
 		{
 			return m_impl->connect(addr);
 		}
@@ -930,6 +1469,61 @@ namespace stdx
 			return m_impl->set_keepalive(opt);
 		}
 
+		//关闭后可在同一个IPv6 socket上双栈监听
+		void set_v6only(bool opt)
+		{
+			return m_impl->set_v6only(opt);
+		}
+
+		//连接池复用前检查,对端已关闭或有多余数据时返回false
+		bool is_idle_alive() const
+		{
+			return m_impl->is_idle_alive();
+		}
+
+#ifdef LINUX
+		void set_reuse_port(bool opt)
+		{
+			return m_impl->set_reuse_port(opt);
+		}
+
+		void bind_loop(size_t index)
+		{
+			return m_impl->bind_loop(index);
+		}
+
+		void set_busy_poll(uint32_t us)
+		{
+			return m_impl->set_busy_poll(us);
+		}
+
+		//一次系统调用接收最多n个数据报
+		stdx::task<std::vector<stdx::network_recv_event>> recv_from_batch(size_t n, size_t size = STDX_DATAGRAM_SIZE)
+		{
+			return m_impl->recv_from_batch(n, size);
+		}
+
+		//复用已有buffer,避免每次分配
+		stdx::task<std::vector<stdx::network_recv_event>> recv_from_batch(std::vector<stdx::buffer> bufs)
+		{
+			return m_impl->recv_from_batch(std::move(bufs));
+		}
+
+		stdx::task<size_t> send_to_batch(std::vector<stdx::network_datagram> datagrams)
+		{
+			return m_impl->send_to_batch(std::move(datagrams));
+		}
+
+		//一次可读事件accept多个连接
+		stdx::task<std::vector<network_connected_event>> accept_batch(size_t budget = STDX_ACCEPT_BATCH);
+
+		//大块发送使用MSG_ZEROCOPY,send返回的task在内核释放buffer后完成
+		void set_zerocopy(bool opt)
+		{
+			return m_impl->set_zerocopy(opt);
+		}
+#endif
+
 		socket_t native_handle() const
 		{
 			return m_impl->native_handle();
@@ -948,7 +1542,7 @@ namespace stdx
 
 		network_connected_event() = default;
 
-		network_connected_event(stdx::socket _connection, const stdx::ipv4_addr& _addr)
+		network_connected_event(stdx::socket _connection, const stdx::socket_addr& _addr)
 			:connection(_connection)
 			, addr(_addr)
 		{}
@@ -980,13 +1574,18 @@ namespace stdx
 		}
 
 		stdx::socket connection;
-		ipv4_addr addr;
+		stdx::socket_addr addr;
 	};
 
 	extern stdx::socket open_socket(const stdx::network_io_service& io_service, const int& addr_family, const int& sock_type, const int& protocol);
 	extern stdx::socket open_socket(const stdx::network_io_service& io_service, const stdx::addr_family& addr_family, const stdx::socket_type& sock_type, const stdx::protocol& protocol);
 	extern stdx::socket open_tcpsocket(const stdx::network_io_service& io_service);
 	extern stdx::socket open_udpsocket(const stdx::network_io_service& io_service);
+	//按地址族打开socket(IPv4/IPv6/Unix域)
+	extern stdx::socket open_socket(const stdx::network_io_service& io_service, const stdx::socket_addr& addr, const stdx::socket_type& sock_type);
+	//打开多个监听socket(Linux下使用SO_REUSEPORT,每个事件循环一个)
+	//num为0时使用事件循环的数量
+	extern std::vector<stdx::socket> open_reuse_port_tcpsockets(const stdx::network_io_service& io_service, const stdx::socket_addr& addr, int backlog, size_t num = 0);
 #endif // _STDX_HAS_SOCKET
 }
 
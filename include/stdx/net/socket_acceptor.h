@@ -13,12 +13,23 @@ namespace stdx
 		using connection_t = typename base_t::connection_t;
 
 		basic_socket_acceptor(stdx::socket sock)
+			:basic_socket_acceptor(std::vector<stdx::socket>{sock})
+		{}
+
+		//多个监听socket(例如SO_REUSEPORT)
+		basic_socket_acceptor(std::vector<stdx::socket> socks)
 			:base_t()
-			,m_sock(sock)
+			,m_socks(socks)
+			,m_index(0)
 #ifndef WIN32
 			, m_nullfd(::open("/dev/null", O_CLOEXEC))
 #endif
-		{}
+		{
+			if (m_socks.empty())
+			{
+				throw std::invalid_argument("no listening socket");
+			}
+		}
 
 		virtual ~basic_socket_acceptor()
 		{
@@ -32,7 +43,8 @@ namespace stdx
 
 		virtual stdx::task<connection_t> accept() override
 		{
-			return m_sock.accept().then([this](stdx::task_result<stdx::network_connected_event> r)
+			stdx::socket sock = m_socks[m_index.fetch_add(1) % m_socks.size()];
+			return sock.accept().then([this](stdx::task_result<stdx::network_connected_event> r)
 				{
 					stdx::network_connected_event ev = r.get();
 					return make_connection(ev.connection);
@@ -41,8 +53,26 @@ namespace stdx
 
 		virtual void accept_until(stdx::cancel_token token, std::function<void(connection_t)> fn, std::function<void(std::exception_ptr)> err_handler) override
 		{
+			for (auto begin = m_socks.begin(),end = m_socks.end();begin != end;++begin)
+			{
+				_AcceptUntil(*begin, token, fn, err_handler);
+			}
+		}
+
+	protected:
+		virtual connection_t make_connection(stdx::socket sock) = 0;
+
+	private:
+		std::vector<stdx::socket> m_socks;
+		std::atomic_size_t m_index;
+#ifndef WIN32
+		int m_nullfd;
+#endif
+
+		void _AcceptUntil(stdx::socket &sock, stdx::cancel_token token, std::function<void(connection_t)> fn, std::function<void(std::exception_ptr)> err_handler)
+		{
 #ifdef WIN32
-			m_sock.accept_until(token, [this, fn, err_handler](stdx::network_connected_event ev) mutable
+			sock.accept_until(token, [this, fn, err_handler](stdx::network_connected_event ev) mutable
 				{
 					try
 					{
@@ -55,7 +85,7 @@ namespace stdx
 					}
 				}, err_handler);
 #else
-			m_sock.accept_until(token, [fn,err_handler,this](stdx::network_connected_event ev) mutable
+			sock.accept_until(token, [fn,err_handler,this](stdx::network_connected_event ev) mutable
 				{
 					try
 					{
@@ -66,7 +96,7 @@ namespace stdx
 					{
 						err_handler(std::current_exception());
 					}
-				}, [this, err_handler](std::exception_ptr err) mutable
+				}, [this, sock, err_handler](std::exception_ptr err) mutable
 				{
 					try
 					{
@@ -80,7 +110,7 @@ namespace stdx
 						if (e.code().value() == EMFILE)
 						{
 							::close(m_nullfd);
-							m_nullfd = ::accept(m_sock.native_handle(), nullptr, nullptr);
+							m_nullfd = ::accept(sock.native_handle(), nullptr, nullptr);
 							::close(m_nullfd);
 							m_nullfd = ::open("/dev/null", O_CLOEXEC);
 						}
@@ -93,14 +123,5 @@ namespace stdx
 				});
 #endif
 		}
-
-	protected:
-		virtual connection_t make_connection(stdx::socket sock) = 0;
-
-	private:
-		stdx::socket m_sock;
-#ifndef WIN32
-		int m_nullfd;
-#endif
 	};
 }
\ No newline at end of file
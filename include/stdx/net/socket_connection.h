@@ -30,6 +30,15 @@ namespace stdx
 			return m_socket.send_file(file);
 		}
 
+		virtual stdx::task<void> write_file(stdx::file_handle file, uint64_t offset, uint64_t length, stdx::buffer_view prefix) override
+		{
+			//发送完成前保持文件打开
+			return m_socket.send_file(file, offset, length, prefix).then([file](stdx::task_result<void> r)
+			{
+				r.get();
+			});
+		}
+
 		virtual void close() override
 		{
 			m_socket.close();
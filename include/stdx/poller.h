@@ -4,10 +4,177 @@
 #include <functional>
 #include <vector>
 #include <atomic>
+#include <unordered_map>
+#include <algorithm>
+#include <chrono>
 #include <stdx/async/thread_local_storer.h>
+#include <stdx/async/spin_lock.h>
+
+//未绑定的key(如普通文件)记录所选poller的槽位数
+#ifndef STDX_MULTIPOLLER_UNBOUND_SLOTS
+#define STDX_MULTIPOLLER_UNBOUND_SLOTS 64
+#endif
 
 namespace stdx
 {
+	//poller负载计数器
+	struct poller_load
+	{
+		poller_load()
+			:bound(0)
+			,events(0)
+		{}
+
+		~poller_load() = default;
+
+		//number of keys bound to the poller
+		std::atomic_size_t bound;
+		//number of contexts completed by the poller
+		std::atomic_size_t events;
+	};
+
+	//poller负载快照
+	struct poller_load_info
+	{
+		poller_load_info()
+			:bound(0)
+			,events(0)
+		{}
+
+		poller_load_info(const stdx::poller_load& load)
+			:bound(load.bound.load(std::memory_order_relaxed))
+			,events(load.events.load(std::memory_order_relaxed))
+		{}
+
+		~poller_load_info() = default;
+
+		size_t bound;
+		size_t events;
+	};
+
+	//poller统计计数器
+	//每个计数器只由所属的事件循环线程写入,读取方通过poller_stats_info获取快照
+	struct poller_stats
+	{
+		poller_stats()
+			:waits(0)
+			,events(0)
+			,wakeups(0)
+			,tasks(0)
+			,wait_ns(0)
+			,busy_ns(0)
+			,max_task_ns(0)
+			,pending_tasks(0)
+			,pending_completions(0)
+		{}
+
+		~poller_stats() = default;
+
+		//number of wait(e.g. epoll_wait) returns
+		std::atomic_uint64_t waits;
+		//number of events returned by wait
+		std::atomic_uint64_t events;
+		//number of wakeups by notice or posted tasks(eventfd)
+		std::atomic_uint64_t wakeups;
+		//number of tasks and contexts executed
+		std::atomic_uint64_t tasks;
+		//time spent in wait
+		std::atomic_uint64_t wait_ns;
+		//time spent executing tasks and contexts
+		std::atomic_uint64_t busy_ns;
+		//max run time of a single task or context
+		std::atomic_uint64_t max_task_ns;
+		//depth of the task queue owned by this loop
+		std::atomic_size_t pending_tasks;
+		//depth of the completion queue
+		std::atomic_size_t pending_completions;
+
+		static uint64_t now_ns()
+		{
+			return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+		}
+
+		void add_wait(uint64_t ns, size_t num_of_events)
+		{
+			waits.fetch_add(1, std::memory_order_relaxed);
+			events.fetch_add(num_of_events, std::memory_order_relaxed);
+			wait_ns.fetch_add(ns, std::memory_order_relaxed);
+		}
+
+		void add_task(uint64_t ns)
+		{
+			tasks.fetch_add(1, std::memory_order_relaxed);
+			busy_ns.fetch_add(ns, std::memory_order_relaxed);
+			uint64_t max = max_task_ns.load(std::memory_order_relaxed);
+			while (ns > max && !max_task_ns.compare_exchange_weak(max, ns, std::memory_order_relaxed))
+			{}
+		}
+	};
+
+	//poller统计快照
+	struct poller_stats_info
+	{
+		poller_stats_info()
+			:waits(0)
+			,events(0)
+			,wakeups(0)
+			,tasks(0)
+			,wait_ns(0)
+			,busy_ns(0)
+			,max_task_ns(0)
+			,pending_tasks(0)
+			,pending_completions(0)
+		{}
+
+		poller_stats_info(const stdx::poller_stats& stats)
+			:waits(stats.waits.load(std::memory_order_relaxed))
+			,events(stats.events.load(std::memory_order_relaxed))
+			,wakeups(stats.wakeups.load(std::memory_order_relaxed))
+			,tasks(stats.tasks.load(std::memory_order_relaxed))
+			,wait_ns(stats.wait_ns.load(std::memory_order_relaxed))
+			,busy_ns(stats.busy_ns.load(std::memory_order_relaxed))
+			,max_task_ns(stats.max_task_ns.load(std::memory_order_relaxed))
+			,pending_tasks(stats.pending_tasks.load(std::memory_order_relaxed))
+			,pending_completions(stats.pending_completions.load(std::memory_order_relaxed))
+		{}
+
+		~poller_stats_info() = default;
+
+		uint64_t waits;
+		uint64_t events;
+		uint64_t wakeups;
+		uint64_t tasks;
+		uint64_t wait_ns;
+		uint64_t busy_ns;
+		uint64_t max_task_ns;
+		size_t pending_tasks;
+		size_t pending_completions;
+
+		double events_per_wait() const
+		{
+			if (waits == 0)
+			{
+				return 0;
+			}
+			return static_cast<double>(events) / static_cast<double>(waits);
+		}
+
+		//合并另一份快照(例如线程池记录的执行时间)
+		stdx::poller_stats_info& merge(const stdx::poller_stats_info& other)
+		{
+			waits += other.waits;
+			events += other.events;
+			wakeups += other.wakeups;
+			tasks += other.tasks;
+			wait_ns += other.wait_ns;
+			busy_ns += other.busy_ns;
+			max_task_ns = (std::max)(max_task_ns, other.max_task_ns);
+			pending_tasks += other.pending_tasks;
+			pending_completions += other.pending_completions;
+			return *this;
+		}
+	};
+
 	template<typename _Context,typename _KeyType>
 	INTERFACE_CLASS basic_poller
 	{
@@ -33,6 +200,20 @@ namespace stdx
 		virtual void unbind(const _KeyType& object, std::function<void(_KeyType)> deleter)
 		{}
 
+		//绑定到指定的poller
+		virtual void bind_at(const _KeyType& object, size_t index)
+		{
+			NO_USED(index);
+			bind(object);
+		}
+
+		//获取key所在poller的索引
+		virtual size_t index_of(const _KeyType& object)
+		{
+			NO_USED(object);
+			return 0;
+		}
+
 		virtual _Context* get_at(size_t index)
 		{
 			NO_USED(index);
@@ -46,6 +227,29 @@ namespace stdx
 		}
 
 		virtual void notice() = 0;
+
+		virtual size_t size() const
+		{
+			return 1;
+		}
+
+		virtual stdx::poller_load_info load_at(size_t index) const
+		{
+			NO_USED(index);
+			return stdx::poller_load_info();
+		}
+
+		virtual stdx::poller_stats_info stats_at(size_t index) const
+		{
+			NO_USED(index);
+			return stdx::poller_stats_info();
+		}
+
+		//忙轮询:阻塞等待前先以0超时轮询spin_us微秒,0表示关闭
+		virtual void set_busy_poll(uint32_t spin_us)
+		{
+			NO_USED(spin_us);
+		}
 	};
 
 	template<typename _Context,typename _KeyType>
@@ -109,6 +313,16 @@ namespace stdx
 			m_impl->unbind(object, deleter);
 		}
 
+		void bind_at(const _KeyType& object, size_t index)
+		{
+			m_impl->bind_at(object, index);
+		}
+
+		size_t index_of(const _KeyType& object)
+		{
+			return m_impl->index_of(object);
+		}
+
 		_Context* get()
 		{
 			return m_impl->get();
@@ -138,6 +352,26 @@ namespace stdx
 		{
 			return m_impl->notice();
 		}
+
+		size_t size() const
+		{
+			return m_impl->size();
+		}
+
+		stdx::poller_load_info load_at(size_t index) const
+		{
+			return m_impl->load_at(index);
+		}
+
+		stdx::poller_stats_info stats_at(size_t index) const
+		{
+			return m_impl->stats_at(index);
+		}
+
+		void set_busy_poll(uint32_t spin_us)
+		{
+			return m_impl->set_busy_poll(spin_us);
+		}
 	private:
 		impl_t m_impl;
 	};
@@ -149,6 +383,324 @@ namespace stdx
 		return stdx::poller<_Context, _KeyType>(impl);
 	}
 
+	//poller分派器接口
+	//loads: per-poller load counters
+	//current: index of the calling loop thread,or loads.size() if the caller is not a loop thread
+	template<typename _KeyType>
+	INTERFACE_CLASS basic_poller_dispatcher
+	{
+		using key_t = _KeyType;
+
+		INTERFACE_CLASS_HELPER(basic_poller_dispatcher);
+
+		virtual size_t dispatch(const _KeyType& key, const std::vector<stdx::poller_load>& loads, size_t current) = 0;
+	};
+
+	template<typename _KeyType>
+	class poller_dispatcher
+	{
+		using impl_t = std::shared_ptr<stdx::basic_poller_dispatcher<_KeyType>>;
+		using self_t = stdx::poller_dispatcher<_KeyType>;
+	public:
+		poller_dispatcher()
+			:m_impl(nullptr)
+		{}
+
+		poller_dispatcher(const impl_t& impl)
+			:m_impl(impl)
+		{}
+
+		poller_dispatcher(const self_t& other)
+			:m_impl(other.m_impl)
+		{}
+
+		poller_dispatcher(self_t&& other) noexcept
+			:m_impl(std::move(other.m_impl))
+		{}
+
+		~poller_dispatcher() = default;
+
+		self_t& operator=(const self_t& other)
+		{
+			m_impl = other.m_impl;
+			return *this;
+		}
+
+		self_t& operator=(self_t&& other) noexcept
+		{
+			m_impl = std::move(other.m_impl);
+			return *this;
+		}
+
+		operator bool() const
+		{
+			return (bool)m_impl;
+		}
+
+		bool operator==(const self_t& other) const
+		{
+			return m_impl == other.m_impl;
+		}
+
+		size_t dispatch(const _KeyType& key, const std::vector<stdx::poller_load>& loads, size_t current)
+		{
+			return m_impl->dispatch(key, loads, current);
+		}
+	private:
+		impl_t m_impl;
+	};
+
+	template<typename _Impl, typename ..._Args, typename _KeyType = typename _Impl::key_t>
+	inline stdx::poller_dispatcher<_KeyType> make_poller_dispatcher(_Args&&...args)
+	{
+		std::shared_ptr<stdx::basic_poller_dispatcher<_KeyType>> impl = std::make_shared<_Impl>(args...);
+		return stdx::poller_dispatcher<_KeyType>(impl);
+	}
+
+	//使用函数分派(例如 key % size)
+	template<typename _KeyType>
+	class _FunctionPollerDispatcher:public stdx::basic_poller_dispatcher<_KeyType>
+	{
+	public:
+		using dispath_t = std::function<size_t(const _KeyType&, size_t)>;
+
+		_FunctionPollerDispatcher(dispath_t dispath)
+			:m_dispath(dispath)
+		{}
+
+		~_FunctionPollerDispatcher() = default;
+
+		virtual size_t dispatch(const _KeyType& key, const std::vector<stdx::poller_load>& loads, size_t current) override
+		{
+			NO_USED(current);
+			return m_dispath(key, loads.size());
+		}
+	private:
+		dispath_t m_dispath;
+	};
+
+	//分派到绑定key最少的poller
+	template<typename _KeyType>
+	class _LeastBoundPollerDispatcher:public stdx::basic_poller_dispatcher<_KeyType>
+	{
+	public:
+		_LeastBoundPollerDispatcher() = default;
+
+		~_LeastBoundPollerDispatcher() = default;
+
+		virtual size_t dispatch(const _KeyType& key, const std::vector<stdx::poller_load>& loads, size_t current) override
+		{
+			NO_USED(key);
+			size_t index = 0;
+			size_t min = SIZE_MAX;
+			//prefer the calling loop when it is tied for least loaded
+			if (current < loads.size())
+			{
+				index = current;
+				min = loads[current].bound.load(std::memory_order_relaxed);
+			}
+			for (size_t i = 0, size = loads.size(); i < size; ++i)
+			{
+				size_t bound = loads[i].bound.load(std::memory_order_relaxed);
+				if (bound < min)
+				{
+					min = bound;
+					index = i;
+				}
+			}
+			return index;
+		}
+	};
+
+	//分派到最近事件速率最低的poller
+	template<typename _KeyType>
+	class _LeastActivePollerDispatcher:public stdx::basic_poller_dispatcher<_KeyType>
+	{
+		using clock_t = std::chrono::steady_clock;
+	public:
+		_LeastActivePollerDispatcher(uint32_t window_ms = 1000)
+			:m_lock()
+			,m_window(std::chrono::milliseconds(window_ms))
+			,m_last_time()
+			,m_last_events()
+			,m_rates()
+		{}
+
+		~_LeastActivePollerDispatcher() = default;
+
+		virtual size_t dispatch(const _KeyType& key, const std::vector<stdx::poller_load>& loads, size_t current) override
+		{
+			NO_USED(key);
+			NO_USED(current);
+			std::unique_lock<stdx::spin_lock> lock(m_lock);
+			_Sample(loads);
+			size_t index = 0;
+			for (size_t i = 1, size = loads.size(); i < size; ++i)
+			{
+				if (m_rates[i] < m_rates[index])
+				{
+					index = i;
+				}
+				else if (m_rates[i] == m_rates[index] && loads[i].bound.load(std::memory_order_relaxed) < loads[index].bound.load(std::memory_order_relaxed))
+				{
+					index = i;
+				}
+			}
+			//count the new key against the poller until the next sample
+			m_rates[index] += 1;
+			return index;
+		}
+	private:
+		stdx::spin_lock m_lock;
+		clock_t::duration m_window;
+		clock_t::time_point m_last_time;
+		std::vector<size_t> m_last_events;
+		std::vector<size_t> m_rates;
+
+		void _Sample(const std::vector<stdx::poller_load>& loads)
+		{
+			clock_t::time_point now = clock_t::now();
+			if (m_last_events.size() != loads.size())
+			{
+				m_last_events.assign(loads.size(), 0);
+				m_rates.assign(loads.size(), 0);
+				for (size_t i = 0, size = loads.size(); i < size; ++i)
+				{
+					m_last_events[i] = loads[i].events.load(std::memory_order_relaxed);
+				}
+				m_last_time = now;
+				return;
+			}
+			if (now - m_last_time < m_window)
+			{
+				return;
+			}
+			for (size_t i = 0, size = loads.size(); i < size; ++i)
+			{
+				size_t events = loads[i].events.load(std::memory_order_relaxed);
+				m_rates[i] = events - m_last_events[i];
+				m_last_events[i] = events;
+			}
+			m_last_time = now;
+		}
+	};
+
+	//分派到调用者所在的poller(例如接受连接的线程)
+	template<typename _KeyType>
+	class _AffinityPollerDispatcher:public stdx::_LeastBoundPollerDispatcher<_KeyType>
+	{
+		using base_t = stdx::_LeastBoundPollerDispatcher<_KeyType>;
+	public:
+		_AffinityPollerDispatcher() = default;
+
+		~_AffinityPollerDispatcher() = default;
+
+		virtual size_t dispatch(const _KeyType& key, const std::vector<stdx::poller_load>& loads, size_t current) override
+		{
+			if (current < loads.size())
+			{
+				return current;
+			}
+			//not called from a loop thread
+			return base_t::dispatch(key, loads, current);
+		}
+	};
+
+	//一致性哈希分派
+	template<typename _KeyType, typename _Hash = std::hash<_KeyType>>
+	class _ConsistentHashPollerDispatcher:public stdx::basic_poller_dispatcher<_KeyType>
+	{
+		using node_t = std::pair<uint64_t, size_t>;
+	public:
+		_ConsistentHashPollerDispatcher(size_t replicas = 64)
+			:m_lock()
+			,m_replicas(replicas ? replicas : 1)
+			,m_size(0)
+			,m_ring()
+			,m_hash()
+		{}
+
+		~_ConsistentHashPollerDispatcher() = default;
+
+		virtual size_t dispatch(const _KeyType& key, const std::vector<stdx::poller_load>& loads, size_t current) override
+		{
+			NO_USED(current);
+			uint64_t hash = _Mix(static_cast<uint64_t>(m_hash(key)));
+			std::unique_lock<stdx::spin_lock> lock(m_lock);
+			if (m_size != loads.size())
+			{
+				_Build(loads.size());
+			}
+			auto it = std::lower_bound(m_ring.begin(), m_ring.end(), node_t(hash, 0));
+			if (it == m_ring.end())
+			{
+				it = m_ring.begin();
+			}
+			return it->second;
+		}
+	private:
+		stdx::spin_lock m_lock;
+		size_t m_replicas;
+		size_t m_size;
+		std::vector<node_t> m_ring;
+		_Hash m_hash;
+
+		static uint64_t _Mix(uint64_t x)
+		{
+			x ^= x >> 33;
+			x *= 0xff51afd7ed558ccdULL;
+			x ^= x >> 33;
+			x *= 0xc4ceb9fe1a85ec53ULL;
+			x ^= x >> 33;
+			return x;
+		}
+
+		void _Build(size_t size)
+		{
+			m_ring.clear();
+			m_ring.reserve(size * m_replicas);
+			for (size_t i = 0; i < size; ++i)
+			{
+				for (size_t r = 0; r < m_replicas; ++r)
+				{
+					m_ring.push_back(node_t(_Mix((static_cast<uint64_t>(i) << 32) | r), i));
+				}
+			}
+			std::sort(m_ring.begin(), m_ring.end());
+			m_size = size;
+		}
+	};
+
+	template<typename _KeyType>
+	inline stdx::poller_dispatcher<_KeyType> make_function_poller_dispatcher(std::function<size_t(const _KeyType&, size_t)> dispath)
+	{
+		return stdx::make_poller_dispatcher<stdx::_FunctionPollerDispatcher<_KeyType>>(dispath);
+	}
+
+	template<typename _KeyType>
+	inline stdx::poller_dispatcher<_KeyType> make_least_bound_poller_dispatcher()
+	{
+		return stdx::make_poller_dispatcher<stdx::_LeastBoundPollerDispatcher<_KeyType>>();
+	}
+
+	template<typename _KeyType>
+	inline stdx::poller_dispatcher<_KeyType> make_least_active_poller_dispatcher(uint32_t window_ms = 1000)
+	{
+		return stdx::make_poller_dispatcher<stdx::_LeastActivePollerDispatcher<_KeyType>>(window_ms);
+	}
+
+	template<typename _KeyType>
+	inline stdx::poller_dispatcher<_KeyType> make_affinity_poller_dispatcher()
+	{
+		return stdx::make_poller_dispatcher<stdx::_AffinityPollerDispatcher<_KeyType>>();
+	}
+
+	template<typename _KeyType>
+	inline stdx::poller_dispatcher<_KeyType> make_consistent_hash_poller_dispatcher(size_t replicas = 64)
+	{
+		return stdx::make_poller_dispatcher<stdx::_ConsistentHashPollerDispatcher<_KeyType>>(replicas);
+	}
+
 	template<typename _Impl>
 	class basic_multipoller:public stdx::basic_poller<typename _Impl::context_t,typename _Impl::key_t>
 	{
@@ -157,16 +709,27 @@ namespace stdx
 		using context_t = typename base_t::context_t;
 		using key_t = typename base_t::key_t;
 		using dispath_t = std::function<size_t(const key_t &,size_t)>;
+		using dispatcher_t = stdx::poller_dispatcher<key_t>;
 		using get_key_t = std::function<key_t(context_t *)>;
 		using poller_t = stdx::poller<context_t, key_t>;
 
 		template<typename ..._Args>
 		basic_multipoller(size_t num_of_poller,dispath_t dispath,get_key_t key_getter,_Args &&...args)
+			:basic_multipoller(num_of_poller,stdx::make_function_poller_dispatcher<key_t>(dispath),key_getter,args...)
+		{}
+
+		template<typename ..._Args>
+		basic_multipoller(size_t num_of_poller,dispatcher_t dispatcher,get_key_t key_getter,_Args &&...args)
 			:base_t()
-			,m_dispath(dispath)
+			,m_dispatcher(dispatcher)
 			,m_key_getter(key_getter)
 			,m_pollers()
-			,m_pos(num_of_poller)
+			,m_pos(0)
+			,m_loads(num_of_poller)
+			,m_lock()
+			,m_keys()
+			,m_unbound(STDX_MULTIPOLLER_UNBOUND_SLOTS, std::make_pair(key_t(), num_of_poller))
+			,m_loop_index(stdx::make_thread_local_storer<size_t>())
 		{
 			m_pollers.reserve(num_of_poller);
 			for (size_t i = 0; i < num_of_poller; ++i)
@@ -179,32 +742,101 @@ namespace stdx
 
 		virtual void bind(const key_t& object) override
 		{
-			poller_t& poller = _GetPollerByKey(object);
+			size_t index = m_pollers.size();
+			{
+				std::unique_lock<stdx::spin_lock> lock(m_lock);
+				auto it = m_keys.find(object);
+				if (it != m_keys.end())
+				{
+					//already bound
+					index = it->second;
+				}
+			}
+			if (index == m_pollers.size())
+			{
+				index = m_dispatcher.dispatch(object, m_loads, _GetLoopIndex());
+				std::unique_lock<stdx::spin_lock> lock(m_lock);
+				auto it = m_keys.find(object);
+				if (it != m_keys.end())
+				{
+					index = it->second;
+				}
+				else
+				{
+					m_keys.emplace(object, index);
+					m_loads[index].bound.fetch_add(1, std::memory_order_relaxed);
+				}
+			}
+			_GetPoller(index).bind(object);
+		}
+
+		virtual void bind_at(const key_t& object, size_t index) override
+		{
+			//throw if out of range
+			poller_t& poller = _GetPoller(index);
+			size_t old = m_pollers.size();
+			{
+				std::unique_lock<stdx::spin_lock> lock(m_lock);
+				auto it = m_keys.find(object);
+				if (it != m_keys.end())
+				{
+					old = it->second;
+					it->second = index;
+				}
+				else
+				{
+					m_keys.emplace(object, index);
+				}
+				if (old != index)
+				{
+					if (old < m_pollers.size())
+					{
+						m_loads[old].bound.fetch_sub(1, std::memory_order_relaxed);
+					}
+					m_loads[index].bound.fetch_add(1, std::memory_order_relaxed);
+				}
+			}
+			if (old < m_pollers.size() && old != index)
+			{
+				//move from the old poller
+				_GetPoller(old).unbind(object);
+			}
 			poller.bind(object);
 		}
 
+		virtual size_t index_of(const key_t& object) override
+		{
+			{
+				std::unique_lock<stdx::spin_lock> lock(m_lock);
+				auto it = m_keys.find(object);
+				if (it != m_keys.end())
+				{
+					return it->second;
+				}
+			}
+			return _GetFreeIndex();
+		}
+
 		virtual void unbind(const key_t& object) override
 		{
-			poller_t& poller = _GetPollerByKey(object);
-			poller.unbind(object);
+			size_t index = _ReleaseKey(object);
+			_GetPoller(index).unbind(object);
 		}
 
 		virtual void unbind(const key_t& object, std::function<void(key_t)> deleter) override
 		{
-			poller_t& poller = _GetPollerByKey(object);
-			poller.unbind(object,deleter);
+			size_t index = _ReleaseKey(object);
+			_GetPoller(index).unbind(object,deleter);
 		}
 
 		virtual context_t* get() override
 		{
-			poller_t& poller = m_pollers.at(0);
-			return poller.get();
+			return get_at(_GetFreeIndex());
 		}
 
 		virtual context_t* get(uint32_t timeout_ms) override
 		{
-			poller_t& poller = m_pollers.at(0);
-			return poller.get(timeout_ms);
+			return get_at(_GetFreeIndex(), timeout_ms);
 		}
 
 		virtual void post(context_t* context) override
@@ -215,12 +847,24 @@ namespace stdx
 
 		virtual context_t* get_at(size_t index)
 		{
-			return _GetPoller(index).get();
+			_SetLoopIndex(index);
+			context_t* context = _GetPoller(index).get();
+			if (context)
+			{
+				m_loads[index].events.fetch_add(1, std::memory_order_relaxed);
+			}
+			return context;
 		}
 
 		virtual context_t* get_at(size_t index, uint32_t timeout_ms)
 		{
-			return _GetPoller(index).get(timeout_ms);
+			_SetLoopIndex(index);
+			context_t* context = _GetPoller(index).get(timeout_ms);
+			if (context)
+			{
+				m_loads[index].events.fetch_add(1, std::memory_order_relaxed);
+			}
+			return context;
 		}
 
 		virtual void notice()
@@ -230,22 +874,118 @@ namespace stdx
 				begin->notice();
 			}
 		}
+
+		virtual size_t size() const override
+		{
+			return m_pollers.size();
+		}
+
+		virtual stdx::poller_load_info load_at(size_t index) const override
+		{
+			return stdx::poller_load_info(m_loads.at(index));
+		}
+
+		virtual stdx::poller_stats_info stats_at(size_t index) const override
+		{
+			return m_pollers.at(index).stats_at(0);
+		}
+
+		virtual void set_busy_poll(uint32_t spin_us) override
+		{
+			for (auto begin = m_pollers.begin(), end = m_pollers.end(); begin != end; begin++)
+			{
+				begin->set_busy_poll(spin_us);
+			}
+		}
 	protected:
-		dispath_t m_dispath;
+		dispatcher_t m_dispatcher;
 		get_key_t m_key_getter;
 		std::vector<poller_t> m_pollers;
 		std::atomic_size_t m_pos;
+		std::vector<stdx::poller_load> m_loads;
+		stdx::spin_lock m_lock;
+		std::unordered_map<key_t, size_t> m_keys;
+		//未绑定的key按hash分槽记录,冲突时覆盖,不计入bound
+		std::vector<std::pair<key_t, size_t>> m_unbound;
+		stdx::thread_local_storer<size_t> m_loop_index;
 
 		poller_t& _GetPoller(size_t index)
 		{
 			return m_pollers.at(index);
 		}
 
+		size_t _GetLoopIndex() const
+		{
+			size_t* p = m_loop_index.get();
+			if (p)
+			{
+				return *p;
+			}
+			return m_pollers.size();
+		}
+
+		void _SetLoopIndex(size_t index)
+		{
+			size_t* p = m_loop_index.get();
+			if (!p || *p != index)
+			{
+				m_loop_index.set(index);
+			}
+		}
+
+		size_t _GetFreeIndex()
+		{
+			size_t index = _GetLoopIndex();
+			if (index < m_pollers.size())
+			{
+				return index;
+			}
+			return m_pos.fetch_add(1, std::memory_order_relaxed) % m_pollers.size();
+		}
+
+		size_t _ReleaseKey(const key_t& key)
+		{
+			{
+				std::unique_lock<stdx::spin_lock> lock(m_lock);
+				auto it = m_keys.find(key);
+				if (it != m_keys.end())
+				{
+					size_t index = it->second;
+					m_keys.erase(it);
+					m_loads[index].bound.fetch_sub(1, std::memory_order_relaxed);
+					return index;
+				}
+			}
+			return m_dispatcher.dispatch(key, m_loads, _GetLoopIndex());
+		}
+
 		poller_t& _GetPollerByKey(const key_t& key)
 		{
-			size_t index = m_dispath(key, m_pollers.size());
-			poller_t& poller = _GetPoller(index);
-			return poller;
+			{
+				std::unique_lock<stdx::spin_lock> lock(m_lock);
+				auto it = m_keys.find(key);
+				if (it != m_keys.end())
+				{
+					return _GetPoller(it->second);
+				}
+			}
+			//keys that are never bound(e.g. regular files)
+			//remember the choice in a fixed slot so later posts of the same key stay on one loop
+			std::pair<key_t, size_t>& slot = m_unbound[std::hash<key_t>()(key) % m_unbound.size()];
+			{
+				std::unique_lock<stdx::spin_lock> lock(m_lock);
+				if (slot.second < m_pollers.size() && slot.first == key)
+				{
+					return _GetPoller(slot.second);
+				}
+			}
+			size_t index = m_dispatcher.dispatch(key, m_loads, _GetLoopIndex());
+			{
+				std::unique_lock<stdx::spin_lock> lock(m_lock);
+				slot.first = key;
+				slot.second = index;
+			}
+			return _GetPoller(index);
 		}
 
 		poller_t& _GetPoller(context_t* context)
@@ -262,6 +1002,13 @@ namespace stdx
 		return stdx::poller<_Context, _KeyType>(impl);
 	}
 
+	template<typename _Impl, typename ..._Args, typename _Context = typename _Impl::context_t, typename _KeyType = typename _Impl::key_t>
+	inline stdx::poller<_Context, _KeyType> make_multipoller(size_t num_of_poller,typename stdx::basic_multipoller<_Impl>::dispatcher_t dispatcher, typename stdx::basic_multipoller<_Impl>::get_key_t getter,_Args &&...args)
+	{
+		std::shared_ptr<stdx::basic_poller<_Context, _KeyType>> impl = std::make_shared<stdx::basic_multipoller<_Impl>>(num_of_poller,dispatcher,getter,args...);
+		return stdx::poller<_Context, _KeyType>(impl);
+	}
+
 	struct stand_context
 	{
 #ifdef WIN32
@@ -270,6 +1017,10 @@ namespace stdx
 		uint32_t events;
 		int key;
 		bool is_io_operation;
+		//持久注册:每次io_operation完成都就地调用execute,直到被清除
+		bool is_persistent;
+		//poller取走的套接字错误,非0时io_operation直接以该错误结束
+		int sock_err;
 		std::function<bool(stdx::stand_context*)> io_operation;
 #endif
 		std::function<void(stdx::stand_context*)> execute;
@@ -266,6 +266,14 @@ extern stdx::io_thread_pool stdx::make_io_thread_pool(uint32_t size)
 	return stdx::io_thread_pool(impl);
 }
 
+#ifndef WIN32
+stdx::io_thread_pool stdx::make_io_thread_pool(uint32_t size, stdx::poller_dispatcher<stdx::basic_thread_pool::key_t> dispatcher)
+{
+	std::shared_ptr<stdx::basic_thread_pool> impl = std::make_shared<stdx::_IoThreadPool>(size,dispatcher);
+	return stdx::io_thread_pool(impl);
+}
+#endif
+
 stdx::_IoThreadPool::_IoThreadPool(uint32_t num_threads)
 #ifdef WIN32
 	:m_poller(stdx::make_iocp_poller<stdx::stand_context>())
@@ -274,19 +282,44 @@ stdx::_IoThreadPool::_IoThreadPool(uint32_t num_threads)
 #endif
 	,m_token()
 	,m_threads()
+	,m_stats(num_threads)
 #ifndef WIN32
 	, m_lock()
 	, m_tasks()
 #endif
+{
+	_Init(num_threads);
+}
+
+#ifndef WIN32
+stdx::_IoThreadPool::_IoThreadPool(uint32_t num_threads, stdx::poller_dispatcher<key_t> dispatcher)
+	:m_poller(stdx::make_epoll_multipoller<stdx::stand_context>(stdx::implicit_cast<size_t>(num_threads),dispatcher))
+	,m_token()
+	,m_threads()
+	,m_stats(num_threads)
+	,m_lock()
+	,m_tasks()
+{
+	_Init(num_threads);
+}
+#endif
+
+void stdx::_IoThreadPool::_Init(uint32_t num_threads)
 {
 	for (uint32_t i =0;i < num_threads;++i)
 	{
 		m_threads.push_back(std::make_shared<std::thread>([this,i]() {
+			stdx::poller_stats& stats = m_stats[i];
 			while (!m_token.is_cancel())
 			{
 #ifndef WIN32
+				uint64_t start = stdx::poller_stats::now_ns();
 				while (_HandleTasks())
-				{}
+				{
+					uint64_t now = stdx::poller_stats::now_ns();
+					stats.add_task(now - start);
+					start = now;
+				}
 #endif
 				try
 				{
@@ -297,6 +330,7 @@ stdx::_IoThreadPool::_IoThreadPool(uint32_t num_threads)
 #endif
 					if (context)
 					{
+						uint64_t start = stdx::poller_stats::now_ns();
 						try
 						{
 							context->execute(context);
@@ -308,6 +342,7 @@ stdx::_IoThreadPool::_IoThreadPool(uint32_t num_threads)
 							::printf("[Thread Pool]Error: %s\n", e.what());
 #endif
 						}
+						stats.add_task(stdx::poller_stats::now_ns() - start);
 					}
 				}
 				catch (const std::exception &e)
@@ -322,9 +357,32 @@ stdx::_IoThreadPool::_IoThreadPool(uint32_t num_threads)
 	}
 }
 
+stdx::poller_stats_info stdx::_IoThreadPool::stats_at(size_t index)
+{
+	stdx::poller_stats_info info(m_stats.at(index));
+#ifndef WIN32
+	info.merge(m_poller.stats_at(index));
+#endif
+	return info;
+}
+
+size_t stdx::_IoThreadPool::shared_pending_tasks()
+{
+#ifdef WIN32
+	return 0;
+#else
+	std::unique_lock<stdx::spin_lock> lock(m_lock);
+	return m_tasks.size();
+#endif
+}
+
 stdx::_IoThreadPool::~_IoThreadPool()
 {
 	m_token.cancel();
+#ifndef WIN32
+	//唤醒阻塞在epoll_wait中的事件循环
+	m_poller.notice();
+#endif
 	_Join();
 }
 
@@ -0,0 +1,182 @@
+#include <stdx/async/timer.h>
+#include <stdx/async/threadpool.h>
+#include <stdx/io.h>
+#ifdef WIN32
+#define _ThrowWinError auto _ERROR_CODE = GetLastError(); \
+						throw std::system_error(std::error_code(_ERROR_CODE,std::system_category()));
+#else
+#include <sys/timerfd.h>
+#define _ThrowLinuxError auto _ERROR_CODE = errno;\
+						 throw std::system_error(std::error_code(_ERROR_CODE,std::system_category())); 
+#endif
+
+stdx::_Timer::_Timer(std::function<void()> fn)
+	:m_fn(fn)
+	,m_lock()
+	,m_cancel(false)
+	,m_fired(false)
+#ifdef WIN32
+	,m_handle(NULL)
+	,m_self()
+#else
+	,m_fd(-1)
+#endif
+{}
+
+stdx::_Timer::~_Timer()
+{}
+
+#ifdef WIN32
+void stdx::_Timer::start(uint64_t ms)
+{
+	m_self = shared_from_this();
+	if (!CreateTimerQueueTimer(&m_handle, NULL, [](PVOID param, BOOLEAN fired)
+	{
+		NO_USED(fired);
+		std::shared_ptr<stdx::_Timer> self = ((stdx::_Timer*)param)->shared_from_this();
+		stdx::threadpool.run([self]()
+		{
+			self->_Fire();
+		});
+	}, this, (DWORD)ms, 0, WT_EXECUTEONLYONCE))
+	{
+		m_self.reset();
+		_ThrowWinError
+	}
+}
+
+void stdx::_Timer::_Expire()
+{
+	ChangeTimerQueueTimer(NULL, m_handle, 0, 0);
+}
+
+void stdx::_Timer::_Fire()
+{
+	bool cancel;
+	{
+		std::unique_lock<lock_t> lock(m_lock);
+		m_fired = true;
+		cancel = m_cancel;
+	}
+	DeleteTimerQueueTimer(NULL, m_handle, NULL);
+	std::shared_ptr<self_t> self = std::move(m_self);
+	std::function<void()> fn = std::move(m_fn);
+	if (!cancel && fn)
+	{
+		fn();
+	}
+}
+#else
+void stdx::_Timer::start(uint64_t ms)
+{
+	int fd = ::timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+	if (fd == -1)
+	{
+		_ThrowLinuxError
+	}
+	itimerspec spec;
+	spec.it_interval.tv_sec = 0;
+	spec.it_interval.tv_nsec = 0;
+	spec.it_value.tv_sec = (time_t)(ms / 1000);
+	spec.it_value.tv_nsec = (long)(ms % 1000) * 1000000;
+	if (ms == 0)
+	{
+		//全0表示停止计时
+		spec.it_value.tv_nsec = 1;
+	}
+	if (::timerfd_settime(fd, 0, &spec, nullptr) == -1)
+	{
+		auto err = errno;
+		::close(fd);
+		throw std::system_error(std::error_code(err, std::system_category()));
+	}
+	{
+		std::unique_lock<lock_t> lock(m_lock);
+		m_fd = fd;
+	}
+	auto poller = stdx::threadpool.get_poller();
+	poller.bind(fd);
+	stdx::stand_context* context = new stdx::stand_context();
+	context->events = stdx::epoll_events::in;
+	context->key = fd;
+	context->is_io_operation = true;
+	context->is_persistent = false;
+	context->sock_err = 0;
+	context->io_operation = [](stdx::stand_context* cont)
+	{
+		uint64_t count = 0;
+		if (::read(cont->key, &count, sizeof(count)) == -1 && (errno == EAGAIN || errno == EWOULDBLOCK))
+		{
+			return false;
+		}
+		return true;
+	};
+	std::shared_ptr<self_t> self = shared_from_this();
+	context->execute = [self](stdx::stand_context* cont) mutable
+	{
+		//execute属于cont,释放前先取出
+		std::shared_ptr<self_t> timer = std::move(self);
+		delete cont;
+		timer->_Fire();
+	};
+	poller.post(context);
+}
+
+void stdx::_Timer::_Expire()
+{
+	itimerspec spec;
+	spec.it_interval.tv_sec = 0;
+	spec.it_interval.tv_nsec = 0;
+	spec.it_value.tv_sec = 0;
+	spec.it_value.tv_nsec = 1;
+	::timerfd_settime(m_fd, 0, &spec, nullptr);
+}
+
+void stdx::_Timer::_Fire()
+{
+	bool cancel;
+	int fd;
+	{
+		std::unique_lock<lock_t> lock(m_lock);
+		m_fired = true;
+		cancel = m_cancel;
+		fd = m_fd;
+		m_fd = -1;
+	}
+	stdx::threadpool.get_poller().unbind(fd, [](int fd)
+	{
+		::close(fd);
+	});
+	std::function<void()> fn = std::move(m_fn);
+	if (!cancel && fn)
+	{
+		fn();
+	}
+}
+#endif
+
+void stdx::_Timer::cancel()
+{
+	std::unique_lock<lock_t> lock(m_lock);
+	if (m_cancel || m_fired)
+	{
+		return;
+	}
+	m_cancel = true;
+#ifdef WIN32
+	if (m_handle)
+#else
+	if (m_fd != -1)
+#endif
+	{
+		//让计时提前结束以释放资源,回调不会执行
+		_Expire();
+	}
+}
+
+stdx::timer stdx::make_timer(uint64_t ms, std::function<void()> fn)
+{
+	std::shared_ptr<stdx::_Timer> impl = std::make_shared<stdx::_Timer>(fn);
+	impl->start(ms);
+	return stdx::timer(impl);
+}
@@ -178,3 +178,143 @@ stdx::buffer stdx::make_buffer(size_t size)
 	buf.init(size);
 	return buf;
 }
+
+stdx::output_buffer::output_buffer(size_t block_size)
+	:m_views()
+	,m_size(0)
+	,m_block_size(block_size != 0 ? block_size : 4096)
+	,m_tail_open(false)
+{}
+
+stdx::output_buffer::output_buffer(const self_t& other)
+	:m_views(other.m_views)
+	,m_size(other.m_size)
+	,m_block_size(other.m_block_size)
+	//输出块不能被两个缓存区同时写入
+	,m_tail_open(false)
+{}
+
+stdx::output_buffer::output_buffer(self_t&& other) noexcept
+	:m_views(std::move(other.m_views))
+	,m_size(other.m_size)
+	,m_block_size(other.m_block_size)
+	,m_tail_open(other.m_tail_open)
+{
+	other.m_size = 0;
+	other.m_tail_open = false;
+}
+
+typename stdx::output_buffer::self_t& stdx::output_buffer::operator=(const self_t& other)
+{
+	m_views = other.m_views;
+	m_size = other.m_size;
+	m_block_size = other.m_block_size;
+	m_tail_open = false;
+	return *this;
+}
+
+typename stdx::output_buffer::self_t& stdx::output_buffer::operator=(self_t&& other) noexcept
+{
+	m_views = std::move(other.m_views);
+	m_size = other.m_size;
+	m_block_size = other.m_block_size;
+	m_tail_open = other.m_tail_open;
+	other.m_size = 0;
+	other.m_tail_open = false;
+	return *this;
+}
+
+char* stdx::output_buffer::reserve(size_t size)
+{
+	if (m_tail_open)
+	{
+		stdx::buffer_view& tail = m_views.back();
+		if (tail.buffer.size() - tail.offset - tail.size >= size)
+		{
+			return tail.data() + tail.size;
+		}
+	}
+	//块大小按2倍增长,减少大输出的分配次数
+	size_t block_size = m_block_size;
+	if (!m_views.empty() && m_block_size < 65536)
+	{
+		m_block_size *= 2;
+	}
+	if (block_size < size)
+	{
+		block_size = size;
+	}
+	m_views.push_back(stdx::buffer_view(stdx::make_buffer(block_size), 0, 0));
+	m_tail_open = true;
+	return m_views.back().data();
+}
+
+void stdx::output_buffer::commit(size_t size)
+{
+	m_views.back().size += size;
+	m_size += size;
+}
+
+void stdx::output_buffer::append(const char* data, size_t size)
+{
+	if (size == 0)
+	{
+		return;
+	}
+	char* pos = reserve(size);
+	memcpy(pos, data, size);
+	commit(size);
+}
+
+void stdx::output_buffer::append(const char* str)
+{
+	append(str, strlen(str));
+}
+
+void stdx::output_buffer::append(const stdx::string& str)
+{
+#ifdef WIN32
+	append(str.to_u8_string());
+#else
+	//Linux的原生字符串就是UTF-8
+	append(str.c_str(), str.size());
+#endif
+}
+
+void stdx::output_buffer::append_ref(const stdx::buffer_view& view)
+{
+	if (view.size == 0)
+	{
+		return;
+	}
+	m_views.push_back(view);
+	m_size += view.size;
+	m_tail_open = false;
+}
+
+std::vector<stdx::buffer_view> stdx::output_buffer::release()
+{
+	std::vector<stdx::buffer_view> views(std::move(m_views));
+	m_views.clear();
+	m_size = 0;
+	m_tail_open = false;
+	return views;
+}
+
+std::string stdx::output_buffer::to_string() const
+{
+	std::string str;
+	str.reserve(m_size);
+	for (auto begin = m_views.begin(), end = m_views.end(); begin != end; ++begin)
+	{
+		str.append(begin->data(), begin->size);
+	}
+	return str;
+}
+
+void stdx::output_buffer::clear()
+{
+	m_views.clear();
+	m_size = 0;
+	m_tail_open = false;
+}
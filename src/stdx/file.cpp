@@ -30,7 +30,30 @@ stdx::file_enum_value_t stdx::forward_file_open_type(const stdx::file_open_type
 }
 
 stdx::_FileIOService::_FileIOService()
+#if (defined LINUX) && (defined STDX_USE_NATIVE_AIO)
+	:m_aiocp(STDX_NATIVE_AIO_EVENTS,STDX_NATIVE_AIO_BATCH)
+{
+	m_aiocp.start([](stdx::file_io_context* context, int64_t res)
+		{
+			if (res < 0)
+			{
+				context->err_code = (int)(-res);
+				context->size = 0;
+			}
+			else
+			{
+				context->size = stdx::implicit_cast<size_t>(res);
+				if (res == 0 && context->op_code == stdx::file_bio_op_code::read)
+				{
+					context->eof = true;
+				}
+			}
+			context->execute(context);
+		});
+}
+#else
 {}
+#endif
 
 
 stdx::_FileIOService::~_FileIOService()
@@ -156,6 +179,7 @@ void stdx::_FileIOService::read_file(stdx::native_file_handle file, stdx::buffer
 	ptr->buf = buf;
 	ptr->offset = offset;
 	ptr->file = file;
+	ptr->eof = false;
 	std::function<void(file_io_context*, std::exception_ptr)> call = [callback](file_io_context* context_ptr, std::exception_ptr error)
 	{
 		if (error)
@@ -180,7 +204,12 @@ void stdx::_FileIOService::read_file(stdx::native_file_handle file, stdx::buffer
 	prepare_callback(ptr);
 	try
 	{
+#ifdef STDX_USE_NATIVE_AIO
+		stdx::aio_prepare_read(&(ptr->cb), file, (char*)ptr->buf, ptr->buf.size(), stdx::implicit_cast<int64_t>(offset), m_aiocp.get_eventfd(), ptr);
+		_Submit(ptr);
+#else
 		stdx::threadpool.get_poller().post(ptr);
+#endif
 	}
 	catch (const std::exception&)
 	{
@@ -268,7 +297,12 @@ void stdx::_FileIOService::write_file(stdx::native_file_handle file, stdx::buffe
 	prepare_callback(ptr);
 	try
 	{
+#ifdef STDX_USE_NATIVE_AIO
+		stdx::aio_prepare_write(&(ptr->cb), file, (char*)ptr->buf, size, stdx::implicit_cast<int64_t>(offset), m_aiocp.get_eventfd(), ptr);
+		_Submit(ptr);
+#else
 		stdx::threadpool.get_poller().post(ptr);
+#endif
 	}
 	catch (const std::exception&)
 	{
@@ -359,6 +393,7 @@ void stdx::_FileIOService::prepare_callback(stdx::file_io_context* context)
 		{
 			return;
 		}
+#ifndef STDX_USE_NATIVE_AIO
 		ssize_t r = 0;
 		if (context->op_code == stdx::file_bio_op_code::write)
 		{
@@ -377,6 +412,8 @@ void stdx::_FileIOService::prepare_callback(stdx::file_io_context* context)
 			context->err_code = errno;
 		}
 		context->size = stdx::implicit_cast<size_t>(r);
+#endif
+		//native aio: size and err_code are set by the completion handler
 		auto callback = context->callback;
 		std::exception_ptr err(nullptr);
 		if (context->err_code)
@@ -400,6 +437,21 @@ void stdx::_FileIOService::prepare_callback(stdx::file_io_context* context)
 #endif
 }
 
+#if (defined LINUX) && (defined STDX_USE_NATIVE_AIO)
+void stdx::_FileIOService::_Submit(stdx::file_io_context* context)
+{
+	//the first queued iocb schedules a flush,later ones are coalesced into it
+	if (m_aiocp.push(&(context->cb)))
+	{
+		aiocp_t aiocp(m_aiocp);
+		stdx::threadpool.run([aiocp]() mutable
+			{
+				aiocp.flush();
+			});
+	}
+}
+#endif
+
 stdx::_FileStream::_FileStream(const io_service_t & io_service)
 	:m_io_service(io_service)
 #ifdef WIN32
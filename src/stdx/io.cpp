@@ -32,21 +32,42 @@ int stdx::io_cancel(aio_context_t ctx_id, struct iocb* iocb, struct io_event* re
 	return syscall(SYS_io_cancel, ctx_id, iocb, result);
 }
 
-void stdx::aio_read(aio_context_t context, int fd, char* buf, size_t size, int64_t offset, int resfd, void* ptr)
-{
-	iocb cbs[1], * p[1] = { &cbs[0] };
-	memset(&(cbs[0]), 0, sizeof(iocb));
-	(cbs[0]).aio_lio_opcode = IOCB_CMD_PREAD;
-	(cbs[0]).aio_fildes = fd;
-	(cbs[0]).aio_buf = (uint64_t)buf;
-	(cbs[0]).aio_nbytes = size;
-	(cbs[0]).aio_offset = offset;
-	(cbs[0]).aio_data = (uint64_t)ptr;
+void stdx::aio_prepare_read(iocb* cb, int fd, char* buf, size_t size, int64_t offset, int resfd, void* ptr)
+{
+	memset(cb, 0, sizeof(iocb));
+	cb->aio_lio_opcode = IOCB_CMD_PREAD;
+	cb->aio_fildes = fd;
+	cb->aio_buf = (uint64_t)buf;
+	cb->aio_nbytes = size;
+	cb->aio_offset = offset;
+	cb->aio_data = (uint64_t)ptr;
+	if (resfd != INVALID_EVENTFD)
+	{
+		cb->aio_flags = IOCB_FLAG_RESFD;
+		cb->aio_resfd = resfd;
+	}
+}
+
+void stdx::aio_prepare_write(iocb* cb, int fd, char* buf, size_t size, int64_t offset, int resfd, void* ptr)
+{
+	memset(cb, 0, sizeof(iocb));
+	cb->aio_lio_opcode = IOCB_CMD_PWRITE;
+	cb->aio_fildes = fd;
+	cb->aio_buf = (uint64_t)buf;
+	cb->aio_nbytes = size;
+	cb->aio_offset = offset;
+	cb->aio_data = (uint64_t)ptr;
 	if (resfd != INVALID_EVENTFD)
 	{
-		(cbs[0]).aio_flags = IOCB_FLAG_RESFD;
-		(cbs[0]).aio_resfd = resfd;
+		cb->aio_flags = IOCB_FLAG_RESFD;
+		cb->aio_resfd = resfd;
 	}
+}
+
+void stdx::aio_read(aio_context_t context, int fd, char* buf, size_t size, int64_t offset, int resfd, void* ptr)
+{
+	iocb cbs[1], * p[1] = { &cbs[0] };
+	stdx::aio_prepare_read(&(cbs[0]), fd, buf, size, offset, resfd, ptr);
 	if (stdx::io_submit(context, 1, p) != 1)
 	{
 		_ThrowLinuxError
@@ -57,18 +78,7 @@ void stdx::aio_read(aio_context_t context, int fd, char* buf, size_t size, int64
 void stdx::aio_write(aio_context_t context, int fd, char* buf, size_t size, int64_t offset, int resfd, void* ptr)
 {
 	iocb cbs[1], * p[1] = { &cbs[0] };
-	memset(&(cbs[0]), 0, sizeof(iocb));
-	(cbs[0]).aio_lio_opcode = IOCB_CMD_PWRITE;
-	(cbs[0]).aio_fildes = fd;
-	(cbs[0]).aio_buf = (uint64_t)buf;
-	(cbs[0]).aio_nbytes = size;
-	(cbs[0]).aio_offset = offset;
-	(cbs[0]).aio_data = (uint64_t)ptr;
-	if (resfd != INVALID_EVENTFD)
-	{
-		(cbs[0]).aio_flags = IOCB_FLAG_RESFD;
-		(cbs[0]).aio_resfd = resfd;
-	}
+	stdx::aio_prepare_write(&(cbs[0]), fd, buf, size, offset, resfd, ptr);
 	if (stdx::io_submit(context, 1, p) != 1)
 	{
 		_ThrowLinuxError
@@ -113,7 +123,7 @@ void stdx::_EPOLL::add_or_update_event(int fd, epoll_event* event_ptr)
 int stdx::_EPOLL::wait(epoll_event * event_ptr, const int & maxevents, const int & timeout) 
 {
 	int r = 0;
-	while (!r)
+	while (true)
 	{
 		r = epoll_wait(m_handle, event_ptr, maxevents, timeout);
 		if (r == -1)
@@ -124,8 +134,9 @@ int stdx::_EPOLL::wait(epoll_event * event_ptr, const int & maxevents, const int
 			}
 			_ThrowLinuxError
 		}
+		//0 means timeout
+		return r;
 	}
-	return r;
 }
 
 int stdx::make_eventfd(int flags)
@@ -0,0 +1,396 @@
+#include <stdx/net/buffered_socket.h>
+#include <algorithm>
+
+stdx::_BufferedSocketWriter::_BufferedSocketWriter(const stdx::socket& sock, size_t threshold)
+	:m_socket(sock)
+	,m_threshold(threshold)
+	,m_lock()
+	,m_pending()
+	,m_pending_size(0)
+	,m_tail_open(false)
+	,m_sending(false)
+	,m_flush_scheduled(false)
+	,m_error(nullptr)
+	,m_waiters()
+	,m_sending_waiters()
+{}
+
+void stdx::_BufferedSocketWriter::write(const char* data, size_t size)
+{
+	if (size == 0)
+	{
+		return;
+	}
+	std::unique_lock<lock_t> lock(m_lock);
+	if (m_error)
+	{
+		std::rethrow_exception(m_error);
+	}
+	_Append(data, size);
+	_Schedule(lock);
+}
+
+void stdx::_BufferedSocketWriter::write(stdx::buffer buf, size_t size)
+{
+	if (size == 0)
+	{
+		return;
+	}
+	if (size < STDX_WRITE_COPY_LIMIT)
+	{
+		return write((const char*)buf, size);
+	}
+	std::unique_lock<lock_t> lock(m_lock);
+	if (m_error)
+	{
+		std::rethrow_exception(m_error);
+	}
+	m_pending.push_back(stdx::buffer_view(buf, 0, size));
+	m_pending_size += size;
+	m_tail_open = false;
+	_Schedule(lock);
+}
+
+stdx::task<void> stdx::_BufferedSocketWriter::flush()
+{
+	stdx::task_completion_event<void> ce;
+	std::unique_lock<lock_t> lock(m_lock);
+	if (m_error)
+	{
+		std::exception_ptr error = m_error;
+		lock.unlock();
+		ce.set_exception(error);
+		ce.run_on_this_thread();
+		return ce.get_task();
+	}
+	if (!m_pending.empty())
+	{
+		m_waiters.push_back(ce);
+		_Send(lock);
+		return ce.get_task();
+	}
+	if (m_sending)
+	{
+		m_sending_waiters.push_back(ce);
+		return ce.get_task();
+	}
+	lock.unlock();
+	ce.set_value();
+	ce.run_on_this_thread();
+	return ce.get_task();
+}
+
+size_t stdx::_BufferedSocketWriter::pending_size()
+{
+	std::unique_lock<lock_t> lock(m_lock);
+	return m_pending_size;
+}
+
+void stdx::_BufferedSocketWriter::_Append(const char* data, size_t size)
+{
+	while (size != 0)
+	{
+		if (m_tail_open)
+		{
+			stdx::buffer_view& tail = m_pending.back();
+			size_t free_size = tail.buffer.size() - tail.offset - tail.size;
+			if (free_size != 0)
+			{
+				size_t n = (std::min)(free_size, size);
+				memcpy(tail.data() + tail.size, data, n);
+				tail.size += n;
+				m_pending_size += n;
+				data += n;
+				size -= n;
+				continue;
+			}
+		}
+		stdx::buffer buf = stdx::make_buffer((std::max)((size_t)STDX_WRITE_BUFFER_SIZE, size));
+		m_pending.push_back(stdx::buffer_view(buf, 0, 0));
+		m_tail_open = true;
+	}
+}
+
+void stdx::_BufferedSocketWriter::_Schedule(std::unique_lock<lock_t>& lock)
+{
+	if (m_sending)
+	{
+		//发送完成后会接着发送新的数据
+		return;
+	}
+	if (m_pending_size >= m_threshold)
+	{
+		_Send(lock);
+		return;
+	}
+	if (m_flush_scheduled)
+	{
+		return;
+	}
+	m_flush_scheduled = true;
+	lock.unlock();
+	std::weak_ptr<self_t> weak = shared_from_this();
+	//排在事件循环当前的任务之后,同一轮的写入合并为一次发送
+	stdx::threadpool.run([weak]()
+	{
+		std::shared_ptr<self_t> self = weak.lock();
+		if (!self)
+		{
+			return;
+		}
+		std::unique_lock<lock_t> lock(self->m_lock);
+		self->m_flush_scheduled = false;
+		self->_Send(lock);
+	});
+}
+
+void stdx::_BufferedSocketWriter::_Send(std::unique_lock<lock_t>& lock)
+{
+	if (m_sending || m_pending.empty())
+	{
+		return;
+	}
+	m_sending = true;
+	std::vector<stdx::buffer_view> bufs;
+	std::swap(bufs, m_pending);
+	m_sending_waiters = std::move(m_waiters);
+	m_waiters.clear();
+	m_pending_size = 0;
+	m_tail_open = false;
+	lock.unlock();
+	std::shared_ptr<self_t> self = shared_from_this();
+	m_socket.send(std::move(bufs)).then([self](stdx::task_result<stdx::network_send_event> r)
+	{
+		try
+		{
+			r.get();
+			self->_OnSent(nullptr);
+		}
+		catch (const std::exception&)
+		{
+			self->_OnSent(std::current_exception());
+		}
+	});
+}
+
+void stdx::_BufferedSocketWriter::_OnSent(std::exception_ptr error)
+{
+	std::unique_lock<lock_t> lock(m_lock);
+	m_sending = false;
+	std::vector<stdx::task_completion_event<void>> waiters = std::move(m_sending_waiters);
+	m_sending_waiters.clear();
+	if (error)
+	{
+		m_error = error;
+		//后续的数据不会再发送
+		for (auto begin = m_waiters.begin(), end = m_waiters.end(); begin != end; ++begin)
+		{
+			waiters.push_back(*begin);
+		}
+		m_waiters.clear();
+		m_pending.clear();
+		m_pending_size = 0;
+		m_tail_open = false;
+		lock.unlock();
+	}
+	else
+	{
+		_Send(lock);
+	}
+	for (auto begin = waiters.begin(), end = waiters.end(); begin != end; ++begin)
+	{
+		if (error)
+		{
+			begin->set_exception(error);
+		}
+		else
+		{
+			begin->set_value();
+		}
+		begin->run_on_this_thread();
+	}
+}
+
+stdx::buffered_socket_writer stdx::make_buffered_socket_writer(const stdx::socket& sock, size_t threshold)
+{
+	return stdx::buffered_socket_writer(std::make_shared<stdx::_BufferedSocketWriter>(sock, threshold));
+}
+
+stdx::_BufferedSocketReader::_BufferedSocketReader(const stdx::socket& sock, size_t size, size_t max_size)
+	:m_socket(sock)
+	,m_buf(stdx::make_buffer(size))
+	,m_begin(0)
+	,m_end(0)
+	,m_max_size((std::max)(size, max_size))
+{}
+
+stdx::task<stdx::buffer_view> stdx::_BufferedSocketReader::read_until(const std::string& delimiter)
+{
+	stdx::task_completion_event<stdx::buffer_view> ce;
+	if (delimiter.empty())
+	{
+		ce.set_exception(std::make_exception_ptr(std::invalid_argument("delimiter can not be empty")));
+		ce.run_on_this_thread();
+		return ce.get_task();
+	}
+	_ReadUntil(delimiter, 0, ce);
+	return ce.get_task();
+}
+
+stdx::task<stdx::buffer_view> stdx::_BufferedSocketReader::read_exact(size_t size)
+{
+	stdx::task_completion_event<stdx::buffer_view> ce;
+	if (size > m_max_size)
+	{
+		ce.set_exception(std::make_exception_ptr(std::length_error("read size is larger than the max buffer size")));
+		ce.run_on_this_thread();
+		return ce.get_task();
+	}
+	_ReadExact(size, ce);
+	return ce.get_task();
+}
+
+stdx::task<stdx::buffer_view> stdx::_BufferedSocketReader::read_some()
+{
+	stdx::task_completion_event<stdx::buffer_view> ce;
+	if (m_begin != m_end)
+	{
+		ce.set_value(_Take(m_end - m_begin));
+		ce.run_on_this_thread();
+		return ce.get_task();
+	}
+	std::shared_ptr<self_t> self = shared_from_this();
+	_Fill([self, ce](std::exception_ptr error) mutable
+	{
+		if (error)
+		{
+			ce.set_exception(error);
+		}
+		else
+		{
+			ce.set_value(self->_Take(self->m_end - self->m_begin));
+		}
+		ce.run_on_this_thread();
+	});
+	return ce.get_task();
+}
+
+stdx::buffer_view stdx::_BufferedSocketReader::_Take(size_t size)
+{
+	stdx::buffer_view view(m_buf, m_begin, size);
+	m_begin += size;
+	if (m_begin == m_end)
+	{
+		m_begin = 0;
+		m_end = 0;
+	}
+	return view;
+}
+
+bool stdx::_BufferedSocketReader::_Reserve(size_t size)
+{
+	if (m_buf.size() - m_begin >= size)
+	{
+		return true;
+	}
+	size_t used = m_end - m_begin;
+	if (m_buf.size() >= size)
+	{
+		//移到缓冲区头部
+		memmove((char*)m_buf, (char*)m_buf + m_begin, used);
+	}
+	else
+	{
+		if (size > m_max_size)
+		{
+			return false;
+		}
+		size_t new_size = (std::min)((std::max)(m_buf.size() * 2, size), m_max_size);
+		stdx::buffer buf = stdx::make_buffer(new_size);
+		memcpy((char*)buf, (char*)m_buf + m_begin, used);
+		m_buf = buf;
+	}
+	m_begin = 0;
+	m_end = used;
+	return true;
+}
+
+void stdx::_BufferedSocketReader::_Fill(std::function<void(std::exception_ptr)> callback)
+{
+	if (m_end == m_buf.size() && !_Reserve(m_end - m_begin + 1))
+	{
+		callback(std::make_exception_ptr(std::length_error("data is larger than the max buffer size")));
+		return;
+	}
+	std::vector<stdx::buffer_view> bufs;
+	bufs.push_back(stdx::buffer_view(m_buf, m_end, m_buf.size() - m_end));
+	std::shared_ptr<self_t> self = shared_from_this();
+	m_socket.recv(std::move(bufs)).then([self, callback](stdx::task_result<stdx::network_recv_event> r)
+	{
+		std::exception_ptr error(nullptr);
+		try
+		{
+			self->m_end += r.get().size;
+		}
+		catch (const std::exception&)
+		{
+			error = std::current_exception();
+		}
+		callback(error);
+	});
+}
+
+void stdx::_BufferedSocketReader::_ReadUntil(std::string delimiter, size_t scanned, stdx::task_completion_event<stdx::buffer_view> ce)
+{
+	//从上次扫描的位置继续,scanned相对m_begin
+	const char* begin = (const char*)m_buf + m_begin;
+	const char* end = (const char*)m_buf + m_end;
+	size_t back = delimiter.size() - 1;
+	const char* from = begin + (scanned > back ? scanned - back : 0);
+	const char* pos = std::search(from, end, delimiter.begin(), delimiter.end());
+	if (pos != end)
+	{
+		ce.set_value(_Take((pos - begin) + delimiter.size()));
+		ce.run_on_this_thread();
+		return;
+	}
+	scanned = m_end - m_begin;
+	std::shared_ptr<self_t> self = shared_from_this();
+	_Fill([self, delimiter, scanned, ce](std::exception_ptr error) mutable
+	{
+		if (error)
+		{
+			ce.set_exception(error);
+			ce.run_on_this_thread();
+			return;
+		}
+		self->_ReadUntil(delimiter, scanned, ce);
+	});
+}
+
+void stdx::_BufferedSocketReader::_ReadExact(size_t size, stdx::task_completion_event<stdx::buffer_view> ce)
+{
+	if (m_end - m_begin >= size)
+	{
+		ce.set_value(_Take(size));
+		ce.run_on_this_thread();
+		return;
+	}
+	_Reserve(size);
+	std::shared_ptr<self_t> self = shared_from_this();
+	_Fill([self, size, ce](std::exception_ptr error) mutable
+	{
+		if (error)
+		{
+			ce.set_exception(error);
+			ce.run_on_this_thread();
+			return;
+		}
+		self->_ReadExact(size, ce);
+	});
+}
+
+stdx::buffered_socket_reader stdx::make_buffered_socket_reader(const stdx::socket& sock, size_t size, size_t max_size)
+{
+	return stdx::buffered_socket_reader(std::make_shared<stdx::_BufferedSocketReader>(sock, size, max_size));
+}
@@ -0,0 +1,315 @@
+#include <stdx/net/connection_pool.h>
+#include <stdx/datetime.h>
+
+stdx::_ConnectionPool::_ConnectionPool(const stdx::network_io_service& io_service, size_t max_per_host, uint64_t idle_timeout_ms)
+	:m_io_service(io_service)
+	,m_max_per_host(max_per_host != 0 ? max_per_host : 1)
+	,m_idle_timeout(idle_timeout_ms)
+	,m_lock()
+	,m_hosts()
+	,m_token()
+	,m_evict_armed(false)
+	,m_evict_timer()
+{}
+
+stdx::_ConnectionPool::~_ConnectionPool()
+{
+	close();
+}
+
+std::string stdx::_ConnectionPool::_Key(const stdx::socket_addr& addr)
+{
+	return std::string((const char*)addr.data(), addr.length());
+}
+
+stdx::task<stdx::socket> stdx::_ConnectionPool::get(const stdx::socket_addr& addr)
+{
+	stdx::task_completion_event<stdx::socket> ce;
+	if (m_token.is_cancel())
+	{
+		ce.set_exception(std::make_exception_ptr(std::logic_error("connection pool is closed")));
+		ce.run_on_this_thread();
+		return ce.get_task();
+	}
+	std::vector<stdx::socket> expired;
+	uint64_t now = stdx::get_tick_count();
+	std::unique_lock<lock_t> lock(m_lock);
+	host_t& host = m_hosts[_Key(addr)];
+	while (!host.idle.empty())
+	{
+		host_t::idle_connection conn = host.idle.back();
+		host.idle.pop_back();
+		if ((now - conn.release_tick < m_idle_timeout) && conn.sock.is_idle_alive())
+		{
+			lock.unlock();
+			for (auto begin = expired.begin(), end = expired.end(); begin != end; ++begin)
+			{
+				begin->close();
+			}
+			ce.set_value(conn.sock);
+			ce.run_on_this_thread();
+			return ce.get_task();
+		}
+		expired.push_back(conn.sock);
+		host.count -= 1;
+	}
+	bool connect = false;
+	if (host.count < m_max_per_host)
+	{
+		host.count += 1;
+		connect = true;
+	}
+	else
+	{
+		host.waiters.push(ce);
+	}
+	lock.unlock();
+	for (auto begin = expired.begin(), end = expired.end(); begin != end; ++begin)
+	{
+		begin->close();
+	}
+	if (connect)
+	{
+		_Connect(addr, ce);
+	}
+	return ce.get_task();
+}
+
+void stdx::_ConnectionPool::release(const stdx::socket_addr& addr, stdx::socket sock, bool reusable)
+{
+	if (reusable && !m_token.is_cancel() && sock.is_idle_alive())
+	{
+		std::unique_lock<lock_t> lock(m_lock);
+		auto it = m_hosts.find(_Key(addr));
+		if (it != m_hosts.end())
+		{
+			host_t& host = it->second;
+			if (!host.waiters.empty())
+			{
+				//直接交给等待者
+				stdx::task_completion_event<stdx::socket> ce = host.waiters.front();
+				host.waiters.pop();
+				lock.unlock();
+				ce.set_value(sock);
+				ce.run_on_this_thread();
+				return;
+			}
+			host_t::idle_connection conn;
+			conn.sock = sock;
+			conn.release_tick = stdx::get_tick_count();
+			host.idle.push_back(conn);
+			if (m_evict_armed)
+			{
+				return;
+			}
+			m_evict_armed = true;
+			lock.unlock();
+			_ArmEvict(m_idle_timeout);
+			return;
+		}
+	}
+	sock.close();
+	_OnClosed(addr);
+}
+
+void stdx::_ConnectionPool::evict_idle()
+{
+	std::vector<stdx::socket> expired;
+	uint64_t now = stdx::get_tick_count();
+	std::unique_lock<lock_t> lock(m_lock);
+	for (auto it = m_hosts.begin(); it != m_hosts.end();)
+	{
+		host_t& host = it->second;
+		//头部是最早归还的连接
+		while (!host.idle.empty() && (now - host.idle.front().release_tick >= m_idle_timeout))
+		{
+			expired.push_back(host.idle.front().sock);
+			host.idle.pop_front();
+			host.count -= 1;
+		}
+		if (host.count == 0 && host.waiters.empty())
+		{
+			it = m_hosts.erase(it);
+		}
+		else
+		{
+			++it;
+		}
+	}
+	lock.unlock();
+	for (auto begin = expired.begin(), end = expired.end(); begin != end; ++begin)
+	{
+		begin->close();
+	}
+}
+
+size_t stdx::_ConnectionPool::idle_count(const stdx::socket_addr& addr)
+{
+	std::unique_lock<lock_t> lock(m_lock);
+	auto it = m_hosts.find(_Key(addr));
+	if (it == m_hosts.end())
+	{
+		return 0;
+	}
+	return it->second.idle.size();
+}
+
+void stdx::_ConnectionPool::close()
+{
+	m_token.cancel();
+	std::vector<stdx::socket> idle;
+	std::vector<stdx::task_completion_event<stdx::socket>> waiters;
+	std::unique_lock<lock_t> lock(m_lock);
+	if (m_evict_timer)
+	{
+		m_evict_timer.cancel();
+		m_evict_timer = stdx::timer();
+	}
+	for (auto it = m_hosts.begin(), end = m_hosts.end(); it != end; ++it)
+	{
+		host_t& host = it->second;
+		for (auto begin = host.idle.begin(), idle_end = host.idle.end(); begin != idle_end; ++begin)
+		{
+			idle.push_back(begin->sock);
+		}
+		while (!host.waiters.empty())
+		{
+			waiters.push_back(host.waiters.front());
+			host.waiters.pop();
+		}
+	}
+	m_hosts.clear();
+	lock.unlock();
+	for (auto begin = idle.begin(), end = idle.end(); begin != end; ++begin)
+	{
+		begin->close();
+	}
+	std::exception_ptr error = std::make_exception_ptr(std::logic_error("connection pool is closed"));
+	for (auto begin = waiters.begin(), end = waiters.end(); begin != end; ++begin)
+	{
+		begin->set_exception(error);
+		begin->run_on_this_thread();
+	}
+}
+
+void stdx::_ConnectionPool::_ArmEvict(uint64_t ms)
+{
+	std::weak_ptr<self_t> weak = shared_from_this();
+	stdx::timer timer;
+	try
+	{
+		timer = stdx::make_timer(ms, [weak]()
+		{
+			std::shared_ptr<self_t> self = weak.lock();
+			if (self)
+			{
+				self->_OnEvictTimer();
+			}
+		});
+	}
+	catch (const std::exception& err)
+	{
+		DBG_VAR(err);
+#ifdef DEBUG
+		::printf("[ConnectionPool]Start evict timer fail: %s\n", err.what());
+#endif
+		//下次归还连接时重试
+		std::unique_lock<lock_t> lock(m_lock);
+		m_evict_armed = false;
+		return;
+	}
+	std::unique_lock<lock_t> lock(m_lock);
+	m_evict_timer = timer;
+	//close先取消token再取消定时器,两边至少有一边能看到对方
+	if (m_token.is_cancel())
+	{
+		m_evict_timer = stdx::timer();
+		lock.unlock();
+		timer.cancel();
+	}
+}
+
+void stdx::_ConnectionPool::_OnEvictTimer()
+{
+	evict_idle();
+	std::unique_lock<lock_t> lock(m_lock);
+	m_evict_timer = stdx::timer();
+	uint64_t oldest = 0;
+	bool has_idle = false;
+	for (auto it = m_hosts.begin(), end = m_hosts.end(); it != end; ++it)
+	{
+		host_t& host = it->second;
+		if (!host.idle.empty() && (!has_idle || host.idle.front().release_tick < oldest))
+		{
+			oldest = host.idle.front().release_tick;
+			has_idle = true;
+		}
+	}
+	if (!has_idle || m_token.is_cancel())
+	{
+		m_evict_armed = false;
+		return;
+	}
+	lock.unlock();
+	uint64_t now = stdx::get_tick_count();
+	uint64_t due = oldest + m_idle_timeout;
+	_ArmEvict(due > now ? due - now : 0);
+}
+
+void stdx::_ConnectionPool::_Connect(const stdx::socket_addr& addr, stdx::task_completion_event<stdx::socket> ce)
+{
+	std::shared_ptr<self_t> self = shared_from_this();
+	stdx::socket sock;
+	try
+	{
+		sock = stdx::open_socket(m_io_service, addr, stdx::socket_type::stream);
+	}
+	catch (const std::exception&)
+	{
+		ce.set_exception(std::current_exception());
+		ce.run_on_this_thread();
+		_OnClosed(addr);
+		return;
+	}
+	sock.connect(addr).then([self, addr, sock, ce](stdx::task_result<void> r) mutable
+	{
+		try
+		{
+			r.get();
+			ce.set_value(sock);
+		}
+		catch (const std::exception&)
+		{
+			sock.close();
+			ce.set_exception(std::current_exception());
+			self->_OnClosed(addr);
+		}
+		ce.run_on_this_thread();
+	});
+}
+
+void stdx::_ConnectionPool::_OnClosed(const stdx::socket_addr& addr)
+{
+	std::unique_lock<lock_t> lock(m_lock);
+	auto it = m_hosts.find(_Key(addr));
+	if (it == m_hosts.end())
+	{
+		return;
+	}
+	host_t& host = it->second;
+	if (host.waiters.empty())
+	{
+		host.count -= 1;
+		return;
+	}
+	//名额转给等待者
+	stdx::task_completion_event<stdx::socket> ce = host.waiters.front();
+	host.waiters.pop();
+	lock.unlock();
+	_Connect(addr, ce);
+}
+
+stdx::connection_pool stdx::make_connection_pool(const stdx::network_io_service& io_service, size_t max_per_host, uint64_t idle_timeout_ms)
+{
+	return stdx::connection_pool(std::make_shared<stdx::_ConnectionPool>(io_service, max_per_host, idle_timeout_ms));
+}
@@ -1,4 +1,6 @@
 ﻿#include <stdx/net/http.h>
+#include <thread>
+#include <algorithm>
 
 stdx::http_cookie::http_cookie()
 	:m_name()
@@ -557,22 +559,40 @@ void stdx::http_cache_control::set_cache_type(stdx::http_cache_control_type type
 stdx::http_header::http_header()
 	:m_version(stdx::http_version::http_1_1)
 	,m_headers()
+	,m_raw(nullptr)
+	,m_raw_fields()
+	,m_raw_state(raw_none)
 {}
 
 stdx::http_header::http_header(stdx::http_version version)
 	: m_version(version)
 	, m_headers()
+	, m_raw(nullptr)
+	, m_raw_fields()
+	, m_raw_state(raw_none)
 {}
 
 stdx::http_header::http_header(const stdx::http_header& other)
 	:m_version(other.m_version)
-	,m_headers(other.m_headers)
-{}
+	,m_headers()
+	,m_raw(nullptr)
+	,m_raw_fields()
+	,m_raw_state(raw_none)
+{
+	//other可能正在被其他线程转换,先完成转换再复制(派生类的成员也在转换时写入)
+	other._Materialize();
+	m_headers = other.m_headers;
+}
 
 stdx::http_header::http_header(stdx::http_header&& other) noexcept
 	:m_version(std::move(other.m_version))
 	,m_headers(std::move(other.m_headers))
-{}
+	,m_raw(std::move(other.m_raw))
+	,m_raw_fields(std::move(other.m_raw_fields))
+	,m_raw_state(other.m_raw_state.load())
+{
+	other.m_raw_state = raw_none;
+}
 
 stdx::http_header& stdx::http_header::operator=(const stdx::http_header &other)
 {
@@ -585,11 +605,16 @@ stdx::http_header& stdx::http_header::operator=(stdx::http_header&& other) noexc
 {
 	m_version = std::move(other.m_version);
 	m_headers = std::move(other.m_headers);
+	m_raw = std::move(other.m_raw);
+	m_raw_fields = std::move(other.m_raw_fields);
+	m_raw_state = other.m_raw_state.load();
+	other.m_raw_state = raw_none;
 	return *this;
 }
 
 stdx::string stdx::http_header::to_string() const
 {
+	_Materialize();
 	stdx::string str;
 	for (auto begin = m_headers.begin(),end = m_headers.end();begin != end;begin++)
 	{
@@ -601,6 +626,18 @@ stdx::string stdx::http_header::to_string() const
 	return str;
 }
 
+void stdx::http_header::serialize_into(stdx::output_buffer& out) const
+{
+	_Materialize();
+	for (auto begin = m_headers.begin(), end = m_headers.end(); begin != end; begin++)
+	{
+		out.append(begin->first);
+		out.append(": ", 2);
+		out.append(begin->second);
+		out.append("\r\n", 2);
+	}
+}
+
 const stdx::http_version& stdx::http_header::version() const
 {
 	return m_version;
@@ -613,6 +650,7 @@ stdx::http_version& stdx::http_header::version()
 
 stdx::http_header& stdx::http_header::add_header(stdx::string&& name,stdx::string&& value)
 {
+	_Materialize();
 	if (name.empty())
 	{
 		throw std::invalid_argument("name could not be empty");
@@ -635,6 +673,7 @@ stdx::http_header& stdx::http_header::add_header(stdx::string&& name,stdx::strin
 
 stdx::http_header& stdx::http_header::add_header(const stdx::string& name, const stdx::string& value)
 {
+	_Materialize();
 	if (name.empty())
 	{
 		throw std::invalid_argument("name could not be empty");
@@ -654,6 +693,7 @@ stdx::http_header& stdx::http_header::add_header(const stdx::string& name, const
 
 stdx::http_header& stdx::http_header::remove_header(stdx::string&& name)
 {
+	_Materialize();
 	if (name.empty())
 	{
 		throw std::invalid_argument("name could not be empty");
@@ -668,6 +708,7 @@ stdx::http_header& stdx::http_header::remove_header(stdx::string&& name)
 
 stdx::http_header& stdx::http_header::remove_header(const stdx::string& name)
 {
+	_Materialize();
 	if (name.empty())
 	{
 		throw std::invalid_argument("name could not be empty");
@@ -687,17 +728,21 @@ stdx::http_header& stdx::http_header::add_header(const stdx::string& raw_string)
 	{
 		throw std::invalid_argument("raw string could not be empty");
 	}
-	std::list<stdx::string> &&list = raw_string.split(U(":"));
-	if (list.size() < 2)
+	//只按第一个':'分割,值中可以包含':'(例如Host: localhost:8080)
+	size_t pos = raw_string.find(U(':'));
+	if (pos == stdx::string::npos || pos == 0)
 	{
 		throw std::invalid_argument("invalid raw string");
 	}
-	add_header(list.front(), list.back());
+	stdx::string name = raw_string.substr(0, pos);
+	stdx::string value = raw_string.substr(pos + 1, raw_string.size() - pos - 1);
+	add_header(std::move(name), std::move(value));
 	return *this;
 }
 
 const stdx::string& stdx::http_header::operator[](const stdx::string& name) const
 {
+	_Materialize();
 	if (name.back() == U(' '))
 	{
 		stdx::string tmp(name);
@@ -708,6 +753,7 @@ const stdx::string& stdx::http_header::operator[](const stdx::string& name) cons
 
 stdx::string& stdx::http_header::operator[](const stdx::string& name)
 {
+	_Materialize();
 	if (name.back() == U(' '))
 	{
 		stdx::string tmp(name);
@@ -718,6 +764,7 @@ stdx::string& stdx::http_header::operator[](const stdx::string& name)
 
 const stdx::string& stdx::http_header::operator[](stdx::string&& name) const
 {
+	_Materialize();
 	if (name.back() == U(' '))
 	{
 		name.erase_back();
@@ -727,6 +774,7 @@ const stdx::string& stdx::http_header::operator[](stdx::string&& name) const
 
 stdx::string& stdx::http_header::operator[](stdx::string&& name)
 {
+	_Materialize();
 	if (name.back() == U(' '))
 	{
 		name.erase_back();
@@ -736,6 +784,7 @@ stdx::string& stdx::http_header::operator[](stdx::string&& name)
 
 bool stdx::http_header::exist(const stdx::string& name) const
 {
+	_Materialize();
 	if (name.back() == U(' '))
 	{
 		stdx::string tmp(name);
@@ -746,6 +795,7 @@ bool stdx::http_header::exist(const stdx::string& name) const
 
 bool stdx::http_header::exist(stdx::string&& name) const
 {
+	_Materialize();
 	if (name.back() == U(' '))
 	{
 		name.erase_back();
@@ -756,35 +806,53 @@ bool stdx::http_header::exist(stdx::string&& name) const
 void stdx::http_header::clear()
 {
 	m_headers.clear();
+	m_raw.reset();
+	m_raw_fields.clear();
+	m_raw_state = raw_none;
 }
 
 size_t stdx::http_header::size() const
 {
+	_Materialize();
 	return m_headers.size();
 }
 
 typename stdx::http_header::iterator_t stdx::http_header::begin()
 {
+	_Materialize();
 	return m_headers.begin();
 }
 
 typename stdx::http_header::const_iterator_t stdx::http_header::cbegin() const
 {
+	_Materialize();
 	return m_headers.cbegin();
 }
 
 typename stdx::http_header::iterator_t stdx::http_header::end()
 {
+	_Materialize();
 	return m_headers.end();
 }
 
 typename stdx::http_header::const_iterator_t stdx::http_header::cend()
 {
+	_Materialize();
 	return m_headers.cend();
 }
 
 bool stdx::http_header::is_keepalive() const
 {
+	if (m_raw_state.load(std::memory_order_acquire) != raw_none)
+	{
+		std::string connection;
+		bool exist = raw_value("Connection", connection);
+		if (m_version == stdx::http_version::http_1_0)
+		{
+			return exist;
+		}
+		return !exist || connection != "close";
+	}
 	auto i = m_headers.find(U("Connection")),end = m_headers.end();
 	if (m_version == stdx::http_version::http_1_0)
 	{
@@ -806,18 +874,112 @@ bool stdx::http_header::is_keepalive() const
 	return true;
 }
 
+void stdx::http_header::assign_raw(const std::shared_ptr<std::string>& raw, std::vector<stdx::http_raw_field>&& fields)
+{
+	m_headers.clear();
+	m_raw = raw;
+	m_raw_fields = std::move(fields);
+	m_raw_state = raw ? raw_pending : raw_none;
+}
+
+bool stdx::http_header::raw_value(const std::string& name, std::string& value) const
+{
+	//转换完成后以m_headers为准(之后可能被修改),转换前后m_raw都不会改变
+	if (m_raw_state.load(std::memory_order_acquire) == raw_none)
+	{
+		stdx::string key = stdx::string::from_u8_string(name);
+		auto it = m_headers.find(key);
+		if (it == m_headers.end())
+		{
+			return false;
+		}
+		value = it->second.to_u8_string();
+		return true;
+	}
+	const char* raw = m_raw->c_str();
+	for (auto begin = m_raw_fields.begin(), end = m_raw_fields.end(); begin != end; ++begin)
+	{
+		if (begin->name_size != name.size())
+		{
+			continue;
+		}
+		const char* field_name = raw + begin->name_offset;
+		size_t i = 0;
+		while (i < name.size() && ((field_name[i] | 0x20) == (name[i] | 0x20)))
+		{
+			i += 1;
+		}
+		if (i == name.size())
+		{
+			value.assign(raw + begin->value_offset, begin->value_size);
+			return true;
+		}
+	}
+	return false;
+}
+
+void stdx::http_header::_Materialize() const
+{
+	if (m_raw_state.load(std::memory_order_acquire) == raw_none)
+	{
+		return;
+	}
+	int expected = raw_pending;
+	while (!m_raw_state.compare_exchange_weak(expected, raw_converting, std::memory_order_acquire))
+	{
+		if (expected == raw_none)
+		{
+			return;
+		}
+		//其他线程正在转换
+		std::this_thread::yield();
+		expected = raw_pending;
+	}
+	try
+	{
+		for (auto begin = m_raw_fields.begin(), end = m_raw_fields.end(); begin != end; ++begin)
+		{
+			//忽略空值,与add_header的行为一致
+			if (begin->value_size == 0)
+			{
+				continue;
+			}
+			stdx::string name = stdx::string::from_u8_string(m_raw->substr(begin->name_offset, begin->name_size));
+			stdx::string value = stdx::string::from_u8_string(m_raw->substr(begin->value_offset, begin->value_size));
+			_AddRawHeader(std::move(name), std::move(value));
+		}
+	}
+	catch (...)
+	{
+		m_headers.clear();
+		m_raw_state.store(raw_pending, std::memory_order_release);
+		throw;
+	}
+	m_raw_state.store(raw_none, std::memory_order_release);
+}
+
+void stdx::http_header::_AddRawHeader(stdx::string&& name, stdx::string&& value) const
+{
+	m_headers.emplace(std::move(name), std::move(value));
+}
+
 stdx::string stdx::http_version_string(stdx::http_version version)
+{
+	return stdx::string::from_u8_string(stdx::http_u8_version_string(version));
+}
+
+const char* stdx::http_u8_version_string(stdx::http_version version)
 {
 	switch (version)
 	{
 	case stdx::http_version::http_1_0:
-		return U("HTTP/1.0");
+		return "HTTP/1.0";
 	case stdx::http_version::http_1_1:
-		return U("HTTP/1.1");
+		return "HTTP/1.1";
 	case stdx::http_version::http_2_0:
-		return U("HTTP/2.0");
+		return "HTTP/2.0";
 	default:
-		return U("HTTP/1.1");
+		return "HTTP/1.1";
 	}
 }
 
@@ -839,120 +1001,292 @@ stdx::http_version stdx::make_http_version_by_string(const stdx::string& str)
 }
 
 stdx::string stdx::http_status_message(stdx::http_status_code_t code)
+{
+	return stdx::string::from_u8_string(stdx::http_u8_status_message(code));
+}
+
+const char* stdx::http_u8_status_message(stdx::http_status_code_t code)
 {
 	switch (code)
 	{
 	case 100:
-		return U("Continue");
+		return "Continue";
 	case 200:
-		return U("OK");
+		return "OK";
 	case 101:
-		return U("Switching Protocol");
+		return "Switching Protocol";
 	case 103:
-		return U("Early Hints");
+		return "Early Hints";
 	case 201:
-		return U("Created");
+		return "Created";
 	case 202:
-		return U("Accept");
+		return "Accept";
 	case 203:
-		return U("Non-Authoritative Information");
+		return "Non-Authoritative Information";
 	case 204:
-		return U("No Content");
+		return "No Content";
 	case 205:
-		return U("Reset Content");
+		return "Reset Content";
 	case 206:
-		return U("Partial Content");
+		return "Partial Content";
 	case 300:
-		return U("Multiple Choices");
+		return "Multiple Choices";
 	case 301:
-		return U("Moved Permanently");
+		return "Moved Permanently";
 	case 302:
-		return U("Found");
+		return "Found";
 	case 303:
-		return U("See Other");
+		return "See Other";
 	case 304:
-		return U("Not Modified");
+		return "Not Modified";
 	case 307:
-		return U("Temporary Redirect");
+		return "Temporary Redirect";
 	case 308:
-		return U("Permanent Redirect");
+		return "Permanent Redirect";
 	case 400:
-		return U("Bad Request");
+		return "Bad Request";
 	case 401:
-		return U("Unauthorized");
+		return "Unauthorized";
 	case 402:
-		return U("Payment Required");
+		return "Payment Required";
 	case 403:
-		return U("Forbidden");
+		return "Forbidden";
 	case 404:
-		return U("Not Found");
+		return "Not Found";
 	case 405:
-		return U("Method Not Allowed");
+		return "Method Not Allowed";
 	case 406:
-		return U("Not Acceptable");
+		return "Not Acceptable";
 	case 407:
-		return U("Proxy Authentication Required");
+		return "Proxy Authentication Required";
 	case 408:
-		return U("Request Timeout");
+		return "Request Timeout";
 	case 409:
-		return U("Conflict");
+		return "Conflict";
 	case 410:
-		return U("Gone");
+		return "Gone";
 	case 411:
-		return U("Length Required");
+		return "Length Required";
 	case 412:
-		return U("Precondition Failed");
+		return "Precondition Failed";
 	case 413:
-		return U("Payload Too Large");
+		return "Payload Too Large";
 	case 414:
-		return U("URI Too Long");
+		return "URI Too Long";
 	case 415:
-		return U("Unsupported Media Type");
+		return "Unsupported Media Type";
 	case 416:
-		return U("Range Not Satisfiable");
+		return "Range Not Satisfiable";
 	case 417:
-		return U("Expectation Failed");
+		return "Expectation Failed";
 	case 418:
-		return U("I'm a teapot");
+		return "I'm a teapot";
 	case 422:
-		return U("Unprocessable Entity");
+		return "Unprocessable Entity";
 	case 425:
-		return U("Too Early");
+		return "Too Early";
 	case 426:
-		return U("Upgrade Required");
+		return "Upgrade Required";
 	case 428:
-		return U("Precondition Required");
+		return "Precondition Required";
 	case 429:
-		return U("Too Many Requests");
+		return "Too Many Requests";
 	case 431:
-		return U("Request Header Fields Too Large");
+		return "Request Header Fields Too Large";
 	case 451:
-		return U("Unavailable For Legal Reasons");
+		return "Unavailable For Legal Reasons";
 	case 500:
-		return U("Internal Server Error");
+		return "Internal Server Error";
 	case 501:
-		return U("Not Implemented");
+		return "Not Implemented";
 	case 502:
-		return U("Bad Gateway");
+		return "Bad Gateway";
 	case 503:
-		return U("Service Unavailable");
+		return "Service Unavailable";
 	case 504:
-		return U("Gateway Timeout");
+		return "Gateway Timeout";
 	case 505:
-		return U("HTTP Version Not Supported");
+		return "HTTP Version Not Supported";
 	case 506:
-		return U("Variant Also Negotiates");
+		return "Variant Also Negotiates";
 	case 507:
-		return U("Insufficient Storage");
+		return "Insufficient Storage";
 	case 508:
-		return U("Loop Detected");
+		return "Loop Detected";
 	case 510:
-		return U("Not Extended");
+		return "Not Extended";
 	case 511:
-		return U("Network Authentication Required");
+		return "Network Authentication Required";
 	default:
-		return U("Unkown Status Code Message");
+		return "Unkown Status Code Message";
+	}
+}
+
+namespace stdx
+{
+	struct _HttpStatusLineTable
+	{
+		_HttpStatusLineTable()
+		{
+			const stdx::http_version versions[3] = { stdx::http_version::http_1_0,stdx::http_version::http_1_1,stdx::http_version::http_2_0 };
+			for (size_t i = 0; i < 3; ++i)
+			{
+				lines[i].reserve(500);
+				for (stdx::http_status_code_t code = 100; code < 600; ++code)
+				{
+					std::string line(stdx::http_u8_version_string(versions[i]));
+					line.push_back(' ');
+					line.append(std::to_string(code));
+					line.push_back(' ');
+					line.append(stdx::http_u8_status_message(code));
+					line.append("\r\n");
+					lines[i].push_back(std::move(line));
+				}
+			}
+		}
+
+		std::vector<std::string> lines[3];
+	};
+}
+
+const char* stdx::http_status_line(stdx::http_version version, stdx::http_status_code_t code, size_t& size)
+{
+	static const stdx::_HttpStatusLineTable table;
+	if (code < 100 || code >= 600)
+	{
+		return nullptr;
+	}
+	size_t index = 1;
+	if (version == stdx::http_version::http_1_0)
+	{
+		index = 0;
+	}
+	else if (version == stdx::http_version::http_2_0)
+	{
+		index = 2;
+	}
+	const std::string& line = table.lines[index][code - 100];
+	size = line.size();
+	return line.c_str();
+}
+
+static const char* _HttpWeekNames[7] = { "Sun","Mon","Tue","Wed","Thu","Fri","Sat" };
+
+static const char* _HttpMonthNames[12] = { "Jan","Feb","Mar","Apr","May","Jun","Jul","Aug","Sep","Oct","Nov","Dec" };
+
+const char* stdx::http_date_value()
+{
+	static thread_local time_t last = 0;
+	static thread_local char value[32] = { 0 };
+	time_t now = ::time(nullptr);
+	if (now == last)
+	{
+		return value;
+	}
+	last = now;
+	stdx::http_format_date(now, value);
+	return value;
+}
+
+static char* _HttpFormatDigits(char* p, int value, int width)
+{
+	for (int i = width - 1; i >= 0; --i)
+	{
+		p[i] = (char)('0' + value % 10);
+		value /= 10;
+	}
+	return p + width;
+}
+
+size_t stdx::http_format_date(time_t time, char* buf)
+{
+	tm t;
+#ifdef WIN32
+	bool ok = (gmtime_s(&t, &time) == 0);
+#else
+	bool ok = (gmtime_r(&time, &t) != nullptr);
+#endif
+	if (!ok)
+	{
+		throw std::invalid_argument("invalid time");
+	}
+	//IMF-fixdate只能表示4位年份
+	int year = t.tm_year + 1900;
+	if (year < 0)
+	{
+		year = 0;
+	}
+	else if (year > 9999)
+	{
+		year = 9999;
+	}
+	//不使用strftime和snprintf,避免受locale影响,长度固定为29
+	char* p = buf;
+	p = std::copy(_HttpWeekNames[t.tm_wday], _HttpWeekNames[t.tm_wday] + 3, p);
+	*p++ = ',';
+	*p++ = ' ';
+	p = _HttpFormatDigits(p, t.tm_mday, 2);
+	*p++ = ' ';
+	p = std::copy(_HttpMonthNames[t.tm_mon], _HttpMonthNames[t.tm_mon] + 3, p);
+	*p++ = ' ';
+	p = _HttpFormatDigits(p, year, 4);
+	*p++ = ' ';
+	p = _HttpFormatDigits(p, t.tm_hour, 2);
+	*p++ = ':';
+	p = _HttpFormatDigits(p, t.tm_min, 2);
+	*p++ = ':';
+	p = _HttpFormatDigits(p, t.tm_sec, 2);
+	p = std::copy(" GMT", " GMT" + 4, p);
+	*p = '\0';
+	return (size_t)(p - buf);
+}
+
+bool stdx::http_parse_date(const std::string& value, time_t& time)
+{
+	//Sun, 06 Nov 1994 08:49:37 GMT
+	if (value.size() != 29 || value[3] != ',' || value[4] != ' ' || value[7] != ' ' || value[11] != ' ' || value[16] != ' ' || value[19] != ':' || value[22] != ':' || value.compare(25, 4, " GMT") != 0)
+	{
+		return false;
 	}
+	static const size_t digits[] = { 5,6,12,13,14,15,17,18,20,21,23,24 };
+	for (size_t i = 0; i < sizeof(digits) / sizeof(size_t); ++i)
+	{
+		if (value[digits[i]] < '0' || value[digits[i]] > '9')
+		{
+			return false;
+		}
+	}
+	int month = -1;
+	for (int i = 0; i < 12; ++i)
+	{
+		if (value.compare(8, 3, _HttpMonthNames[i]) == 0)
+		{
+			month = i + 1;
+			break;
+		}
+	}
+	if (month == -1)
+	{
+		return false;
+	}
+	int64_t day = (value[5] - '0') * 10 + (value[6] - '0');
+	int64_t year = (value[12] - '0') * 1000 + (value[13] - '0') * 100 + (value[14] - '0') * 10 + (value[15] - '0');
+	int64_t hour = (value[17] - '0') * 10 + (value[18] - '0');
+	int64_t minute = (value[20] - '0') * 10 + (value[21] - '0');
+	int64_t second = (value[23] - '0') * 10 + (value[24] - '0');
+	if (day < 1 || day > 31 || hour > 23 || minute > 59 || second > 60)
+	{
+		return false;
+	}
+	//公历日期到1970-01-01的天数,不依赖timegm
+	year -= (month <= 2) ? 1 : 0;
+	int64_t era = (year >= 0 ? year : year - 399) / 400;
+	int64_t yoe = year - era * 400;
+	int64_t doy = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+	int64_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+	int64_t days = era * 146097 + doe - 719468;
+	time = (time_t)(days * 86400 + hour * 3600 + minute * 60 + second);
+	return true;
 }
 
 stdx::string stdx::http_method_string(stdx::http_method method)
@@ -1255,14 +1589,28 @@ const stdx::string& stdx::http_request_header::request_url() const
 
 std::list<stdx::http_cookie>& stdx::http_request_header::cookies()
 {
+	_Materialize();
 	return m_cookies;
 }
 
 const std::list<stdx::http_cookie>& stdx::http_request_header::cookies() const
 {
+	_Materialize();
 	return m_cookies;
 }
 
+void stdx::http_request_header::_AddRawHeader(stdx::string&& name, stdx::string&& value) const
+{
+	if (name == U("Cookie"))
+	{
+		stdx::string cookie(U("Cookie: "));
+		cookie.append(value);
+		m_cookies = stdx::make_cookies_by_cookie_header(cookie);
+		return;
+	}
+	http_header::_AddRawHeader(std::move(name), std::move(value));
+}
+
 stdx::string stdx::http_request_header::to_string() const
 {
 	//请求行
@@ -1273,7 +1621,7 @@ stdx::string stdx::http_request_header::to_string() const
 	str.push_back(U(' '));
 	str.append(std::move(stdx::http_version_string(version())));
 	str.append(U("\r\n"));
-	//其他头部
+	//其他头部(同时转换解析器记录的字段)
 	str.append(std::move(http_header::to_string()));
 	//Cookie
 	if (!m_cookies.empty())
@@ -1288,6 +1636,33 @@ stdx::string stdx::http_request_header::to_string() const
 	return str;
 }
 
+void stdx::http_request_header::serialize_into(stdx::output_buffer& out) const
+{
+	//请求行
+	out.append(stdx::http_method_string(m_method));
+	out.push_back(' ');
+	out.append(m_request_url);
+	out.push_back(' ');
+	out.append(stdx::http_u8_version_string(version()));
+	out.append("\r\n", 2);
+	//其他头部(同时转换解析器记录的字段)
+	http_header::serialize_into(out);
+	//Cookie
+	if (!m_cookies.empty())
+	{
+		out.append("Cookie: ", 8);
+		for (auto begin = m_cookies.begin(), end = m_cookies.end(); begin != end; begin++)
+		{
+			if (begin != m_cookies.begin())
+			{
+				out.append("; ", 2);
+			}
+			out.append(begin->to_cookie_string_without_header());
+		}
+		out.append("\r\n", 2);
+	}
+}
+
 stdx::http_request_header stdx::http_request_header::from_string(const stdx::string& str)
 {
 	if (str.empty())
@@ -1431,6 +1806,34 @@ stdx::string stdx::http_response_header::to_string() const
 	return str;
 }
 
+void stdx::http_response_header::serialize_into(stdx::output_buffer& out) const
+{
+	//状态行
+	size_t size = 0;
+	const char* line = stdx::http_status_line(version(), m_status_code, size);
+	if (line)
+	{
+		out.append(line, size);
+	}
+	else
+	{
+		out.append(stdx::http_u8_version_string(version()));
+		out.push_back(' ');
+		out.append(std::to_string(m_status_code));
+		out.push_back(' ');
+		out.append(stdx::http_u8_status_message(m_status_code));
+		out.append("\r\n", 2);
+	}
+	//其他头部
+	http_header::serialize_into(out);
+	//Set-Cookie
+	for (auto begin = m_set_cookies.begin(), end = m_set_cookies.end(); begin != end; begin++)
+	{
+		out.append(begin->to_set_cookie_string());
+		out.append("\r\n", 2);
+	}
+}
+
 stdx::http_response_header stdx::http_response_header::from_string(const stdx::string& str)
 {
 	if (str.empty())
@@ -2024,6 +2427,18 @@ std::vector<typename stdx::http_text_form::byte_t> stdx::http_text_form::to_byte
 	return m_collection.at(U("value")).val();
 }
 
+void stdx::http_body::serialize_into(stdx::output_buffer& out) const
+{
+	std::vector<byte_t>&& bytes = to_bytes();
+	out.append((const char*)bytes.data(), bytes.size());
+}
+
+void stdx::http_msg::serialize_into(stdx::output_buffer& out) const
+{
+	std::vector<byte_t>&& bytes = to_bytes();
+	out.append((const char*)bytes.data(), bytes.size());
+}
+
 std::vector<stdx::http_msg::byte_t> stdx::http_msg::to_bytes() const
 {
 	std::vector<byte_t>&& body_byte = body().to_bytes();
@@ -2092,28 +2507,8 @@ std::vector<typename stdx::http_request::byte_t> stdx::http_request::to_bytes()
 			}
 		}
 	}
-	if (!m_header->exist(U("Content-Type")))
-	{
-		if (m_form->form_type() == stdx::http_form_type::multipart)
-		{
-			stdx::string &&content_type = stdx::http_form_type_string(m_form->form_type());
-			content_type.append(U("; boundary="));
-			const stdx::http_multipart_form& form = (const stdx::http_multipart_form&) * m_form;
-			content_type.append(form.boundary());
-			m_header->add_header(U("Content-Type"), content_type);
-		}
-		else
-		{
-			stdx::string &&content_type = stdx::http_form_type_string(m_form->form_type());
-			m_header->add_header(U("Content-Type"), content_type);
-		}
-	}
 	std::vector<byte_t>&& body_byte = m_form->to_bytes();
-	if (!m_header->exist(U("Content-Length")))
-	{
-		const unsigned long long int& tmp = body_byte.size();
-		m_header->add_header(U("Content-Length"),stdx::to_string(tmp));
-	}
+	_PrepareHeader(body_byte.size());
 	stdx::string&& header_string = m_header->to_string();
 	header_string.append(U("\r\n"));
 	std::string&& tmp = header_string.to_u8_string();
@@ -2128,16 +2523,19 @@ std::vector<typename stdx::http_request::byte_t> stdx::http_request::to_bytes()
 stdx::http_request::http_request()
 	:m_header(nullptr)
 	,m_form(nullptr)
+	,m_body_reader(nullptr)
 {}
 
 stdx::http_request::http_request(const stdx::http_request& other)
 	:m_header(other.m_header)
 	,m_form(other.m_form)
+	,m_body_reader(other.m_body_reader)
 {}
 
 stdx::http_request::http_request(stdx::http_request&& other) noexcept
 	:m_header(std::move(other.m_header))
 	,m_form(std::move(other.m_form))
+	,m_body_reader(std::move(other.m_body_reader))
 {}
 
 stdx::http_request::http_request(const stdx::http_form_ptr& form)
@@ -2176,6 +2574,7 @@ stdx::http_request& stdx::http_request::operator=(stdx::http_request&& other) no
 {
 	m_header = std::move(other.m_header);
 	m_form = std::move(other.m_form);
+	m_body_reader = std::move(other.m_body_reader);
 	return *this;
 }
 
@@ -2184,6 +2583,54 @@ bool stdx::http_request::operator==(const stdx::http_request& other) const
 	return m_header == other.m_header && m_form == other.m_form;
 }
 
+void stdx::http_request::_PrepareHeader(size_t body_size) const
+{
+	if (!m_header->exist(U("Content-Type")))
+	{
+		if (m_form->form_type() == stdx::http_form_type::multipart)
+		{
+			stdx::string &&content_type = stdx::http_form_type_string(m_form->form_type());
+			content_type.append(U("; boundary="));
+			const stdx::http_multipart_form& form = (const stdx::http_multipart_form&) * m_form;
+			content_type.append(form.boundary());
+			m_header->add_header(U("Content-Type"), content_type);
+		}
+		else
+		{
+			stdx::string &&content_type = stdx::http_form_type_string(m_form->form_type());
+			m_header->add_header(U("Content-Type"), content_type);
+		}
+	}
+	if (!m_header->exist(U("Content-Length")))
+	{
+		const unsigned long long int& tmp = body_size;
+		m_header->add_header(U("Content-Length"),stdx::to_string(tmp));
+	}
+}
+
+void stdx::http_request::serialize_into(stdx::output_buffer& out) const
+{
+	//GET的urlencoded表单写入URL,使用原来的实现
+	if (m_header->method() == stdx::http_method::get && !m_form->empty() && m_form->form_type() == stdx::http_form_type::urlencoded && m_header->request_url().find(U('?')) == stdx::string::npos)
+	{
+		return http_msg::serialize_into(out);
+	}
+	std::vector<byte_t>&& body_byte = m_form->to_bytes();
+	_PrepareHeader(body_byte.size());
+	m_header->serialize_into(out);
+	out.append("\r\n", 2);
+	out.append((const char*)body_byte.data(), body_byte.size());
+}
+
+stdx::task<stdx::buffer_view> stdx::http_request::read_body_chunk()
+{
+	if (!m_body_reader)
+	{
+		throw std::logic_error("request body is not streaming");
+	}
+	return m_body_reader->read_chunk();
+}
+
 stdx::http_request_header& stdx::http_request::request_header()
 {
 	return *m_header;
@@ -2692,20 +3139,189 @@ stdx::http_request stdx::http_request::from_bytes(const std::string& bytes)
 	}
 }
 
+stdx::http_body_rope::http_body_rope()
+	:m_segments()
+	,m_size(0)
+	,m_tail_writable(false)
+	,m_flat()
+	,m_flat_valid(false)
+{}
+
+stdx::http_body_rope::http_body_rope(const self_t& other)
+	:m_segments(other.m_segments)
+	,m_size(other.m_size)
+	//片段与other共享,不能再写入
+	,m_tail_writable(false)
+	,m_flat()
+	,m_flat_valid(false)
+{}
+
+stdx::http_body_rope::http_body_rope(self_t&& other) noexcept
+	:m_segments(std::move(other.m_segments))
+	,m_size(other.m_size)
+	,m_tail_writable(other.m_tail_writable)
+	,m_flat(std::move(other.m_flat))
+	,m_flat_valid(other.m_flat_valid)
+{
+	other.m_segments.clear();
+	other.m_size = 0;
+	other.m_tail_writable = false;
+	other.m_flat_valid = false;
+}
+
+typename stdx::http_body_rope::self_t& stdx::http_body_rope::operator=(const self_t& other)
+{
+	m_segments = other.m_segments;
+	m_size = other.m_size;
+	m_tail_writable = false;
+	_Changed();
+	return *this;
+}
+
+typename stdx::http_body_rope::self_t& stdx::http_body_rope::operator=(self_t&& other) noexcept
+{
+	m_segments = std::move(other.m_segments);
+	m_size = other.m_size;
+	m_tail_writable = other.m_tail_writable;
+	m_flat = std::move(other.m_flat);
+	m_flat_valid = other.m_flat_valid;
+	other.m_segments.clear();
+	other.m_size = 0;
+	other.m_tail_writable = false;
+	other.m_flat_valid = false;
+	return *this;
+}
+
+void stdx::http_body_rope::_Changed()
+{
+	m_flat_valid = false;
+	m_flat.clear();
+}
+
+void stdx::http_body_rope::append(const byte_t* data, size_t size)
+{
+	if (size == 0)
+	{
+		return;
+	}
+	if (!m_tail_writable)
+	{
+		return push(data, size);
+	}
+	stdx::buffer_view& tail = m_segments.back();
+	if (tail.buffer.size() - tail.offset - tail.size < size)
+	{
+		//按2倍扩容
+		size_t capacity = (std::max)(tail.size * 2, tail.size + size);
+		stdx::buffer buf = stdx::make_buffer(capacity);
+		memcpy((char*)buf, tail.data(), tail.size);
+		tail = stdx::buffer_view(buf, 0, tail.size);
+	}
+	memcpy(tail.data() + tail.size, data, size);
+	tail.size += size;
+	m_size += size;
+	_Changed();
+}
+
+void stdx::http_body_rope::push(const byte_t* data, size_t size)
+{
+	if (size == 0)
+	{
+		return;
+	}
+	stdx::buffer buf = stdx::make_buffer(size);
+	memcpy((char*)buf, data, size);
+	m_segments.push_back(stdx::buffer_view(buf, 0, size));
+	m_size += size;
+	m_tail_writable = true;
+	_Changed();
+}
+
+void stdx::http_body_rope::push(const stdx::buffer_view& view)
+{
+	if (view.size == 0)
+	{
+		return;
+	}
+	m_segments.push_back(view);
+	m_size += view.size;
+	m_tail_writable = false;
+	_Changed();
+}
+
+void stdx::http_body_rope::pop()
+{
+	if (m_segments.empty())
+	{
+		return;
+	}
+	m_size -= m_segments.back().size;
+	m_segments.pop_back();
+	//剩下的最后一个片段不确定是否是自己分配的
+	m_tail_writable = false;
+	_Changed();
+}
+
+const std::vector<typename stdx::http_body_rope::byte_t>& stdx::http_body_rope::flatten() const
+{
+	if (!m_flat_valid)
+	{
+		m_flat.clear();
+		m_flat.reserve(m_size);
+		for (auto begin = m_segments.begin(), end = m_segments.end(); begin != end; ++begin)
+		{
+			const byte_t* data = (const byte_t*)begin->data();
+			m_flat.insert(m_flat.end(), data, data + begin->size);
+		}
+		m_flat_valid = true;
+	}
+	return m_flat;
+}
+
+std::string stdx::http_body_rope::to_u8_string() const
+{
+	std::string str;
+	str.reserve(m_size);
+	for (auto begin = m_segments.begin(), end = m_segments.end(); begin != end; ++begin)
+	{
+		str.append(begin->data(), begin->size);
+	}
+	return str;
+}
+
+void stdx::http_body_rope::serialize_segment(stdx::output_buffer& out, const stdx::buffer_view& segment) const
+{
+	if (segment.size >= STDX_HTTP_BODY_REF_SIZE)
+	{
+		out.append_ref(segment);
+	}
+	else
+	{
+		out.append(segment.data(), segment.size);
+	}
+}
+
 stdx::http_identity_body::http_identity_body()
 	:m_data()
 	,m_body_type(U("identity"))
 {}
 
 stdx::http_identity_body::http_identity_body(const std::vector<byte_t>& data)
-	: m_data({data})
+	: m_data()
 	, m_body_type(U("identity"))
-{}
+{
+	push(data);
+}
 
 stdx::http_identity_body::http_identity_body(const std::initializer_list<std::vector<byte_t>>& data)
-	:m_data(data)
+	:m_data()
 	, m_body_type(U("identity"))
-{}
+{
+	for (auto begin = data.begin(), end = data.end(); begin != end; begin++)
+	{
+		push(*begin);
+	}
+}
 
 stdx::http_identity_body::http_identity_body(const self_t& other)
 	:m_data(other.m_data)
@@ -2713,8 +3329,8 @@ stdx::http_identity_body::http_identity_body(const self_t& other)
 {}
 
 stdx::http_identity_body::http_identity_body(self_t&& other) noexcept
-	:m_data(other.m_data)
-	,m_body_type(other.m_body_type)
+	:m_data(std::move(other.m_data))
+	,m_body_type(std::move(other.m_body_type))
 {}
 
 typename stdx::http_identity_body::self_t& stdx::http_identity_body::operator=(const self_t& other)
@@ -2726,83 +3342,59 @@ typename stdx::http_identity_body::self_t& stdx::http_identity_body::operator=(c
 
 typename stdx::http_identity_body::self_t& stdx::http_identity_body::operator=(self_t&& other) noexcept
 {
-	m_data = other.m_data;
-	m_body_type = other.m_body_type;
+	m_data = std::move(other.m_data);
+	m_body_type = std::move(other.m_body_type);
 	return *this;
 }
 
 std::vector<typename stdx::http_identity_body::byte_t> stdx::http_identity_body::to_bytes() const
 {
-	std::vector<byte_t> vec;
-	if (!m_data.empty())
+	return m_data.flatten();
+}
+
+void stdx::http_identity_body::serialize_into(stdx::output_buffer& out) const
+{
+	const std::vector<stdx::buffer_view>& segments = m_data.segments();
+	for (auto begin = segments.begin(), end = segments.end(); begin != end; begin++)
 	{
-		size_t size = vec.size();
-		for (auto begin = m_data.cbegin(), end = m_data.cend(); begin != end; begin++)
-		{
-			size += begin->size();
-		}
-		vec.reserve(size);
-		for (auto begin = m_data.cbegin(),end=m_data.cend();begin!=end;begin++)
-		{
-			for (auto data_begin=begin->cbegin(),data_end=begin->cend();data_begin != data_end;data_begin++)
-			{
-				vec.push_back(*data_begin);
-			}
-		}
+		m_data.serialize_segment(out, *begin);
 	}
-	return vec;
+}
+
+size_t stdx::http_identity_body::size() const
+{
+	return m_data.size();
 }
 
 bool stdx::http_identity_body::empty() const
 {
-	if (!m_data.empty())
-	{
-		return m_data.front().empty();
-	}
-	return true;
+	return m_data.empty();
 }
 
 std::vector<typename stdx::http_identity_body::byte_t> stdx::http_identity_body::data() const
 {
-	return to_bytes();
+	return m_data.flatten();
 }
 
 stdx::string stdx::http_identity_body::data_as_string() const
 {
-	std::vector<byte_t>&& bytes = data();
-	std::string str(std::make_move_iterator(bytes.begin()),std::make_move_iterator(bytes.end()));
-	return stdx::string::from_u8_string(str);
+	return stdx::string::from_u8_string(m_data.to_u8_string());
 }
 
 void stdx::http_identity_body::push(const byte_t* buffer, size_t count)
 {
-	if (m_data.empty())
-	{
-		std::vector<byte_t> vec;
-		vec.reserve(count);
-		for (size_t i = 0; i < count; i++)
-		{
-			vec.push_back(buffer[i]);
-		}
-		m_data.push_back(std::move(vec));
-	}
-	else
-	{
-		auto pos = m_data.rbegin();
-		pos->reserve(pos->size() + count);
-		for (size_t i = 0; i < count; i++)
-		{
-			pos->push_back(buffer[i]);
-		}
-	}
+	//追加到最后一段
+	m_data.append(buffer, count);
 }
 
 void stdx::http_identity_body::push(const std::vector<byte_t>& buffer)
 {
-	if (!buffer.empty())
-	{
-		m_data.push_back(buffer);
-	}
+	m_data.push(buffer.data(), buffer.size());
+}
+
+void stdx::http_identity_body::push(const stdx::buffer_view& view)
+{
+	m_data.push(view);
 }
 
 void stdx::http_identity_body::push(const stdx::string& str)
@@ -2810,17 +3402,13 @@ void stdx::http_identity_body::push(const stdx::string& str)
 	if (!str.empty())
 	{
 		std::string&& tmp = str.to_u8_string();
-		std::vector<byte_t> vector(std::make_move_iterator(tmp.begin()),std::make_move_iterator(tmp.end()));
-		m_data.push_back(std::move(vector));
+		m_data.push((const byte_t*)tmp.data(), tmp.size());
 	}
 }
 
 void stdx::http_identity_body::pop()
 {
-	if (!m_data.empty())
-	{
-		m_data.pop_back();
-	}
+	m_data.pop();
 }
 
 stdx::string stdx::http_identity_body::body_type() const
@@ -2839,14 +3427,21 @@ stdx::http_chunk_body::http_chunk_body()
 {}
 
 stdx::http_chunk_body::http_chunk_body(const std::vector<byte_t>& data)
-	:m_data({data})
+	:m_data()
 	,m_trailer()
-{}
+{
+	push(data);
+}
 
 stdx::http_chunk_body::http_chunk_body(const std::initializer_list<std::vector<byte_t>>& data)
-	:m_data(data)
+	:m_data()
 	,m_trailer()
-{}
+{
+	for (auto begin = data.begin(), end = data.end(); begin != end; begin++)
+	{
+		push(*begin);
+	}
+}
 
 stdx::http_chunk_body::http_chunk_body(const stdx::string& trailer)
 	:m_data()
@@ -2854,14 +3449,21 @@ stdx::http_chunk_body::http_chunk_body(const stdx::string& trailer)
 {}
 
 stdx::http_chunk_body::http_chunk_body(const std::vector<byte_t>& data, const stdx::string& trailer)
-	:m_data({data})
+	:m_data()
 	,m_trailer(trailer)
-{}
+{
+	push(data);
+}
 
 stdx::http_chunk_body::http_chunk_body(const std::initializer_list<std::vector<byte_t>>& data, const stdx::string& trailer)
-	:m_data(data)
+	:m_data()
 	,m_trailer(trailer)
-{}
+{
+	for (auto begin = data.begin(), end = data.end(); begin != end; begin++)
+	{
+		push(*begin);
+	}
+}
 
 stdx::http_chunk_body::http_chunk_body(const self_t& other)
 	:m_data(other.m_data)
@@ -2869,8 +3471,8 @@ stdx::http_chunk_body::http_chunk_body(const self_t& other)
 {}
 
 stdx::http_chunk_body::http_chunk_body(self_t&& other) noexcept
-	:m_data(other.m_data)
-	,m_trailer(other.m_trailer)
+	:m_data(std::move(other.m_data))
+	,m_trailer(std::move(other.m_trailer))
 {}
 
 stdx::http_chunk_body::self_t& stdx::http_chunk_body::operator=(const self_t& other)
@@ -2882,109 +3484,86 @@ stdx::http_chunk_body::self_t& stdx::http_chunk_body::operator=(const self_t& ot
 
 stdx::http_chunk_body::self_t& stdx::http_chunk_body::operator=(self_t&& other) noexcept
 {
-	m_data = other.m_data;
-	m_trailer = other.m_trailer;
+	m_data = std::move(other.m_data);
+	m_trailer = std::move(other.m_trailer);
 	return *this;
 }
 
-void _GetHexFromSize(char* buf,size_t size)
+std::vector<typename stdx::http_chunk_body::byte_t> stdx::http_chunk_body::to_bytes() const
 {
-#ifdef WIN32
-	::sprintf_s(buf, 16, "%zu", size);
-#else
-	::sprintf(buf,"%zu", size);
-#endif
+	stdx::output_buffer out(m_data.size() + 64);
+	serialize_into(out);
+	std::vector<byte_t> vec;
+	vec.reserve(out.size());
+	const std::vector<stdx::buffer_view>& views = out.views();
+	for (auto begin = views.begin(), end = views.end(); begin != end; begin++)
+	{
+		const byte_t* data = (const byte_t*)begin->data();
+		vec.insert(vec.end(), data, data + begin->size);
+	}
+	return vec;
 }
 
-std::vector<typename stdx::http_chunk_body::byte_t> stdx::http_chunk_body::to_bytes() const
+void stdx::http_chunk_body::serialize_into(stdx::output_buffer& out) const
 {
-	std::string builder;
-	for (auto begin = m_data.cbegin(),end = m_data.cend();begin!=end;begin++)
+	static const char hex[] = "0123456789abcdef";
+	const std::vector<stdx::buffer_view>& segments = m_data.segments();
+	for (auto begin = segments.begin(), end = segments.end(); begin != end; begin++)
 	{
-		if (!begin->empty())
+		//块大小(十六进制)
+		char buf[16];
+		size_t pos = sizeof(buf);
+		size_t size = begin->size;
+		do
 		{
-			size_t size = begin->size();
-			char buf[17];
-			memset(buf, 0, 17);
-			_GetHexFromSize(buf,size);
-			builder.append(buf);
-			builder.append("\r\n");
-			for (auto data_begin = begin->cbegin(),data_end = begin->cend();data_begin!=data_end;data_begin++)
-			{
-				builder.push_back((char)*data_begin);
-			}
-			builder.append("\r\n");
-		}
+			buf[--pos] = hex[size & 0xf];
+			size >>= 4;
+		} while (size != 0);
+		out.append(buf + pos, sizeof(buf) - pos);
+		out.append("\r\n", 2);
+		m_data.serialize_segment(out, *begin);
+		out.append("\r\n", 2);
 	}
 	if (m_trailer.empty())
 	{
-		builder.append("0\r\n\r\n");
+		out.append("0\r\n\r\n", 5);
 	}
 	else
 	{
-		builder.append("0\r\n");
-		builder.append(std::move(m_trailer.to_u8_string()));
-		builder.append("\r\n");
+		out.append("0\r\n", 3);
+		out.append(m_trailer);
+		out.append("\r\n", 2);
 	}
-	std::vector<byte_t> vec(std::make_move_iterator(builder.begin()), std::make_move_iterator(builder.end()));
-	return vec;
 }
 
 bool stdx::http_chunk_body::empty() const
 {
-	if (!m_data.empty())
-	{
-		return m_data.front().empty();
-	}
-	return true;
+	return m_data.empty();
 }
 
 std::vector<typename stdx::http_chunk_body::byte_t> stdx::http_chunk_body::data() const
 {
-	std::vector<byte_t> vec;
-	if (!m_data.empty())
-	{
-		size_t size = 0;
-		for (auto begin = m_data.cbegin(), end = m_data.cend(); begin != end; begin++)
-		{
-			size += begin->size();
-		}
-		vec.reserve(size);
-		for (auto begin = m_data.cbegin(), end = m_data.cend(); begin != end; begin++)
-		{
-			for (auto data_begin = begin->cbegin(), data_end = begin->cend(); data_begin != data_end; data_begin++)
-			{
-				vec.push_back(*data_begin);
-			}
-		}
-	}
-	return vec;
+	return m_data.flatten();
 }
 
 stdx::string stdx::http_chunk_body::data_as_string() const
 {
-	std::vector<byte_t>&& bytes = data();
-	std::string str(bytes.begin(), bytes.end());
-	return stdx::string::from_u8_string(str);
+	return stdx::string::from_u8_string(m_data.to_u8_string());
 }
 
 void stdx::http_chunk_body::push(const byte_t* buffer, size_t count)
 {
-	std::vector<byte_t> vec;
-	vec.reserve(count);
-	for (size_t i = 0; i < count; i++)
-	{
-		vec.push_back(buffer[i]);
-	}
-	push(vec);
+	m_data.push(buffer, count);
 }
 
 void stdx::http_chunk_body::push(const std::vector<byte_t>& buffer)
 {
-	if (!buffer.empty())
-	{
-		m_data.push_back(buffer);
-	}
+	m_data.push(buffer.data(), buffer.size());
+}
+
+void stdx::http_chunk_body::push(const stdx::buffer_view& view)
+{
+	m_data.push(view);
 }
 
 void stdx::http_chunk_body::push(const stdx::string& str)
@@ -2992,17 +3571,13 @@ void stdx::http_chunk_body::push(const stdx::string& str)
 	if (!str.empty())
 	{
 		std::string&& tmp = str.to_u8_string();
-		std::vector<byte_t> vector(std::make_move_iterator(tmp.begin()), std::make_move_iterator(tmp.end()));
-		m_data.push_back(vector);
+		m_data.push((const byte_t*)tmp.data(), tmp.size());
 	}
 }
 
 void stdx::http_chunk_body::pop()
 {
-	if (!m_data.empty())
-	{
-		m_data.pop_back();
-	}
+	m_data.pop();
 }
 
 stdx::string& stdx::http_chunk_body::trailer() const
@@ -3087,28 +3662,87 @@ const stdx::http_response_body& stdx::http_response::response_body() const
 std::vector<typename stdx::http_response::byte_t> stdx::http_response::to_bytes() const
 {
 	std::vector<byte_t>&& body_byte = m_body->to_bytes();
+	_PrepareHeader(body_byte.size());
+	std::string &&header_string = m_header->to_string().to_u8_string();
+	header_string.append("\r\n");
+	std::vector<byte_t> vector(std::make_move_iterator(header_string.begin()), std::make_move_iterator(header_string.end()));
+	vector.reserve(vector.size() + body_byte.size());
+	for (auto begin = body_byte.begin(),end=body_byte.end();begin!=end;begin++)
+	{
+		vector.push_back(*begin);
+	}
+	return vector;
+}
+
+void stdx::http_response::serialize_into(stdx::output_buffer& out) const
+{
+	//identity和chunked直接写入,其他类型通过to_bytes
+	const stdx::http_identity_body* identity = dynamic_cast<const stdx::http_identity_body*>(m_body.get());
+	if (identity || dynamic_cast<const stdx::http_chunk_body*>(m_body.get()))
+	{
+		_SerializeHeader(out, identity ? identity->size() : 0);
+		m_body->serialize_into(out);
+		return;
+	}
+	std::vector<byte_t>&& body_byte = m_body->to_bytes();
+	_SerializeHeader(out, body_byte.size());
+	out.append((const char*)body_byte.data(), body_byte.size());
+}
+
+void stdx::http_response::_SerializeHeader(stdx::output_buffer& out, size_t body_size) const
+{
+	static const stdx::string content_length(U("Content-Length"));
+	static const stdx::string transfer_encoding(U("Transfer-Encoding"));
+	static const stdx::string date(U("Date"));
+	stdx::string body_type = m_body->body_type();
+	bool chunked = (body_type == U("chunked"));
+	if (chunked)
+	{
+		_PrepareTrailer();
+	}
+	m_header->serialize_into(out);
+	//自动生成的头部直接写入,不加入头部集合
+	if (!chunked && !m_header->exist(content_length))
+	{
+		out.append("Content-Length: ", 16);
+		char buf[20];
+		size_t pos = sizeof(buf);
+		do
+		{
+			buf[--pos] = (char)('0' + body_size % 10);
+			body_size /= 10;
+		} while (body_size != 0);
+		out.append(buf + pos, sizeof(buf) - pos);
+		out.append("\r\n", 2);
+	}
+	if (body_type != U("identity") && !m_header->exist(transfer_encoding))
+	{
+		out.append("Transfer-Encoding: ", 19);
+		out.append(body_type);
+		out.append("\r\n", 2);
+	}
+	if (!m_header->exist(date))
+	{
+		out.append("Date: ", 6);
+		out.append(stdx::http_date_value(), 29);
+		out.append("\r\n", 2);
+	}
+	out.append("\r\n", 2);
+}
+
+void stdx::http_response::_PrepareHeader(size_t body_size) const
+{
 	if (m_body->body_type() != U("chunked"))
 	{
 		if (!m_header->exist(U("Content-Length")))
 		{
-			const unsigned long long int& tmp = body_byte.size();
+			const unsigned long long int& tmp = body_size;
 			m_header->add_header(U("Content-Length"), stdx::to_string(tmp));
 		}
 	}
 	else
 	{
-		const stdx::http_chunk_body& chunk = (const stdx::http_chunk_body&) * m_body;
-		if (m_header->exist(U("Trailer")))
-		{
-			if (m_header->exist((*m_header)[U("Trailer")]))
-			{
-				if (chunk.trailer().empty())
-				{
-					chunk.trailer() = (*m_header)[(*m_header)[U("Trailer")]];
-				}
-				m_header->remove_header((*m_header)[U("Trailer")]);
-			}
-		}
+		_PrepareTrailer();
 	}
 	if (m_body->body_type() != U("identity"))
 	{
@@ -3117,15 +3751,22 @@ std::vector<typename stdx::http_response::byte_t> stdx::http_response::to_bytes(
 			m_header->add_header(U("Transfer-Encoding"), m_body->body_type());
 		}
 	}
-	std::string &&header_string = m_header->to_string().to_u8_string();
-	header_string.append("\r\n");
-	std::vector<byte_t> vector(std::make_move_iterator(header_string.begin()), std::make_move_iterator(header_string.end()));
-	vector.reserve(vector.size() + body_byte.size());
-	for (auto begin = body_byte.begin(),end=body_byte.end();begin!=end;begin++)
+}
+
+void stdx::http_response::_PrepareTrailer() const
+{
+	const stdx::http_chunk_body& chunk = (const stdx::http_chunk_body&) * m_body;
+	if (m_header->exist(U("Trailer")))
 	{
-		vector.push_back(*begin);
+		if (m_header->exist((*m_header)[U("Trailer")]))
+		{
+			if (chunk.trailer().empty())
+			{
+				chunk.trailer() = (*m_header)[(*m_header)[U("Trailer")]];
+			}
+			m_header->remove_header((*m_header)[U("Trailer")]);
+		}
 	}
-	return vector;
 }
 
 stdx::http_header& stdx::http_response::header()
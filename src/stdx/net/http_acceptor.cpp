@@ -2,20 +2,33 @@
 #include <stdx/net/http_connection.h>
 
 
-stdx::basic_http_acceptor::basic_http_acceptor(stdx::socket sock, size_t max_size)
+stdx::basic_http_acceptor::basic_http_acceptor(stdx::socket sock, size_t max_size, bool stream_body)
 	: base_t(sock)
 	, m_max_size(max_size)
+	, m_stream_body(stream_body)
+{}
+
+stdx::basic_http_acceptor::basic_http_acceptor(std::vector<stdx::socket> socks, size_t max_size, bool stream_body)
+	: base_t(socks)
+	, m_max_size(max_size)
+	, m_stream_body(stream_body)
 {}
 
 typename stdx::basic_http_acceptor::connection_t stdx::basic_http_acceptor::make_connection(stdx::socket sock)
 {
-	return stdx::make_http_connection(sock,m_max_size);
+	return stdx::make_http_connection(sock,m_max_size,m_stream_body);
 }
 
-extern stdx::http_acceptor stdx::make_http_acceptor(network_io_service io_service, ipv4_addr addr, size_t max_size)
+extern stdx::http_acceptor stdx::make_http_acceptor(network_io_service io_service, socket_addr addr, size_t max_size, bool stream_body)
 {
-	stdx::socket sock = stdx::open_tcpsocket(io_service);
+	stdx::socket sock = stdx::open_socket(io_service, addr, stdx::socket_type::stream);
 	sock.bind(addr);
 	sock.listen(65535);
-	return stdx::make_acceptor<stdx::basic_http_acceptor>(sock,max_size);
+	return stdx::make_acceptor<stdx::basic_http_acceptor>(sock,max_size,stream_body);
+}
+
+extern stdx::http_acceptor stdx::make_reuse_port_http_acceptor(network_io_service io_service, socket_addr addr, size_t max_size, size_t num, bool stream_body)
+{
+	std::vector<stdx::socket> socks = stdx::open_reuse_port_tcpsockets(io_service, addr, 65535, num);
+	return stdx::make_acceptor<stdx::basic_http_acceptor>(socks,max_size,stream_body);
 }
\ No newline at end of file
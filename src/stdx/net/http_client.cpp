@@ -0,0 +1,160 @@
+#include <stdx/net/http_client.h>
+
+stdx::_HttpClient::_HttpClient(const stdx::connection_pool& pool, uint64_t max_size)
+	:m_pool(pool)
+	,m_max_size(max_size)
+{}
+
+stdx::task<stdx::http_response> stdx::_HttpClient::send(const stdx::socket_addr& addr, const stdx::http_request& req)
+{
+	stdx::task_completion_event<stdx::http_response> ce;
+	stdx::output_buffer out(STDX_HTTP_OUTPUT_BLOCK_SIZE);
+	stdx::http_method method = req.request_header().method();
+	bool keepalive = false;
+	try
+	{
+		stdx::http_request tmp(req);
+		stdx::http_request_header& header = tmp.request_header();
+		if (!header.exist(U("Host")))
+		{
+			stdx::string host;
+			if (addr.is_ipv6())
+			{
+				host = stdx::string(U("[")) + addr.ip() + U("]");
+			}
+			else if (addr.is_ipv4())
+			{
+				host = addr.ip();
+			}
+			else
+			{
+				host = U("localhost");
+			}
+			if (addr.port() != 0)
+			{
+				host += U(":");
+				host += stdx::to_string((int)addr.port());
+			}
+			header.add_header(U("Host"), host);
+		}
+		keepalive = header.is_keepalive();
+		//在调用线程序列化,之后请求可以修改
+		tmp.serialize_into(out);
+	}
+	catch (const std::exception&)
+	{
+		ce.set_exception(std::current_exception());
+		ce.run_on_this_thread();
+		return ce.get_task();
+	}
+	std::vector<stdx::buffer_view> views = out.release();
+	std::shared_ptr<self_t> self = shared_from_this();
+	m_pool.get(addr).then([self, addr, views, method, keepalive, ce](stdx::task_result<stdx::socket> r) mutable
+	{
+		stdx::socket sock;
+		try
+		{
+			sock = r.get();
+		}
+		catch (const std::exception&)
+		{
+			ce.set_exception(std::current_exception());
+			ce.run_on_this_thread();
+			return;
+		}
+		sock.send(std::move(views)).then([self, addr, sock, method, keepalive, ce](stdx::task_result<stdx::network_send_event> r) mutable
+		{
+			try
+			{
+				r.get();
+			}
+			catch (const std::exception&)
+			{
+				self->m_pool.release(addr, sock, false);
+				ce.set_exception(std::current_exception());
+				ce.run_on_this_thread();
+				return;
+			}
+			stdx::http_response_parser parser(self->m_max_size);
+			parser.expect(method);
+			self->_Read(addr, sock, parser, stdx::make_buffer(STDX_HTTP_CLIENT_RECV_SIZE), keepalive, ce);
+		});
+	});
+	return ce.get_task();
+}
+
+void stdx::_HttpClient::_Read(const stdx::socket_addr& addr, stdx::socket sock, stdx::http_response_parser parser, stdx::buffer buf, bool keepalive, stdx::task_completion_event<stdx::http_response> ce)
+{
+	std::shared_ptr<self_t> self = shared_from_this();
+	sock.recv(buf).then([self, addr, sock, parser, buf, keepalive, ce](stdx::task_result<stdx::network_recv_event> r) mutable
+	{
+		bool closed = false;
+		std::exception_ptr error(nullptr);
+		try
+		{
+			stdx::network_recv_event ev = r.get();
+			if (ev.size == 0)
+			{
+				closed = true;
+			}
+			else
+			{
+				parser.push(ev.buffer, ev.size);
+			}
+		}
+		catch (const std::exception&)
+		{
+			//对端关闭连接也可能以错误返回
+			error = std::current_exception();
+			closed = true;
+		}
+		if (closed)
+		{
+			parser.close();
+		}
+		if (parser.finish_count())
+		{
+			stdx::http_response res = parser.pop();
+			//双方都没有要求关闭,且响应之后没有多余的数据时才复用连接
+			bool reusable = !closed && keepalive && res.response_header().is_keepalive() && res.response_header().status_code() != 101 && parser.idle();
+			self->m_pool.release(addr, sock, reusable);
+			ce.set_value(res);
+			ce.run_on_this_thread();
+			return;
+		}
+		if (parser.error() || closed)
+		{
+			self->m_pool.release(addr, sock, false);
+			if (!closed)
+			{
+				ce.set_exception(std::make_exception_ptr(stdx::parse_error("parse fault")));
+			}
+			else if (error)
+			{
+				ce.set_exception(error);
+			}
+			else
+			{
+				ce.set_exception(std::make_exception_ptr(std::runtime_error("connection closed before the response was complete")));
+			}
+			ce.run_on_this_thread();
+			return;
+		}
+		self->_Read(addr, sock, parser, buf, keepalive, ce);
+	});
+}
+
+void stdx::_HttpClient::close()
+{
+	m_pool.close();
+}
+
+stdx::http_client stdx::make_http_client(const stdx::connection_pool& pool, uint64_t max_size)
+{
+	return stdx::http_client(std::make_shared<stdx::_HttpClient>(pool, max_size));
+}
+
+stdx::http_client stdx::make_http_client(const stdx::network_io_service& io_service, uint64_t max_size, size_t max_per_host, uint64_t idle_timeout_ms)
+{
+	return stdx::make_http_client(stdx::make_connection_pool(io_service, max_per_host, idle_timeout_ms), max_size);
+}
@@ -1,39 +1,239 @@
 #include <stdx/net/http_connection.h>
 
-stdx::basic_http_connection::basic_http_connection(const stdx::socket& sock, uint64_t max_size)
+stdx::_HttpBodyReader::_HttpBodyReader(const stdx::http_request_parser& parser, const stdx::socket& sock, const stdx::buffer& buf, uint64_t id)
+	:m_parser(parser)
+	,m_socket(sock)
+	,m_buf(buf)
+	,m_id(id)
+	,m_state(idle)
+	,m_active_tick(stdx::get_tick_count())
+	,m_done_event()
+	,m_timer_lock()
+	,m_idle_timer()
+{}
+
+stdx::_HttpBodyReader::~_HttpBodyReader()
+{
+	_Done();
+}
+
+stdx::task<stdx::buffer_view> stdx::_HttpBodyReader::read_chunk()
+{
+	stdx::task_completion_event<stdx::buffer_view> ce;
+	m_active_tick = stdx::get_tick_count();
+	int expected = idle;
+	if (!m_state.compare_exchange_strong(expected, reading))
+	{
+		if (expected == done)
+		{
+			ce.set_value(stdx::buffer_view());
+		}
+		else if (expected == discarded)
+		{
+			ce.set_exception(std::make_exception_ptr(std::runtime_error("request body was discarded after being idle")));
+		}
+		else
+		{
+			ce.set_exception(std::make_exception_ptr(std::logic_error("read_chunk is already pending")));
+		}
+		ce.run_on_this_thread();
+		return ce.get_task();
+	}
+	_Read(ce);
+	return ce.get_task();
+}
+
+stdx::task<void> stdx::_HttpBodyReader::wait_done()
+{
+	return m_done_event.get_task();
+}
+
+bool stdx::_HttpBodyReader::_Current() const
+{
+	return m_parser.body_id() == m_id && m_parser.body_streaming();
+}
+
+void stdx::_HttpBodyReader::_Read(stdx::task_completion_event<stdx::buffer_view> ce)
+{
+	if (!_Current())
+	{
+		ce.set_value(stdx::buffer_view());
+		ce.run_on_this_thread();
+		_Done();
+		return;
+	}
+	if (m_parser.body_chunk_ready())
+	{
+		ce.set_value(m_parser.pop_body_chunk());
+		//回调中可能再次调用read_chunk
+		m_active_tick = stdx::get_tick_count();
+		m_state = idle;
+		ce.run_on_this_thread();
+		return;
+	}
+	if (m_parser.error())
+	{
+		ce.set_exception(std::make_exception_ptr(stdx::parse_error("parse fault")));
+		ce.run_on_this_thread();
+		_Done();
+		return;
+	}
+	std::shared_ptr<self_t> self = shared_from_this();
+	m_socket.recv(m_buf).then([self, ce](stdx::task_result<stdx::network_recv_event> r) mutable
+	{
+		try
+		{
+			stdx::network_recv_event ev = r.get();
+			if (ev.size == 0)
+			{
+				throw std::runtime_error("connection closed before the request body was complete");
+			}
+			self->m_parser.push(ev.buffer, ev.size);
+		}
+		catch (const std::exception&)
+		{
+			ce.set_exception(std::current_exception());
+			ce.run_on_this_thread();
+			self->_Done();
+			return;
+		}
+		self->_Read(ce);
+	});
+}
+
+bool stdx::_HttpBodyReader::discard_if_idle(uint64_t now, uint64_t idle_ms)
+{
+	int state = m_state;
+	if (state == done || state == discarded)
+	{
+		return true;
+	}
+	if (now < m_active_tick + idle_ms)
+	{
+		return false;
+	}
+	int expected = idle;
+	if (!m_state.compare_exchange_strong(expected, discarded))
+	{
+		return expected != reading;
+	}
+	//剩余的请求体由连接在读取下一个请求前跳过
+	m_done_event.set_value();
+	m_done_event.run_on_this_thread();
+	return true;
+}
+
+void stdx::_HttpBodyReader::watch_idle(uint64_t idle_ms)
+{
+	uint64_t now = stdx::get_tick_count();
+	if (discard_if_idle(now, idle_ms))
+	{
+		return;
+	}
+	//距离空闲到期的时间,正在读取时按完整的idle_ms计时
+	uint64_t deadline = m_active_tick + idle_ms;
+	uint64_t wait = deadline > now ? deadline - now : idle_ms;
+	std::weak_ptr<self_t> weak = shared_from_this();
+	stdx::timer timer;
+	try
+	{
+		timer = stdx::make_timer(wait, [weak, idle_ms]()
+		{
+			std::shared_ptr<self_t> self = weak.lock();
+			if (self)
+			{
+				self->watch_idle(idle_ms);
+			}
+		});
+	}
+	catch (const std::exception& err)
+	{
+		//无法计时时只能等待请求体读完或被释放
+		DBG_VAR(err);
+#ifdef DEBUG
+		::printf("[HttpBodyReader]Start idle timer fail: %s\n", err.what());
+#endif
+		return;
+	}
+	std::unique_lock<stdx::spin_lock> lock(m_timer_lock);
+	m_idle_timer = timer;
+	int state = m_state;
+	if (state == done || state == discarded)
+	{
+		//计时前已经完成
+		m_idle_timer.cancel();
+	}
+}
+
+void stdx::_HttpBodyReader::_Done()
+{
+	int state = m_state.exchange(done);
+	if (state == done || state == discarded)
+	{
+		return;
+	}
+	{
+		std::unique_lock<stdx::spin_lock> lock(m_timer_lock);
+		if (m_idle_timer)
+		{
+			m_idle_timer.cancel();
+		}
+	}
+	m_done_event.set_value();
+	m_done_event.run_on_this_thread();
+}
+
+stdx::basic_http_connection::basic_http_connection(const stdx::socket& sock, uint64_t max_size, bool stream_body)
 	:base_t(sock)
 	,m_parser(max_size)
 	,m_read_buf(stdx::make_buffer(4096))
-{}
+{
+	m_parser.set_stream_body(stream_body);
+}
+
+stdx::http_request stdx::basic_http_connection::_Pop()
+{
+	uint64_t id = m_parser.front_body_id();
+	stdx::http_request req = m_parser.pop();
+	if (id != 0)
+	{
+		req.set_body_reader(std::make_shared<stdx::_HttpBodyReader>(m_parser, m_socket, m_read_buf, id));
+	}
+	return req;
+}
 
 void stdx::basic_http_connection::_Read(std::function<void(stdx::http_request, std::exception_ptr)> callback)
 {
-	if (m_parser.error())
+	//已交付的请求没有读完的流式请求体直接丢弃
+	//当前请求体属于还未交付的请求时保留
+	if (m_parser.body_streaming() && m_parser.body_id() != m_parser.front_body_id())
 	{
-		callback(stdx::http_request(), std::make_exception_ptr(std::make_exception_ptr(stdx::parse_error("parse fault"))));
+		m_parser.skip_body();
+	}
+	//先交付流水线中已解析完成的请求
+	if (m_parser.finish_count())
+	{
+		callback(_Pop(), nullptr);
 		return;
 	}
-	else if (m_parser.finish_count())
+	else if (m_parser.error())
 	{
-		callback(m_parser.pop(), nullptr);
+		callback(stdx::http_request(), std::make_exception_ptr(std::make_exception_ptr(stdx::parse_error("parse fault"))));
 		return;
 	}
 	auto parser = m_parser;
 	stdx::cancel_token token;
 	stdx::socket sock = m_socket;
 	stdx::buffer buf = m_read_buf;
-	m_socket.recv_until(buf, token, [callback,token, parser](stdx::network_recv_event ev) mutable
+	m_socket.recv_until(buf, token, [this,callback,token, parser](stdx::network_recv_event ev) mutable
 	{
 			parser.push(ev.buffer, ev.size);
-			if (!parser.error())
+			if (parser.finish_count())
 			{
-				if (parser.finish_count())
-				{
-					callback(parser.pop(), nullptr);
-					token.cancel();
-				}
+				callback(_Pop(), nullptr);
+				token.cancel();
 			}
-			else
+			else if (parser.error())
 			{
 				callback(stdx::http_request(), std::make_exception_ptr(std::make_exception_ptr(stdx::parse_error("parse fault"))));
 			}
@@ -66,13 +266,19 @@ stdx::task<stdx::http_request> stdx::basic_http_connection::read()
 
 stdx::task<size_t> stdx::basic_http_connection::write(const stdx::http_response& package)
 {
-	auto vec = std::move(package.to_bytes());
-	stdx::buffer buf = stdx::make_buffer(vec.size());
-	for (size_t i = 0; i < vec.size(); i++)
+	stdx::output_buffer out(STDX_HTTP_OUTPUT_BLOCK_SIZE);
+	package.serialize_into(out);
+	std::vector<stdx::buffer_view> views = out.release();
+	if (views.size() == 1 && views.front().offset == 0)
 	{
-		buf[i] = vec[i];
+		return base_t::write(views.front().buffer, views.front().size);
 	}
-	auto t = base_t::write(buf, vec.size());
+	//响应体较大时分成多块,一次聚集发送
+	auto t = m_socket.send(std::move(views)).then([](stdx::task_result<stdx::network_send_event> r)
+	{
+		auto ev = r.get();
+		return (size_t)ev.size;
+	});
 	return t;
 }
 
@@ -99,14 +305,28 @@ void stdx::basic_http_connection::read_until(stdx::cancel_token token, std::func
 				err_handler(std::current_exception());
 			}
 		}
-		if (!token.is_cancel())
+		if (token.is_cancel())
 		{
-			read_until(token, fn, err_handler);
+			return;
+		}
+		//流式请求体读完、请求被释放或空闲超时后再读下一个请求
+		std::shared_ptr<stdx::_HttpBodyReader> reader = std::dynamic_pointer_cast<stdx::_HttpBodyReader>(req.body_reader());
+		if (reader)
+		{
+			req = stdx::http_request();
+			reader->watch_idle(STDX_HTTP_BODY_IDLE_TIMEOUT);
+			reader->wait_done().then([token, fn, err_handler, this](stdx::task_result<void> r) mutable
+			{
+				NO_USED(r);
+				read_until(token, fn, err_handler);
+			});
+			return;
 		}
+		read_until(token, fn, err_handler);
 	});
 }
 
-stdx::http_connection stdx::make_http_connection(const stdx::socket& sock, uint64_t max_size)
+stdx::http_connection stdx::make_http_connection(const stdx::socket& sock, uint64_t max_size, bool stream_body)
 {
-	return stdx::make_connection<stdx::basic_http_connection>(sock,max_size);
+	return stdx::make_connection<stdx::basic_http_connection>(sock,max_size,stream_body);
 }
\ No newline at end of file
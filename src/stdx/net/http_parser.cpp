@@ -1,348 +1,1443 @@
 #include <stdx/net/http_parser.h>
+#include <stdx/net/http_scan.h>
+
+size_t stdx::http_header_scanner::scan(const char* data, size_t size, size_t base)
+{
+	using state_t = stdx::http_header_scan_state;
+	for (size_t i = 0; i < size; ++i)
+	{
+		unsigned char ch = (unsigned char)data[i];
+		size_t pos = base + i;
+		switch (state)
+		{
+		case state_t::method:
+			if (ch == ' ' && pos != 0)
+			{
+				method_end = pos;
+				url_begin = pos + 1;
+				state = state_t::url;
+			}
+			else if (status_line ? (ch <= ' ' || ch == 0x7f) : !stdx::is_http_token_char(ch))
+			{
+				state = state_t::error;
+				return i;
+			}
+			break;
+		case state_t::url:
+			if (ch == ' ' && pos != url_begin)
+			{
+				url_end = pos;
+				version_begin = pos + 1;
+				state = state_t::version;
+			}
+			else if (status_line && (ch == '\r' || ch == '\n') && pos != url_begin)
+			{
+				//没有原因短语
+				url_end = pos;
+				version_begin = pos;
+				version_end = pos;
+				state = (ch == '\r') ? state_t::line_lf : state_t::field_start;
+			}
+			else if (ch <= ' ' || ch == 0x7f)
+			{
+				state = state_t::error;
+				return i;
+			}
+			else
+			{
+				//跳到下一个空白或控制字符
+				i = (stdx::http_find_ctl(data + i + 1, data + size, 0x21) - data) - 1;
+			}
+			break;
+		case state_t::version:
+			if (ch == '\r' || ch == '\n')
+			{
+				version_end = pos;
+				state = (ch == '\r') ? state_t::line_lf : state_t::field_start;
+			}
+			else if (status_line ? ((ch < ' ' && ch != '\t') || ch == 0x7f) : (ch <= ' ' || ch == 0x7f))
+			{
+				//原因短语可以包含空格
+				state = state_t::error;
+				return i;
+			}
+			break;
+		case state_t::line_lf:
+			if (ch != '\n')
+			{
+				state = state_t::error;
+				return i;
+			}
+			state = state_t::field_start;
+			break;
+		case state_t::field_start:
+			if (ch == '\r')
+			{
+				state = state_t::end_lf;
+			}
+			else if (ch == '\n')
+			{
+				state = state_t::done;
+				return i + 1;
+			}
+			else if (stdx::is_http_token_char(ch))
+			{
+				field.name_offset = pos;
+				state = state_t::name;
+			}
+			else
+			{
+				//不支持obs-fold
+				state = state_t::error;
+				return i;
+			}
+			break;
+		case state_t::name:
+			if (ch == ':')
+			{
+				field.name_size = pos - field.name_offset;
+				field.value_offset = pos + 1;
+				field.value_size = 0;
+				value_end = pos + 1;
+				state = state_t::value_start;
+			}
+			else if (!stdx::is_http_token_char(ch))
+			{
+				state = state_t::error;
+				return i;
+			}
+			break;
+		case state_t::value_start:
+		case state_t::value:
+			if (ch == '\r' || ch == '\n')
+			{
+				if (state == state_t::value_start)
+				{
+					field.value_offset = pos;
+					value_end = pos;
+				}
+				field.value_size = value_end - field.value_offset;
+				fields.push_back(field);
+				state = (ch == '\r') ? state_t::value_lf : state_t::field_start;
+			}
+			else if (ch == ' ' || ch == '\t')
+			{
+				//跳过前导空白,尾部空白不计入值
+			}
+			else if (ch < ' ' || ch == 0x7f)
+			{
+				state = state_t::error;
+				return i;
+			}
+			else
+			{
+				if (state == state_t::value_start)
+				{
+					field.value_offset = pos;
+					state = state_t::value;
+				}
+				//跳到下一个控制字符(HTAB、CR、LF),值的尾部空格不计入
+				const char* stop = stdx::http_find_ctl(data + i + 1, data + size, 0x20);
+				const char* last = stop;
+				while (last[-1] == ' ')
+				{
+					--last;
+				}
+				value_end = base + (last - data);
+				i = (stop - data) - 1;
+			}
+			break;
+		case state_t::value_lf:
+			if (ch != '\n')
+			{
+				state = state_t::error;
+				return i;
+			}
+			state = state_t::field_start;
+			break;
+		case state_t::end_lf:
+			if (ch != '\n')
+			{
+				state = state_t::error;
+				return i;
+			}
+			state = state_t::done;
+			return i + 1;
+		default:
+			return i;
+		}
+	}
+	return size;
+}
+
+void stdx::http_header_scanner::reset()
+{
+	state = stdx::http_header_scan_state::method;
+	method_end = 0;
+	url_begin = 0;
+	url_end = 0;
+	version_begin = 0;
+	version_end = 0;
+	value_end = 0;
+	fields.clear();
+}
+
+size_t stdx::http_chunk_decoder::decode(const char* data, size_t size, const char*& body, size_t& body_size)
+{
+	using state_t = stdx::http_chunk_decode_state;
+	body = nullptr;
+	body_size = 0;
+	for (size_t i = 0; i < size; ++i)
+	{
+		unsigned char ch = (unsigned char)data[i];
+		switch (state)
+		{
+		case state_t::size:
+			if ((ch >= '0' && ch <= '9') || (ch >= 'a' && ch <= 'f') || (ch >= 'A' && ch <= 'F'))
+			{
+				//最多15位,不会溢出
+				if (size_digits == 15)
+				{
+					state = state_t::error;
+					return i;
+				}
+				uint64_t digit = (ch <= '9') ? (ch - '0') : ((ch | 0x20) - 'a' + 10);
+				chunk_size = (chunk_size << 4) | digit;
+				size_digits += 1;
+			}
+			else if ((ch == ';' || ch == '\r') && size_digits != 0)
+			{
+				state = (ch == ';') ? state_t::extension : state_t::size_lf;
+			}
+			else
+			{
+				state = state_t::error;
+				return i;
+			}
+			break;
+		case state_t::extension:
+			//忽略块扩展,计入尾部大小限制
+			trailer_size += 1;
+			if (max_trailer_size != 0 && trailer_size > max_trailer_size)
+			{
+				state = state_t::error;
+				return i;
+			}
+			if (ch == '\r')
+			{
+				state = state_t::size_lf;
+			}
+			else if (ch == '\n')
+			{
+				state = state_t::error;
+				return i;
+			}
+			break;
+		case state_t::size_lf:
+			if (ch != '\n')
+			{
+				state = state_t::error;
+				return i;
+			}
+			if (chunk_size == 0)
+			{
+				state = state_t::trailer_start;
+				break;
+			}
+			if ((max_chunk_size != 0 && chunk_size > max_chunk_size) || (max_total != 0 && chunk_size > max_total - total))
+			{
+				state = state_t::error;
+				return i;
+			}
+			chunk_remain = chunk_size;
+			state = state_t::data;
+			break;
+		case state_t::data:
+			{
+				size_t n = (size_t)(std::min)(chunk_remain, (uint64_t)(size - i));
+				body = data + i;
+				body_size = n;
+				chunk_remain -= n;
+				total += n;
+				if (chunk_remain == 0)
+				{
+					state = state_t::data_cr;
+				}
+				return i + n;
+			}
+		case state_t::data_cr:
+			if (ch != '\r')
+			{
+				state = state_t::error;
+				return i;
+			}
+			state = state_t::data_lf;
+			break;
+		case state_t::data_lf:
+			if (ch != '\n')
+			{
+				state = state_t::error;
+				return i;
+			}
+			chunk_size = 0;
+			size_digits = 0;
+			state = state_t::size;
+			break;
+		case state_t::trailer_start:
+		case state_t::trailer:
+			trailer_size += 1;
+			if (max_trailer_size != 0 && trailer_size > max_trailer_size)
+			{
+				state = state_t::error;
+				return i;
+			}
+			if (ch == '\r')
+			{
+				state = (state == state_t::trailer_start) ? state_t::end_lf : state_t::trailer;
+			}
+			else if (ch == '\n' && state == state_t::trailer)
+			{
+				//尾部字段行结束
+				state = state_t::trailer_start;
+			}
+			else if (ch == '\n')
+			{
+				state = state_t::error;
+				return i;
+			}
+			else
+			{
+				state = state_t::trailer;
+			}
+			break;
+		case state_t::end_lf:
+			if (ch != '\n')
+			{
+				state = state_t::error;
+				return i;
+			}
+			state = state_t::done;
+			return i + 1;
+		default:
+			return i;
+		}
+	}
+	return size;
+}
+
+void stdx::http_chunk_decoder::reset()
+{
+	state = stdx::http_chunk_decode_state::size;
+	chunk_size = 0;
+	chunk_remain = 0;
+	size_digits = 0;
+	total = 0;
+	trailer_size = 0;
+}
 
 stdx::_HttpRequestParserState::_HttpRequestParserState(const model_ptr_t model)
 	:base_t()
 	,m_model(model)
 {}
 
-typename stdx::_HttpRequestParserState::model_t &stdx::_HttpRequestParserState::state()
+typename stdx::_HttpRequestParserState::model_t &stdx::_HttpRequestParserState::state()
+{
+	return *m_model;
+}
+
+const typename stdx::_HttpRequestParserState::model_t& stdx::_HttpRequestParserState::state() const
+{
+	return *m_model;
+}
+
+stdx::http_request_parser_state_machine stdx::_HttpRequestParserState::reset()
+{
+	_Consume(_ArgSize());
+	m_model->requests.clear();
+	m_model->request_body_ids.clear();
+	m_model->body_chunks.clear();
+	m_model->discard_body = false;
+	m_model->body_remain = 0;
+	return _NextRequest();
+}
+
+stdx::http_request_parser_state_machine stdx::_HttpRequestParserState::_NextRequest()
+{
+	m_model->header_buffer.clear();
+	m_model->scanner.reset();
+	m_model->chunk_decoder.reset();
+	m_model->body_buffer.clear();
+	m_model->header.reset();
+	m_model->state = stdx::http_parser_state::wait_header;
+	auto t = stdx::make_state_machine<stdx::_HttpRequestParserWaitHeaderState>(m_model);
+	return t;
+}
+
+void stdx::_HttpRequestParserState::_CheckArg() const
+{
+	if (_ArgSize() == 0)
+	{
+		throw std::invalid_argument("argument could not be empty");
+	}
+}
+
+const char* stdx::_HttpRequestParserState::_ArgData() const
+{
+	return m_model->arg.data() + m_model->arg_pos;
+}
+
+size_t stdx::_HttpRequestParserState::_ArgSize() const
+{
+	return m_model->arg.size() - m_model->arg_pos;
+}
+
+void stdx::_HttpRequestParserState::_Consume(size_t size)
+{
+	m_model->arg_pos += size;
+	if (m_model->arg_pos == m_model->arg.size())
+	{
+		m_model->arg.clear();
+		m_model->arg_pos = 0;
+	}
+}
+
+bool stdx::_HttpRequestParserState::is_end() const
+{
+	return false;
+}
+
+bool stdx::_HttpRequestParserState::movable() const
+{
+	if (!m_model)
+	{
+		return false;
+	}
+	return _ArgSize() != 0;
+}
+
+uint64_t stdx::_HttpRequestParserState::_GetBodySize() const
+{
+	std::string value;
+	if (!m_model->header || !m_model->header->raw_value("Content-Length", value))
+	{
+		return 0;
+	}
+	if (value.empty())
+	{
+		throw std::invalid_argument("invalid Content-Length");
+	}
+	uint64_t size = 0;
+	for (auto begin = value.begin(), end = value.end(); begin != end; ++begin)
+	{
+		if (*begin < '0' || *begin > '9')
+		{
+			throw std::invalid_argument("invalid Content-Length");
+		}
+		uint64_t digit = (uint64_t)(*begin - '0');
+		if (size > (UINT64_MAX - digit) / 10)
+		{
+			throw std::invalid_argument("invalid Content-Length");
+		}
+		size = size * 10 + digit;
+	}
+	return size;
+}
+
+bool stdx::_HttpRequestParserState::_IsChunked() const
+{
+	std::string value;
+	if (!m_model->header || !m_model->header->raw_value("Transfer-Encoding", value))
+	{
+		return false;
+	}
+	//只支持chunked,其他编码无法确定请求体长度
+	static const char chunked[] = "chunked";
+	if (value.size() != sizeof(chunked) - 1)
+	{
+		throw std::invalid_argument("unsupported Transfer-Encoding");
+	}
+	for (size_t i = 0; i < value.size(); ++i)
+	{
+		if ((value[i] | 0x20) != chunked[i])
+		{
+			throw std::invalid_argument("unsupported Transfer-Encoding");
+		}
+	}
+	//同时带有Content-Length时拒绝,避免请求走私
+	std::string length;
+	if (m_model->header->raw_value("Content-Length", length))
+	{
+		throw std::invalid_argument("Transfer-Encoding with Content-Length");
+	}
+	return true;
+}
+
+std::shared_ptr<stdx::http_request_header> stdx::_HttpRequestParserState::_MakeHeader()
+{
+	const stdx::http_header_scanner& scanner = m_model->scanner;
+	std::shared_ptr<std::string> raw = std::make_shared<std::string>(std::move(m_model->header_buffer));
+	m_model->header_buffer.clear();
+	auto header = std::make_shared<stdx::http_request_header>();
+	//请求行需要立即解析,其他头部在访问时转换
+	header->method() = stdx::make_http_method_by_string(stdx::string::from_u8_string(raw->substr(0, scanner.method_end)));
+	stdx::string url = stdx::string::from_u8_string(raw->substr(scanner.url_begin, scanner.url_end - scanner.url_begin));
+	url.u8_url_decode();
+	header->request_url() = std::move(url);
+	header->version() = stdx::make_http_version_by_string(stdx::string::from_u8_string(raw->substr(scanner.version_begin, scanner.version_end - scanner.version_begin)));
+	header->assign_raw(raw, std::move(m_model->scanner.fields));
+	m_model->scanner.reset();
+	return header;
+}
+
+stdx::http_form_ptr stdx::_HttpRequestParserState::_MakeForm()
+{
+	stdx::http_form_type type = stdx::http_form_type::urlencoded;
+	stdx::string boundary(U(""));
+	std::string content_type;
+	if (m_model->header->raw_value("Content-Type", content_type))
+	{
+		try
+		{
+			type = stdx::get_http_form_type_and_boundary(stdx::string::from_u8_string(content_type), boundary);
+		}
+		catch (const std::invalid_argument&)
+		{
+			//其他类型(例如application/json)按原始文本保存
+			type = stdx::http_form_type::text;
+		}
+	}
+	auto form = stdx::make_http_form(type, m_model->body_buffer, boundary);
+	m_model->body_buffer.clear();
+	return form;
+}
+
+void stdx::_HttpRequestParserState::_FinishParse(const stdx::http_form_ptr& form)
+{
+	stdx::http_request req(m_model->header, form);
+	m_model->requests.push_back(req);
+	m_model->request_body_ids.push_back(0);
+	m_model->header.reset();
+}
+
+void stdx::_HttpRequestParserState::_FinishParse()
+{
+	stdx::http_request req(m_model->header);
+	m_model->requests.push_back(req);
+	m_model->request_body_ids.push_back(0);
+	m_model->header.reset();
+}
+
+void stdx::_HttpRequestParserState::_StreamParse()
+{
+	m_model->body_id += 1;
+	stdx::http_request req(m_model->header);
+	m_model->requests.push_back(req);
+	m_model->request_body_ids.push_back(m_model->body_id);
+}
+
+stdx::_HttpRequestParserWaitHeaderState::_HttpRequestParserWaitHeaderState(const model_ptr_t model)
+	:base_t(model)
+{
+	model->state = stdx::http_parser_state::wait_header;
+}
+
+stdx::http_request_parser_state_machine stdx::_HttpRequestParserWaitHeaderState::move_next()
+{
+	_CheckArg();
+	//只扫描新收到的数据,不会重复扫描已缓冲的头部
+	size_t base = m_model->header_buffer.size();
+	size_t used = m_model->scanner.scan(_ArgData(), _ArgSize(), base);
+	if ((m_model->scanner.state == stdx::http_header_scan_state::error) || (base + used > m_model->max_size))
+	{
+		_Consume(_ArgSize());
+		auto t = stdx::make_state_machine<stdx::_HttpRequestParserErrorState>(m_model);
+		return t;
+	}
+	//只消耗到头部结束,剩余的数据属于请求体或下一个请求
+	m_model->header_buffer.append(_ArgData(), used);
+	_Consume(used);
+	if (m_model->scanner.state != stdx::http_header_scan_state::done)
+	{
+		auto t = stdx::make_state_machine<stdx::_HttpRequestParserWaitHeaderState>(m_model);
+		return t;
+	}
+	uint64_t body_size = 0;
+	bool chunked = false;
+	try
+	{
+		m_model->header = _MakeHeader();
+		chunked = _IsChunked();
+		if (!chunked)
+		{
+			body_size = _GetBodySize();
+		}
+	}
+	catch (const std::invalid_argument&)
+	{
+		_Consume(_ArgSize());
+		auto t = stdx::make_state_machine<stdx::_HttpRequestParserErrorState>(m_model);
+		return t;
+	}
+	if (chunked)
+	{
+		stdx::http_chunk_decoder& decoder = m_model->chunk_decoder;
+		decoder.reset();
+		//单个块和块扩展、尾部都受max_size限制,总大小在缓冲模式下受max_size限制
+		decoder.max_chunk_size = m_model->max_size;
+		decoder.max_trailer_size = (size_t)m_model->max_size;
+		decoder.max_total = m_model->stream_body ? m_model->max_stream_size : m_model->max_size;
+		if (m_model->stream_body)
+		{
+			_StreamParse();
+		}
+		auto t = stdx::make_state_machine<stdx::_HttpRequestParserChunkedBodyState>(m_model);
+		return t;
+	}
+	if (body_size == 0)
+	{
+		_FinishParse();
+		auto t = stdx::make_state_machine<stdx::_HttpRequestParserFinishState>(m_model);
+		return t;
+	}
+	if (m_model->stream_body)
+	{
+		if (m_model->max_stream_size != 0 && body_size > m_model->max_stream_size)
+		{
+			_Consume(_ArgSize());
+			auto t = stdx::make_state_machine<stdx::_HttpRequestParserErrorState>(m_model);
+			return t;
+		}
+		_StreamParse();
+		m_model->body_remain = body_size;
+		auto t = stdx::make_state_machine<stdx::_HttpRequestParserStreamBodyState>(m_model);
+		return t;
+	}
+	if (body_size > m_model->max_size)
+	{
+		_Consume(_ArgSize());
+		auto t = stdx::make_state_machine<stdx::_HttpRequestParserErrorState>(m_model);
+		return t;
+	}
+	auto t = stdx::make_state_machine<stdx::_HttpRequestParserWaitBodyState>(m_model);
+	return t;
+}
+
+stdx::_HttpRequestParserWaitBodyState::_HttpRequestParserWaitBodyState(const model_ptr_t model)
+	:base_t(model)
+{
+	m_model->state = stdx::http_parser_state::wait_body;
+}
+
+stdx::http_request_parser_state_machine stdx::_HttpRequestParserWaitBodyState::move_next()
+{
+	_CheckArg();
+	uint64_t body_size = _GetBodySize();
+	//只取属于当前请求的部分,多余的数据是下一个请求
+	size_t need = (size_t)(body_size - m_model->body_buffer.size());
+	size_t size = (std::min)(need, _ArgSize());
+	m_model->body_buffer.append(_ArgData(), size);
+	_Consume(size);
+	if (size != need)
+	{
+		auto t = stdx::make_state_machine<stdx::_HttpRequestParserWaitBodyState>(m_model);
+		return t;
+	}
+	try
+	{
+		auto form = _MakeForm();
+		_FinishParse(form);
+		auto t = stdx::make_state_machine<stdx::_HttpRequestParserFinishState>(m_model);
+		return t;
+	}
+	catch (const std::invalid_argument&)
+	{
+		_Consume(_ArgSize());
+		auto t = stdx::make_state_machine<stdx::_HttpRequestParserErrorState>(m_model);
+		return t;
+	}
+	catch (const std::exception &)
+	{
+		m_model->body_buffer.clear();
+		throw;
+	}
+}
+
+stdx::_HttpRequestParserStreamBodyState::_HttpRequestParserStreamBodyState(const model_ptr_t model)
+	:base_t(model)
+{
+	m_model->state = stdx::http_parser_state::stream_body;
+}
+
+stdx::http_request_parser_state_machine stdx::_HttpRequestParserStreamBodyState::move_next()
+{
+	_CheckArg();
+	size_t size = (size_t)(std::min)(m_model->body_remain, (uint64_t)_ArgSize());
+	if (!m_model->discard_body)
+	{
+		stdx::buffer buf = stdx::make_buffer(size);
+		memcpy((char*)buf, _ArgData(), size);
+		m_model->body_chunks.push_back(stdx::buffer_view(buf, 0, size));
+	}
+	_Consume(size);
+	m_model->body_remain -= size;
+	if (m_model->body_remain != 0)
+	{
+		auto t = stdx::make_state_machine<stdx::_HttpRequestParserStreamBodyState>(m_model);
+		return t;
+	}
+	m_model->discard_body = false;
+	m_model->header.reset();
+	auto t = stdx::make_state_machine<stdx::_HttpRequestParserFinishState>(m_model);
+	return t;
+}
+
+stdx::_HttpRequestParserChunkedBodyState::_HttpRequestParserChunkedBodyState(const model_ptr_t model)
+	:base_t(model)
+{
+	m_model->state = stdx::http_parser_state::chunked_body;
+}
+
+stdx::http_request_parser_state_machine stdx::_HttpRequestParserChunkedBodyState::move_next()
+{
+	_CheckArg();
+	stdx::http_chunk_decoder& decoder = m_model->chunk_decoder;
+	while (_ArgSize() != 0 && decoder.state != stdx::http_chunk_decode_state::done)
+	{
+		const char* body = nullptr;
+		size_t body_size = 0;
+		size_t used = decoder.decode(_ArgData(), _ArgSize(), body, body_size);
+		if (decoder.state == stdx::http_chunk_decode_state::error)
+		{
+			_Consume(_ArgSize());
+			auto t = stdx::make_state_machine<stdx::_HttpRequestParserErrorState>(m_model);
+			return t;
+		}
+		if (body_size != 0)
+		{
+			if (!m_model->stream_body)
+			{
+				m_model->body_buffer.append(body, body_size);
+			}
+			else if (!m_model->discard_body)
+			{
+				stdx::buffer buf = stdx::make_buffer(body_size);
+				memcpy((char*)buf, body, body_size);
+				m_model->body_chunks.push_back(stdx::buffer_view(buf, 0, body_size));
+			}
+		}
+		_Consume(used);
+	}
+	if (decoder.state != stdx::http_chunk_decode_state::done)
+	{
+		auto t = stdx::make_state_machine<stdx::_HttpRequestParserChunkedBodyState>(m_model);
+		return t;
+	}
+	if (m_model->stream_body)
+	{
+		m_model->discard_body = false;
+		m_model->header.reset();
+		auto t = stdx::make_state_machine<stdx::_HttpRequestParserFinishState>(m_model);
+		return t;
+	}
+	try
+	{
+		auto form = _MakeForm();
+		_FinishParse(form);
+		auto t = stdx::make_state_machine<stdx::_HttpRequestParserFinishState>(m_model);
+		return t;
+	}
+	catch (const std::invalid_argument&)
+	{
+		_Consume(_ArgSize());
+		auto t = stdx::make_state_machine<stdx::_HttpRequestParserErrorState>(m_model);
+		return t;
+	}
+	catch (const std::exception &)
+	{
+		m_model->body_buffer.clear();
+		throw;
+	}
+}
+
+stdx::_HttpRequestParserFinishState::_HttpRequestParserFinishState(const model_ptr_t model)
+	:base_t(model)
+{
+	model->state = stdx::http_parser_state::finish;
+}
+
+stdx::http_request_parser_state_machine stdx::_HttpRequestParserFinishState::move_next()
+{
+	//保留未解析的数据和未取出的请求,继续解析下一个请求
+	return _NextRequest();
+}
+
+stdx::_HttpRequestParserErrorState::_HttpRequestParserErrorState(const model_ptr_t model)
+	:base_t(model)
+{
+	model->state = stdx::http_parser_state::error;
+}
+
+stdx::http_request_parser_state_machine stdx::_HttpRequestParserErrorState::move_next()
+{
+	return reset();
+}
+
+bool stdx::_HttpRequestParserFinishState::is_end() const
+{
+	return true;
+}
+
+bool stdx::_HttpRequestParserFinishState::movable() const
+{
+	if (!m_model || !m_model->body_chunks.empty())
+	{
+		return false;
+	}
+	return base_t::movable();
+}
+
+bool stdx::_HttpRequestParserErrorState::is_end() const
+{
+	return true;
+}
+
+stdx::http_request_parser::http_request_parser(uint64_t max_size)
+	:m_model(std::make_shared<stdx::http_request_parser_model>())
+	,m_state_machine(std::make_shared<stdx::http_request_parser_state_machine>(stdx::make_state_machine<stdx::_HttpRequestParserWaitHeaderState>(m_model)))
+{
+	m_model->max_size = max_size;
+}
+
+stdx::http_request_parser::http_request_parser(const self_t& other)
+	:m_model(other.m_model)
+	,m_state_machine(other.m_state_machine)
+{}
+
+stdx::http_request_parser::http_request_parser(self_t&& other) noexcept
+	:m_model(std::move(other.m_model))
+	,m_state_machine(std::move(other.m_state_machine))
+{}
+
+typename stdx::http_request_parser::self_t& stdx::http_request_parser::operator=(const self_t& other)
+{
+	stdx::http_request_parser tmp(other);
+	stdx::copy_by_move(*this, std::move(tmp));
+	return *this;
+}
+
+typename stdx::http_request_parser::self_t& stdx::http_request_parser::operator=(self_t&& other) noexcept
+{
+	m_model = std::move(other.m_model);
+	m_state_machine = std::move(other.m_state_machine);
+	return *this;
+}
+
+void stdx::http_request_parser::push(stdx::buffer buf, size_t size)
+{
+	if (!buf.size() || (!buf.check()))
+	{
+		return;
+	}
+	m_model->arg.append(buf,size);
+	_Run();
+}
+
+size_t stdx::http_request_parser::finish_count() const
+{
+	return m_model->requests.size();
+}
+
+bool stdx::http_request_parser::error() const
+{
+	return m_model->state == stdx::http_parser_state::error;
+}
+
+bool stdx::http_request_parser::operator==(const self_t& other)
+{
+	return *m_state_machine == *other.m_state_machine && m_model == other.m_model;
+}
+
+stdx::http_request_parser::operator bool() const
+{
+	return m_state_machine && (*m_state_machine) && m_model;
+}
+
+stdx::http_request stdx::http_request_parser::pop()
+{
+	if (!m_model)
+	{
+		throw std::bad_alloc();
+	}
+	auto req = m_model->requests.front();
+	m_model->requests.pop_front();
+	m_model->request_body_ids.pop_front();
+	return req;
+}
+
+void stdx::http_request_parser::_Run()
+{
+	stdx::http_request_parser_state_machine& state_machine = *m_state_machine;
+	while (state_machine.movable())
+	{
+		state_machine = state_machine.move_next();
+	}
+}
+
+void stdx::http_request_parser::set_stream_body(bool enable)
+{
+	m_model->stream_body = enable;
+}
+
+void stdx::http_request_parser::set_max_stream_size(uint64_t size)
+{
+	m_model->max_stream_size = size;
+}
+
+uint64_t stdx::http_request_parser::front_body_id() const
+{
+	if (m_model->request_body_ids.empty())
+	{
+		return 0;
+	}
+	return m_model->request_body_ids.front();
+}
+
+uint64_t stdx::http_request_parser::body_id() const
+{
+	return m_model->body_id;
+}
+
+bool stdx::http_request_parser::_InStreamBody() const
+{
+	return m_model->state == stdx::http_parser_state::stream_body || (m_model->state == stdx::http_parser_state::chunked_body && m_model->stream_body);
+}
+
+bool stdx::http_request_parser::body_streaming() const
+{
+	return !m_model->body_chunks.empty() || _InStreamBody();
+}
+
+bool stdx::http_request_parser::body_chunk_ready() const
+{
+	return !m_model->body_chunks.empty();
+}
+
+stdx::buffer_view stdx::http_request_parser::pop_body_chunk()
+{
+	stdx::buffer_view chunk = m_model->body_chunks.front();
+	m_model->body_chunks.pop_front();
+	//取完后继续解析流水线中的下一个请求
+	_Run();
+	return chunk;
+}
+
+void stdx::http_request_parser::skip_body()
+{
+	m_model->body_chunks.clear();
+	if (_InStreamBody())
+	{
+		m_model->discard_body = true;
+	}
+	_Run();
+}
+stdx::_HttpResponseParserState::_HttpResponseParserState(const model_ptr_t model)
+	:base_t()
+	,m_model(model)
+{}
+
+typename stdx::_HttpResponseParserState::model_t& stdx::_HttpResponseParserState::state()
 {
 	return *m_model;
 }
 
-const typename stdx::_HttpRequestParserState::model_t& stdx::_HttpRequestParserState::state() const
+const typename stdx::_HttpResponseParserState::model_t& stdx::_HttpResponseParserState::state() const
 {
 	return *m_model;
 }
 
-stdx::http_request_parser_state_machine stdx::_HttpRequestParserState::reset()
+stdx::http_response_parser_state_machine stdx::_HttpResponseParserState::reset()
 {
-	m_model->arg.clear();
-	m_model->requests.clear();
-	m_model->header_buffer.clear();
-	m_model->body_buffer.clear();
-	m_model->header.reset();
-	m_model->state = stdx::http_parser_state::wait_header;
-	auto t = stdx::make_state_machine<stdx::_HttpRequestParserWaitHeaderState>(m_model);
-	return t;
+	_Consume(_ArgSize());
+	m_model->responses.clear();
+	m_model->methods.clear();
+	m_model->closed = false;
+	return _NextResponse();
 }
 
-void stdx::_HttpRequestParserState::_CheckArg() const
+bool stdx::_HttpResponseParserState::is_end() const
+{
+	return false;
+}
+
+bool stdx::_HttpResponseParserState::movable() const
 {
-	if (m_model->arg.empty())
+	if (!m_model)
+	{
+		return false;
+	}
+	return _ArgSize() != 0;
+}
+
+void stdx::_HttpResponseParserState::_CheckArg() const
+{
+	if (_ArgSize() == 0)
 	{
 		throw std::invalid_argument("argument could not be empty");
 	}
 }
 
-bool stdx::_HttpRequestParserState::is_end() const
+const char* stdx::_HttpResponseParserState::_ArgData() const
 {
-	return false;
+	return m_model->arg.data() + m_model->arg_pos;
 }
 
-bool stdx::_HttpRequestParserState::movable() const
+size_t stdx::_HttpResponseParserState::_ArgSize() const
 {
-	if (!m_model)
-	{
-		return false;
-	}
-	return !m_model->arg.empty();
+	return m_model->arg.size() - m_model->arg_pos;
 }
 
-uint64_t stdx::_HttpRequestParserState::_GetBodySize() const
+void stdx::_HttpResponseParserState::_Consume(size_t size)
 {
-	if (m_model->header)
+	m_model->arg_pos += size;
+	if (m_model->arg_pos == m_model->arg.size())
 	{
-		if (m_model->header->exist(U("Content-Length")))
-		{
-			return (*(m_model->header))[U("Content-Length")].to_uint64();
-		}
+		m_model->arg.clear();
+		m_model->arg_pos = 0;
 	}
-	return 0;
 }
 
-std::shared_ptr<stdx::http_request_header> stdx::_HttpRequestParserState::_MakeHeader()
+stdx::http_response_parser_state_machine stdx::_HttpResponseParserState::_NextResponse()
 {
-	auto header = std::make_shared<stdx::http_request_header>(stdx::http_request_header::from_string(stdx::string::from_u8_string(m_model->header_buffer)));
 	m_model->header_buffer.clear();
-	return header;
+	m_model->scanner.reset();
+	m_model->chunk_decoder.reset();
+	m_model->header.reset();
+	m_model->body.reset();
+	m_model->body_remain = 0;
+	m_model->body_size = 0;
+	auto t = stdx::make_state_machine<stdx::_HttpResponseParserWaitHeaderState>(m_model);
+	return t;
 }
 
-stdx::http_form_ptr stdx::_HttpRequestParserState::_MakeForm()
+std::shared_ptr<stdx::http_response_header> stdx::_HttpResponseParserState::_MakeHeader()
 {
-	stdx::http_form_type type = stdx::http_form_type::urlencoded;
-	stdx::string boundary(U(""));
-	if (m_model->header->exist(U("Content-Type")))
+	const stdx::http_header_scanner& scanner = m_model->scanner;
+	std::shared_ptr<std::string> raw = std::make_shared<std::string>(std::move(m_model->header_buffer));
+	m_model->header_buffer.clear();
+	//状态码必须是3位数字
+	if (scanner.url_end - scanner.url_begin != 3)
 	{
-		type = stdx::get_http_form_type_and_boundary((*(m_model->header))[U("Content-Length")], boundary);
+		throw std::invalid_argument("invalid status code");
 	}
-	auto form = stdx::make_http_form(type, m_model->body_buffer, boundary);
-	m_model->body_buffer.clear();
-	return form;
+	stdx::http_status_code_t code = 0;
+	for (size_t i = scanner.url_begin; i != scanner.url_end; ++i)
+	{
+		char ch = (*raw)[i];
+		if (ch < '0' || ch > '9')
+		{
+			throw std::invalid_argument("invalid status code");
+		}
+		code = code * 10 + (stdx::http_status_code_t)(ch - '0');
+	}
+	stdx::http_version version = stdx::make_http_version_by_string(stdx::string::from_u8_string(raw->substr(0, scanner.method_end)));
+	auto header = std::make_shared<stdx::http_response_header>(version, code);
+	header->assign_raw(raw, std::move(m_model->scanner.fields));
+	m_model->scanner.reset();
+	return header;
 }
 
-void stdx::_HttpRequestParserState::_FinishParse(const stdx::http_form_ptr& form)
+void stdx::_HttpResponseParserState::_PushBody(const char* data, size_t size)
 {
-	stdx::http_request req(m_model->header, form);
-	m_model->requests.push_back(req);
+	stdx::buffer buf = stdx::make_buffer(size);
+	memcpy((char*)buf, data, size);
+	m_model->body->push(stdx::buffer_view(buf, 0, size));
+}
+
+void stdx::_HttpResponseParserState::_FinishParse()
+{
+	if (!m_model->body)
+	{
+		m_model->body = std::make_shared<stdx::http_identity_body>();
+	}
+	stdx::http_response res(m_model->header, m_model->body);
+	m_model->responses.push_back(res);
 	m_model->header.reset();
+	m_model->body.reset();
 }
 
-void stdx::_HttpRequestParserState::_FinishParse()
+stdx::http_response_parser_state_machine stdx::_HttpResponseParserState::_Error()
 {
-	stdx::http_request req(m_model->header);
-	m_model->requests.push_back(req);
+	_Consume(_ArgSize());
 	m_model->header.reset();
+	m_model->body.reset();
+	auto t = stdx::make_state_machine<stdx::_HttpResponseParserErrorState>(m_model);
+	return t;
 }
 
-stdx::_HttpRequestParserWaitHeaderState::_HttpRequestParserWaitHeaderState(const model_ptr_t model)
+stdx::_HttpResponseParserWaitHeaderState::_HttpResponseParserWaitHeaderState(const model_ptr_t model)
 	:base_t(model)
 {
 	model->state = stdx::http_parser_state::wait_header;
 }
 
-stdx::http_request_parser_state_machine stdx::_HttpRequestParserWaitHeaderState::move_next()
+stdx::http_response_parser_state_machine stdx::_HttpResponseParserWaitHeaderState::move_next()
 {
 	_CheckArg();
-	uint64_t size = m_model->header_buffer.size() + m_model->arg.size();
-	if (size > m_model->max_size)
+	size_t base = m_model->header_buffer.size();
+	size_t used = m_model->scanner.scan(_ArgData(), _ArgSize(), base);
+	if ((m_model->scanner.state == stdx::http_header_scan_state::error) || (base + used > m_model->max_size))
 	{
-		m_model->arg.clear();
-		auto t = stdx::make_state_machine<stdx::_HttpRequestParserErrorState>(m_model);
+		return _Error();
+	}
+	m_model->header_buffer.append(_ArgData(), used);
+	_Consume(used);
+	if (m_model->scanner.state != stdx::http_header_scan_state::done)
+	{
+		auto t = stdx::make_state_machine<stdx::_HttpResponseParserWaitHeaderState>(m_model);
 		return t;
 	}
-	size_t pos = m_model->arg.rfind("\r\n\r\n");
-	if (pos == std::string::npos)
+	std::string transfer_encoding;
+	std::string content_length;
+	try
 	{
-		m_model->header_buffer.append(m_model->arg);
-		m_model->arg.clear();
-		auto t = stdx::make_state_machine<stdx::_HttpRequestParserWaitHeaderState>(m_model);
+		m_model->header = _MakeHeader();
+	}
+	catch (const std::invalid_argument&)
+	{
+		return _Error();
+	}
+	stdx::http_status_code_t code = m_model->header->status_code();
+	//1xx中间响应(除了101)之后还有最终响应
+	if (code >= 100 && code < 200 && code != 101)
+	{
+		return _NextResponse();
+	}
+	stdx::http_method method = stdx::http_method::get;
+	if (!m_model->methods.empty())
+	{
+		method = m_model->methods.front();
+		m_model->methods.pop_front();
+	}
+	//RFC7230 3.3.3
+	if (method == stdx::http_method::head || code < 200 || code == 204 || code == 304)
+	{
+		_FinishParse();
+		auto t = stdx::make_state_machine<stdx::_HttpResponseParserFinishState>(m_model);
 		return t;
 	}
-	size_t end = m_model->arg.size();
-	if ((pos+4)==end)
+	bool has_length = m_model->header->raw_value("Content-Length", content_length);
+	if (m_model->header->raw_value("Transfer-Encoding", transfer_encoding))
 	{
-		m_model->header_buffer.append(m_model->arg);
-		m_model->arg.clear();
-		try
+		//同时带有Content-Length时拒绝
+		if (has_length)
 		{
-			m_model->header = _MakeHeader();
-			if (m_model->header->method() == stdx::http_method::get)
-			{
-				_FinishParse();
-				auto t = stdx::make_state_machine<stdx::_HttpRequestParserFinishState>(m_model);
-				return t;
-			}
-			else
-			{
-				uint64_t size = _GetBodySize();
-				if (size > m_model->max_size)
-				{
-					auto t = stdx::make_state_machine<stdx::_HttpRequestParserErrorState>(m_model);
-					return t;
-				}
-				else
-				{
-					auto t = stdx::make_state_machine<stdx::_HttpRequestParserWaitBodyState>(m_model);
-					return t;
-				}
-			}
+			return _Error();
 		}
-		catch (const std::invalid_argument&)
+		bool chunked = transfer_encoding.size() == 7;
+		for (size_t i = 0; chunked && i < 7; ++i)
 		{
-			auto t = stdx::make_state_machine<stdx::_HttpRequestParserErrorState>(m_model);
-			return t;
+			chunked = (transfer_encoding[i] | 0x20) == "chunked"[i];
 		}
-		catch (const std::exception&)
+		if (!chunked)
 		{
-			throw;
+			//无法解码的编码,响应体到连接关闭为止
+			m_model->body = std::make_shared<stdx::http_identity_body>();
+			auto t = stdx::make_state_machine<stdx::_HttpResponseParserUntilCloseState>(m_model);
+			return t;
 		}
+		stdx::http_chunk_decoder& decoder = m_model->chunk_decoder;
+		decoder.reset();
+		decoder.max_chunk_size = m_model->max_size;
+		decoder.max_trailer_size = (size_t)m_model->max_size;
+		decoder.max_total = m_model->max_size;
+		m_model->body = std::make_shared<stdx::http_chunk_body>();
+		auto t = stdx::make_state_machine<stdx::_HttpResponseParserChunkedBodyState>(m_model);
+		return t;
 	}
-	else
+	m_model->body = std::make_shared<stdx::http_identity_body>();
+	if (!has_length)
 	{
-		m_model->header_buffer.append(m_model->arg.c_str(),pos);
-		m_model->header = _MakeHeader();
-		try
-		{
-			uint64_t size = _GetBodySize();
-			if (size > m_model->max_size)
-			{
-				m_model->arg.clear();
-				auto t = stdx::make_state_machine<stdx::_HttpRequestParserErrorState>(m_model);
-				return t;
-			}
-		}
-		catch (const std::invalid_argument&)
+		auto t = stdx::make_state_machine<stdx::_HttpResponseParserUntilCloseState>(m_model);
+		return t;
+	}
+	if (content_length.empty())
+	{
+		return _Error();
+	}
+	uint64_t body_size = 0;
+	for (auto begin = content_length.begin(), end = content_length.end(); begin != end; ++begin)
+	{
+		if (*begin < '0' || *begin > '9')
 		{
-			m_model->arg.clear();
-			auto t = stdx::make_state_machine<stdx::_HttpRequestParserErrorState>(m_model);
-			return t;
+			return _Error();
 		}
-		catch (const std::exception&)
+		uint64_t digit = (uint64_t)(*begin - '0');
+		if (body_size > (UINT64_MAX - digit) / 10)
 		{
-			m_model->arg.clear();
-			throw;
+			return _Error();
 		}
-		m_model->arg.erase(0, pos+4);
-		auto t = stdx::make_state_machine<stdx::_HttpRequestParserWaitBodyState>(m_model);
+		body_size = body_size * 10 + digit;
+	}
+	if (body_size > m_model->max_size)
+	{
+		return _Error();
+	}
+	if (body_size == 0)
+	{
+		_FinishParse();
+		auto t = stdx::make_state_machine<stdx::_HttpResponseParserFinishState>(m_model);
 		return t;
 	}
+	m_model->body_remain = body_size;
+	auto t = stdx::make_state_machine<stdx::_HttpResponseParserWaitBodyState>(m_model);
+	return t;
 }
 
-stdx::_HttpRequestParserWaitBodyState::_HttpRequestParserWaitBodyState(const model_ptr_t model)
+stdx::_HttpResponseParserWaitBodyState::_HttpResponseParserWaitBodyState(const model_ptr_t model)
 	:base_t(model)
 {
-	m_model->state = stdx::http_parser_state::wait_body;
+	model->state = stdx::http_parser_state::wait_body;
 }
 
-stdx::http_request_parser_state_machine stdx::_HttpRequestParserWaitBodyState::move_next()
+stdx::http_response_parser_state_machine stdx::_HttpResponseParserWaitBodyState::move_next()
 {
 	_CheckArg();
-	uint64_t size = m_model->arg.size() + m_model->body_buffer.size();
-	if (size > m_model->max_size)
+	size_t size = (size_t)(std::min)(m_model->body_remain, (uint64_t)_ArgSize());
+	_PushBody(_ArgData(), size);
+	_Consume(size);
+	m_model->body_remain -= size;
+	if (m_model->body_remain != 0)
 	{
-		m_model->arg.clear();
-		auto t = stdx::make_state_machine<stdx::_HttpRequestParserErrorState>(m_model);
+		auto t = stdx::make_state_machine<stdx::_HttpResponseParserWaitBodyState>(m_model);
 		return t;
 	}
-	uint64_t body_size = _GetBodySize();
-	if (size == body_size)
+	_FinishParse();
+	auto t = stdx::make_state_machine<stdx::_HttpResponseParserFinishState>(m_model);
+	return t;
+}
+
+stdx::_HttpResponseParserChunkedBodyState::_HttpResponseParserChunkedBodyState(const model_ptr_t model)
+	:base_t(model)
+{
+	model->state = stdx::http_parser_state::chunked_body;
+}
+
+stdx::http_response_parser_state_machine stdx::_HttpResponseParserChunkedBodyState::move_next()
+{
+	_CheckArg();
+	stdx::http_chunk_decoder& decoder = m_model->chunk_decoder;
+	while (_ArgSize() != 0 && decoder.state != stdx::http_chunk_decode_state::done)
 	{
-		m_model->body_buffer.append(m_model->arg);
-		m_model->arg.clear();
-		try
+		const char* body = nullptr;
+		size_t body_size = 0;
+		size_t used = decoder.decode(_ArgData(), _ArgSize(), body, body_size);
+		if (decoder.state == stdx::http_chunk_decode_state::error)
 		{
-			auto form = _MakeForm();
-			_FinishParse(form);
-			auto t = stdx::make_state_machine<stdx::_HttpRequestParserFinishState>(m_model);
-			return t;
+			return _Error();
 		}
-		catch (const std::invalid_argument&)
+		if (body_size != 0)
 		{
-			auto t = stdx::make_state_machine<stdx::_HttpRequestParserErrorState>(m_model);
-			return t;
+			_PushBody(body, body_size);
 		}
-		catch (const std::exception &)
+		_Consume(used);
+	}
+	if (decoder.state != stdx::http_chunk_decode_state::done)
+	{
+		auto t = stdx::make_state_machine<stdx::_HttpResponseParserChunkedBodyState>(m_model);
+		return t;
+	}
+	_FinishParse();
+	auto t = stdx::make_state_machine<stdx::_HttpResponseParserFinishState>(m_model);
+	return t;
+}
+
+stdx::_HttpResponseParserUntilCloseState::_HttpResponseParserUntilCloseState(const model_ptr_t model)
+	:base_t(model)
+{
+	model->state = stdx::http_parser_state::until_close;
+}
+
+stdx::http_response_parser_state_machine stdx::_HttpResponseParserUntilCloseState::move_next()
+{
+	size_t size = _ArgSize();
+	if (size != 0)
+	{
+		if (m_model->body_size + size > m_model->max_size)
 		{
-			m_model->body_buffer.clear();
-			throw;
+			return _Error();
 		}
+		_PushBody(_ArgData(), size);
+		_Consume(size);
+		m_model->body_size += size;
 	}
-	else if (size > body_size)
+	if (!m_model->closed)
 	{
-		m_model->arg.clear();
-		auto t = stdx::make_state_machine<stdx::_HttpRequestParserErrorState>(m_model);
+		auto t = stdx::make_state_machine<stdx::_HttpResponseParserUntilCloseState>(m_model);
 		return t;
 	}
-	m_model->body_buffer.append(m_model->arg);
-	m_model->arg.clear();
-	auto t = stdx::make_state_machine<stdx::_HttpRequestParserWaitBodyState>(m_model);
+	_FinishParse();
+	auto t = stdx::make_state_machine<stdx::_HttpResponseParserFinishState>(m_model);
 	return t;
 }
 
-stdx::_HttpRequestParserFinishState::_HttpRequestParserFinishState(const model_ptr_t model)
+bool stdx::_HttpResponseParserUntilCloseState::movable() const
+{
+	if (!m_model)
+	{
+		return false;
+	}
+	return m_model->closed || base_t::movable();
+}
+
+stdx::_HttpResponseParserFinishState::_HttpResponseParserFinishState(const model_ptr_t model)
 	:base_t(model)
 {
 	model->state = stdx::http_parser_state::finish;
 }
 
-stdx::http_request_parser_state_machine stdx::_HttpRequestParserFinishState::move_next()
+stdx::http_response_parser_state_machine stdx::_HttpResponseParserFinishState::move_next()
 {
-	return reset();
+	return _NextResponse();
 }
 
-stdx::_HttpRequestParserErrorState::_HttpRequestParserErrorState(const model_ptr_t model)
+bool stdx::_HttpResponseParserFinishState::is_end() const
+{
+	return true;
+}
+
+stdx::_HttpResponseParserErrorState::_HttpResponseParserErrorState(const model_ptr_t model)
 	:base_t(model)
 {
 	model->state = stdx::http_parser_state::error;
 }
 
-stdx::http_request_parser_state_machine stdx::_HttpRequestParserErrorState::move_next()
+stdx::http_response_parser_state_machine stdx::_HttpResponseParserErrorState::move_next()
 {
 	return reset();
 }
 
-bool stdx::_HttpRequestParserFinishState::is_end() const
+bool stdx::_HttpResponseParserErrorState::is_end() const
 {
 	return true;
 }
 
-bool stdx::_HttpRequestParserErrorState::is_end() const
+bool stdx::_HttpResponseParserErrorState::movable() const
 {
-	return true;
+	return false;
 }
 
-stdx::http_request_parser::http_request_parser(uint64_t max_size)
-	:m_model(std::make_shared<stdx::http_request_parser_model>())
-	,m_state_machine(stdx::make_state_machine<stdx::_HttpRequestParserWaitHeaderState>(m_model))
+stdx::http_response_parser::http_response_parser(uint64_t max_size)
+	:m_model(std::make_shared<stdx::http_response_parser_model>())
+	,m_state_machine(std::make_shared<stdx::http_response_parser_state_machine>(stdx::make_state_machine<stdx::_HttpResponseParserWaitHeaderState>(m_model)))
 {
 	m_model->max_size = max_size;
+	m_model->scanner.status_line = true;
 }
 
-stdx::http_request_parser::http_request_parser(const self_t& other)
+stdx::http_response_parser::http_response_parser(const self_t& other)
 	:m_model(other.m_model)
 	,m_state_machine(other.m_state_machine)
 {}
 
-stdx::http_request_parser::http_request_parser(self_t&& other) noexcept
+stdx::http_response_parser::http_response_parser(self_t&& other) noexcept
 	:m_model(std::move(other.m_model))
 	,m_state_machine(std::move(other.m_state_machine))
 {}
 
-typename stdx::http_request_parser::self_t& stdx::http_request_parser::operator=(const self_t& other)
+typename stdx::http_response_parser::self_t& stdx::http_response_parser::operator=(const self_t& other)
 {
-	stdx::http_request_parser tmp(other);
+	stdx::http_response_parser tmp(other);
 	stdx::copy_by_move(*this, std::move(tmp));
 	return *this;
 }
 
-typename stdx::http_request_parser::self_t& stdx::http_request_parser::operator=(self_t&& other) noexcept
+typename stdx::http_response_parser::self_t& stdx::http_response_parser::operator=(self_t&& other) noexcept
 {
 	m_model = std::move(other.m_model);
 	m_state_machine = std::move(other.m_state_machine);
 	return *this;
 }
 
-void stdx::http_request_parser::push(stdx::buffer buf, size_t size)
+void stdx::http_response_parser::expect(stdx::http_method method)
 {
-	if (!buf.size() || (!buf.check()))
+	m_model->methods.push_back(method);
+}
+
+void stdx::http_response_parser::push(stdx::buffer buf, size_t size)
+{
+	if (!buf.size() || (!buf.check()) || m_model->closed)
 	{
 		return;
 	}
-	m_model->arg.append(buf,size);
-	while (m_state_machine.movable())
+	m_model->arg.append(buf, size);
+	_Run();
+}
+
+void stdx::http_response_parser::close()
+{
+	if (m_model->closed)
+	{
+		return;
+	}
+	m_model->closed = true;
+	stdx::http_parser_state state = m_model->state;
+	if (state == stdx::http_parser_state::until_close)
+	{
+		_Run();
+		return;
+	}
+	bool partial = (state == stdx::http_parser_state::wait_body) || (state == stdx::http_parser_state::chunked_body) || !m_model->header_buffer.empty();
+	if (partial)
 	{
-		m_state_machine = m_state_machine.move_next();
+		m_model->header.reset();
+		m_model->body.reset();
+		*m_state_machine = stdx::make_state_machine<stdx::_HttpResponseParserErrorState>(m_model);
 	}
 }
 
-size_t stdx::http_request_parser::finish_count() const
+size_t stdx::http_response_parser::finish_count() const
 {
-	return m_model->requests.size();
+	return m_model->responses.size();
 }
 
-bool stdx::http_request_parser::error() const
+bool stdx::http_response_parser::error() const
 {
 	return m_model->state == stdx::http_parser_state::error;
 }
 
-bool stdx::http_request_parser::operator==(const self_t& other)
+bool stdx::http_response_parser::idle() const
 {
-	return m_state_machine == other.m_state_machine && m_model == other.m_model;
+	stdx::http_parser_state state = m_model->state;
+	bool waiting = (state == stdx::http_parser_state::finish) || (state == stdx::http_parser_state::wait_header && m_model->header_buffer.empty());
+	return waiting && m_model->responses.empty() && m_model->arg.empty();
 }
 
-stdx::http_request_parser::operator bool() const
+stdx::http_response stdx::http_response_parser::pop()
+{
+	if (!m_model)
+	{
+		throw std::bad_alloc();
+	}
+	auto res = m_model->responses.front();
+	m_model->responses.pop_front();
+	return res;
+}
+
+bool stdx::http_response_parser::operator==(const self_t& other)
 {
-	return m_state_machine && m_model;
+	return *m_state_machine == *other.m_state_machine && m_model == other.m_model;
 }
 
-stdx::http_request stdx::http_request_parser::pop()
+stdx::http_response_parser::operator bool() const
 {
-	if (!m_model)
+	return m_state_machine && (*m_state_machine) && m_model;
+}
+
+void stdx::http_response_parser::_Run()
+{
+	stdx::http_response_parser_state_machine& state_machine = *m_state_machine;
+	while (state_machine.movable())
 	{
-		throw std::bad_alloc();
+		state_machine = state_machine.move_next();
 	}
-	auto req = m_model->requests.front();
-	m_model->requests.pop_front();
-	return req;
-}
\ No newline at end of file
+}
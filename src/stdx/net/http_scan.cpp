@@ -0,0 +1,186 @@
+#include <stdx/net/http_scan.h>
+
+#ifdef STDX_HTTP_SCAN_X86
+#ifdef _MSC_VER
+#include <intrin.h>
+#define STDX_SCAN_TARGET(arch)
+#else
+#include <immintrin.h>
+#define STDX_SCAN_TARGET(arch) __attribute__((target(arch)))
+#endif
+#endif
+
+const bool stdx::http_token_table[256] =
+{
+	0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+	0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+	0,1,0,1,1,1,1,1,0,0,1,1,0,1,1,0,
+	1,1,1,1,1,1,1,1,1,1,0,0,0,0,0,0,
+	0,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,
+	1,1,1,1,1,1,1,1,1,1,1,0,0,0,1,1,
+	1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,
+	1,1,1,1,1,1,1,1,1,1,1,0,1,0,1,0,
+	0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+	0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+	0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+	0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+	0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+	0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+	0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+	0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0
+};
+
+static const char* _FindCtlScalar(const char* begin, const char* end, unsigned char limit)
+{
+	while (begin != end)
+	{
+		unsigned char ch = (unsigned char)*begin;
+		if (ch < limit || ch == 0x7f)
+		{
+			return begin;
+		}
+		++begin;
+	}
+	return end;
+}
+
+#ifdef STDX_HTTP_SCAN_X86
+static inline unsigned _CountTrailingZero(uint32_t mask)
+{
+#ifdef _MSC_VER
+	unsigned long index = 0;
+	_BitScanForward(&index, mask);
+	return (unsigned)index;
+#else
+	return (unsigned)__builtin_ctz(mask);
+#endif
+}
+
+//v<limit等价于min(v,limit-1)==v(无符号比较)
+STDX_SCAN_TARGET("sse2")
+static const char* _FindCtlSse2(const char* begin, const char* end, unsigned char limit)
+{
+	const __m128i lim = _mm_set1_epi8((char)(limit - 1));
+	const __m128i del = _mm_set1_epi8(0x7f);
+	while (end - begin >= 16)
+	{
+		__m128i v = _mm_loadu_si128((const __m128i*)begin);
+		__m128i hit = _mm_or_si128(_mm_cmpeq_epi8(_mm_min_epu8(v, lim), v), _mm_cmpeq_epi8(v, del));
+		uint32_t mask = (uint32_t)_mm_movemask_epi8(hit);
+		if (mask != 0)
+		{
+			return begin + _CountTrailingZero(mask);
+		}
+		begin += 16;
+	}
+	return _FindCtlScalar(begin, end, limit);
+}
+
+STDX_SCAN_TARGET("avx2")
+static const char* _FindCtlAvx2(const char* begin, const char* end, unsigned char limit)
+{
+	const __m256i lim = _mm256_set1_epi8((char)(limit - 1));
+	const __m256i del = _mm256_set1_epi8(0x7f);
+	while (end - begin >= 32)
+	{
+		__m256i v = _mm256_loadu_si256((const __m256i*)begin);
+		__m256i hit = _mm256_or_si256(_mm256_cmpeq_epi8(_mm256_min_epu8(v, lim), v), _mm256_cmpeq_epi8(v, del));
+		uint32_t mask = (uint32_t)_mm256_movemask_epi8(hit);
+		if (mask != 0)
+		{
+			return begin + _CountTrailingZero(mask);
+		}
+		begin += 32;
+	}
+	return _FindCtlSse2(begin, end, limit);
+}
+
+static bool _CpuHasAvx2()
+{
+#ifdef _MSC_VER
+	int info[4];
+	__cpuid(info, 0);
+	if (info[0] < 7)
+	{
+		return false;
+	}
+	__cpuid(info, 1);
+	//OSXSAVE与AVX
+	if ((info[2] & (1 << 27)) == 0 || (info[2] & (1 << 28)) == 0)
+	{
+		return false;
+	}
+	//操作系统保存了YMM寄存器
+	if ((_xgetbv(0) & 6) != 6)
+	{
+		return false;
+	}
+	__cpuidex(info, 7, 0);
+	return (info[1] & (1 << 5)) != 0;
+#else
+	__builtin_cpu_init();
+	return __builtin_cpu_supports("avx2");
+#endif
+}
+
+static bool _CpuHasSse2()
+{
+#if defined(__x86_64__) || defined(_M_X64)
+	return true;
+#elif defined(_MSC_VER)
+	int info[4];
+	__cpuid(info, 1);
+	return (info[3] & (1 << 26)) != 0;
+#else
+	__builtin_cpu_init();
+	return __builtin_cpu_supports("sse2");
+#endif
+}
+#endif
+
+struct _HttpScanKernel
+{
+	const char* (*find_ctl)(const char*, const char*, unsigned char);
+	const char* name;
+};
+
+static _HttpScanKernel _SelectHttpScanKernel()
+{
+	_HttpScanKernel kernel;
+	kernel.find_ctl = &_FindCtlScalar;
+	kernel.name = "scalar";
+#ifdef STDX_HTTP_SCAN_X86
+	if (_CpuHasAvx2())
+	{
+		kernel.find_ctl = &_FindCtlAvx2;
+		kernel.name = "avx2";
+	}
+	else if (_CpuHasSse2())
+	{
+		kernel.find_ctl = &_FindCtlSse2;
+		kernel.name = "sse2";
+	}
+#endif
+	return kernel;
+}
+
+static const _HttpScanKernel& _GetHttpScanKernel()
+{
+	static const _HttpScanKernel kernel = _SelectHttpScanKernel();
+	return kernel;
+}
+
+const char* stdx::http_find_ctl(const char* begin, const char* end, unsigned char limit)
+{
+	//短数据直接用标量,避免调用开销
+	if (end - begin < 16)
+	{
+		return _FindCtlScalar(begin, end, limit);
+	}
+	return _GetHttpScanKernel().find_ctl(begin, end, limit);
+}
+
+const char* stdx::http_scan_kernel_name()
+{
+	return _GetHttpScanKernel().name;
+}
@@ -0,0 +1,450 @@
+#include <stdx/net/http_static.h>
+#include <stdx/datetime.h>
+#include <sys/stat.h>
+#ifdef LINUX
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+stdx::_HttpStaticFileHandler::_HttpStaticFileHandler(const stdx::string& root, size_t cache_size, uint64_t revalidate_ms)
+	:m_root(root.to_u8_string())
+	,m_cache_size(cache_size != 0 ? cache_size : 1)
+	,m_revalidate(revalidate_ms)
+	,m_lock()
+	,m_lru()
+	,m_cache()
+{
+	while (!m_root.empty() && (m_root.back() == '/' || m_root.back() == '\\'))
+	{
+		m_root.pop_back();
+	}
+}
+
+bool stdx::_HttpStaticFileHandler::_MapPath(const stdx::string& url, std::string& path) const
+{
+	std::string u8 = url.to_u8_string();
+	size_t pos = u8.find_first_of("?#");
+	if (pos != std::string::npos)
+	{
+		u8.erase(pos);
+	}
+	if (u8.empty() || u8[0] != '/')
+	{
+		return false;
+	}
+	//逐段检查,不允许..和反斜杠,避免访问root之外的文件
+	size_t begin = 1;
+	while (begin <= u8.size())
+	{
+		size_t end = u8.find('/', begin);
+		if (end == std::string::npos)
+		{
+			end = u8.size();
+		}
+		if (end - begin == 2 && u8[begin] == '.' && u8[begin + 1] == '.')
+		{
+			return false;
+		}
+		begin = end + 1;
+	}
+	if (u8.find('\\') != std::string::npos || u8.find('\0') != std::string::npos)
+	{
+		return false;
+	}
+	if (u8.back() == '/')
+	{
+		u8.append("index.html");
+	}
+	path = m_root + u8;
+	return true;
+}
+
+stdx::_HttpStaticFileHandler::file_ptr_t stdx::_HttpStaticFileHandler::_Open(const std::string& path)
+{
+	uint64_t now = stdx::get_tick_count();
+	file_ptr_t cached;
+	std::unique_lock<lock_t> lock(m_lock);
+	auto it = m_cache.find(path);
+	if (it != m_cache.end())
+	{
+		m_lru.splice(m_lru.begin(), m_lru, it->second.lru);
+		cached = it->second.file;
+		if (now - it->second.check_tick < m_revalidate)
+		{
+			return cached;
+		}
+	}
+	lock.unlock();
+	//重新检查路径,文件被修改或替换时重新打开
+#ifdef WIN32
+	struct _stat64 st;
+	if (::_wstat64(stdx::string::from_u8_string(path).c_str(), &st) != 0 || !(st.st_mode & _S_IFREG))
+	{
+		_Erase(path);
+		return nullptr;
+	}
+	uint64_t inode = 0;
+#else
+	struct stat st;
+	if (::stat(path.c_str(), &st) != 0 || !S_ISREG(st.st_mode))
+	{
+		_Erase(path);
+		return nullptr;
+	}
+	uint64_t inode = (uint64_t)st.st_ino;
+#endif
+	if (cached && cached->size == (uint64_t)st.st_size && cached->mtime == (time_t)st.st_mtime && cached->inode == inode)
+	{
+		lock.lock();
+		auto pos = m_cache.find(path);
+		if (pos != m_cache.end() && pos->second.file == cached)
+		{
+			pos->second.check_tick = now;
+		}
+		return cached;
+	}
+	file_ptr_t file = std::make_shared<stdx::_HttpStaticFile>();
+#ifdef WIN32
+	try
+	{
+		file->file = stdx::open_for_senfile(stdx::string::from_u8_string(path), FILE_GENERIC_READ, OPEN_EXISTING);
+	}
+	catch (const std::exception&)
+	{
+		_Erase(path);
+		return nullptr;
+	}
+#else
+	int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+	if (fd < 0)
+	{
+		_Erase(path);
+		return nullptr;
+	}
+	file->file = stdx::file_handle(fd);
+	//使用打开的文件的元数据,避免与路径检查之间被替换
+	if (::fstat(fd, &st) != 0 || !S_ISREG(st.st_mode))
+	{
+		_Erase(path);
+		return nullptr;
+	}
+	inode = (uint64_t)st.st_ino;
+#endif
+	file->size = (uint64_t)st.st_size;
+	file->mtime = (time_t)st.st_mtime;
+	file->inode = inode;
+	char buf[64];
+	::snprintf(buf, sizeof(buf), "\"%llx-%llx\"", (unsigned long long)file->mtime, (unsigned long long)file->size);
+	file->etag = buf;
+	file->last_modified.assign(buf, stdx::http_format_date(file->mtime, buf));
+	file->content_type = _ContentType(path);
+	lock.lock();
+	auto pos = m_cache.find(path);
+	if (pos != m_cache.end())
+	{
+		pos->second.file = file;
+		pos->second.check_tick = now;
+		m_lru.splice(m_lru.begin(), m_lru, pos->second.lru);
+		return file;
+	}
+	m_lru.push_front(path);
+	cache_entry entry;
+	entry.file = file;
+	entry.check_tick = now;
+	entry.lru = m_lru.begin();
+	m_cache.emplace(path, entry);
+	while (m_cache.size() > m_cache_size)
+	{
+		//淘汰最久没有使用的文件,正在发送的文件由发送操作持有
+		m_cache.erase(m_lru.back());
+		m_lru.pop_back();
+	}
+	return file;
+}
+
+void stdx::_HttpStaticFileHandler::_Erase(const std::string& path)
+{
+	std::unique_lock<lock_t> lock(m_lock);
+	auto it = m_cache.find(path);
+	if (it != m_cache.end())
+	{
+		m_lru.erase(it->second.lru);
+		m_cache.erase(it);
+	}
+}
+
+void stdx::_HttpStaticFileHandler::clear()
+{
+	std::unique_lock<lock_t> lock(m_lock);
+	m_cache.clear();
+	m_lru.clear();
+}
+
+const char* stdx::_HttpStaticFileHandler::_ContentType(const std::string& path)
+{
+	static const char* types[][2] =
+	{
+		{"html","text/html; charset=utf-8"},
+		{"htm","text/html; charset=utf-8"},
+		{"css","text/css; charset=utf-8"},
+		{"js","application/javascript; charset=utf-8"},
+		{"mjs","application/javascript; charset=utf-8"},
+		{"json","application/json"},
+		{"txt","text/plain; charset=utf-8"},
+		{"xml","application/xml"},
+		{"svg","image/svg+xml"},
+		{"png","image/png"},
+		{"jpg","image/jpeg"},
+		{"jpeg","image/jpeg"},
+		{"gif","image/gif"},
+		{"webp","image/webp"},
+		{"ico","image/x-icon"},
+		{"woff","font/woff"},
+		{"woff2","font/woff2"},
+		{"wasm","application/wasm"},
+		{"pdf","application/pdf"},
+		{"mp4","video/mp4"},
+		{"webm","video/webm"},
+		{"mp3","audio/mpeg"}
+	};
+	size_t dot = path.find_last_of("./");
+	if (dot == std::string::npos || path[dot] != '.')
+	{
+		return "application/octet-stream";
+	}
+	std::string ext = path.substr(dot + 1);
+	for (auto begin = ext.begin(), end = ext.end(); begin != end; ++begin)
+	{
+		*begin = (char)::tolower((unsigned char)*begin);
+	}
+	for (size_t i = 0; i < sizeof(types) / sizeof(types[0]); ++i)
+	{
+		if (ext == types[i][0])
+		{
+			return types[i][1];
+		}
+	}
+	return "application/octet-stream";
+}
+
+bool stdx::_HttpStaticFileHandler::_MatchEtag(const std::string& value, const std::string& etag)
+{
+	//If-None-Match使用弱比较
+	size_t begin = 0;
+	while (begin < value.size())
+	{
+		size_t end = value.find(',', begin);
+		if (end == std::string::npos)
+		{
+			end = value.size();
+		}
+		size_t first = value.find_first_not_of(" \t", begin);
+		size_t last = value.find_last_not_of(" \t", end - 1);
+		if (first != std::string::npos && first < end && last >= first)
+		{
+			std::string tag = value.substr(first, last - first + 1);
+			if (tag == "*")
+			{
+				return true;
+			}
+			if (tag.compare(0, 2, "W/") == 0)
+			{
+				tag.erase(0, 2);
+			}
+			if (tag == etag)
+			{
+				return true;
+			}
+		}
+		begin = end + 1;
+	}
+	return false;
+}
+
+int stdx::_HttpStaticFileHandler::_ParseRange(const std::string& value, uint64_t size, uint64_t& begin, uint64_t& end)
+{
+	if (value.size() < 6 || value.compare(0, 6, "bytes=") != 0 || value.find(',') != std::string::npos)
+	{
+		//不支持的单位或多个范围,返回完整文件
+		return 0;
+	}
+	size_t dash = value.find('-', 6);
+	if (dash == std::string::npos)
+	{
+		return 0;
+	}
+	uint64_t first = 0, last = 0;
+	bool has_first = false, has_last = false;
+	for (size_t i = 6; i < dash; ++i)
+	{
+		char ch = value[i];
+		if (ch < '0' || ch > '9' || first > (UINT64_MAX / 10 - 1))
+		{
+			return 0;
+		}
+		first = first * 10 + (uint64_t)(ch - '0');
+		has_first = true;
+	}
+	for (size_t i = dash + 1; i < value.size(); ++i)
+	{
+		char ch = value[i];
+		if (ch < '0' || ch > '9' || last > (UINT64_MAX / 10 - 1))
+		{
+			return 0;
+		}
+		last = last * 10 + (uint64_t)(ch - '0');
+		has_last = true;
+	}
+	if (!has_first)
+	{
+		//后缀范围:最后last字节
+		if (!has_last)
+		{
+			return 0;
+		}
+		if (last == 0 || size == 0)
+		{
+			return -1;
+		}
+		begin = (last >= size) ? 0 : size - last;
+		end = size - 1;
+		return 1;
+	}
+	if (has_last && last < first)
+	{
+		return 0;
+	}
+	if (first >= size)
+	{
+		return -1;
+	}
+	begin = first;
+	end = (!has_last || last >= size) ? size - 1 : last;
+	return 1;
+}
+
+stdx::task<void> stdx::_HttpStaticFileHandler::_Write(stdx::http_connection conn, const stdx::http_response& res)
+{
+	return conn.write(res).then([](stdx::task_result<size_t> r)
+	{
+		r.get();
+	});
+}
+
+stdx::task<void> stdx::_HttpStaticFileHandler::handle(stdx::http_connection conn, const stdx::http_request& req)
+{
+	const stdx::http_request_header& req_header = req.request_header();
+	stdx::http_method method = req_header.method();
+	bool keep = req_header.is_keepalive();
+	stdx::http_response res(200);
+	stdx::http_response_header& header = res.response_header();
+	if (!keep)
+	{
+		header.add_header(U("Connection"), U("close"));
+	}
+	else if (req_header.version() == stdx::http_version::http_1_0)
+	{
+		header.add_header(U("Connection"), U("keep-alive"));
+	}
+	if (method != stdx::http_method::get && method != stdx::http_method::head)
+	{
+		header.status_code() = 405;
+		header.add_header(U("Allow"), U("GET, HEAD"));
+		return _Write(conn, res);
+	}
+	std::string path;
+	file_ptr_t file;
+	if (_MapPath(req_header.request_url(), path))
+	{
+		file = _Open(path);
+	}
+	if (!file)
+	{
+		header.status_code() = 404;
+		header.add_header(U("Content-Type"), U("text/html"));
+		if (method == stdx::http_method::get)
+		{
+			res.response_body().push(U("<html><body><h1>Not Found</h1></body></html>"));
+		}
+		return _Write(conn, res);
+	}
+	header.add_header(U("ETag"), stdx::string::from_u8_string(file->etag));
+	header.add_header(U("Last-Modified"), stdx::string::from_u8_string(file->last_modified));
+	//If-None-Match优先于If-Modified-Since
+	std::string value;
+	bool not_modified = false;
+	if (req_header.raw_value("If-None-Match", value))
+	{
+		not_modified = _MatchEtag(value, file->etag);
+	}
+	else if (req_header.raw_value("If-Modified-Since", value))
+	{
+		time_t since = 0;
+		not_modified = stdx::http_parse_date(value, since) && file->mtime <= since;
+	}
+	if (not_modified)
+	{
+		header.status_code() = 304;
+		return _Write(conn, res);
+	}
+	header.add_header(U("Accept-Ranges"), U("bytes"));
+	header.add_header(U("Content-Type"), stdx::string::from_u8_string(file->content_type));
+	uint64_t begin = 0;
+	uint64_t length = file->size;
+	if (method == stdx::http_method::get && req_header.raw_value("Range", value))
+	{
+		//If-Range不匹配时返回完整文件
+		std::string if_range;
+		bool use_range = true;
+		if (req_header.raw_value("If-Range", if_range))
+		{
+			use_range = (if_range == file->etag) || (if_range == file->last_modified);
+		}
+		uint64_t end = 0;
+		int r = use_range ? _ParseRange(value, file->size, begin, end) : 0;
+		if (r < 0)
+		{
+			header.status_code() = 416;
+			header.add_header(U("Content-Range"), stdx::string::from_u8_string("bytes */" + std::to_string(file->size)));
+			return _Write(conn, res);
+		}
+		if (r > 0)
+		{
+			header.status_code() = 206;
+			length = end - begin + 1;
+			header.add_header(U("Content-Range"), stdx::string::from_u8_string("bytes " + std::to_string(begin) + "-" + std::to_string(end) + "/" + std::to_string(file->size)));
+		}
+	}
+	header.add_header(U("Content-Length"), stdx::string::from_u8_string(std::to_string(length)));
+	if (method == stdx::http_method::head || length == 0)
+	{
+		return _Write(conn, res);
+	}
+	//响应头作为send_file的前缀,与文件内容一起发送
+	stdx::output_buffer out(STDX_HTTP_OUTPUT_BLOCK_SIZE);
+	res.serialize_into(out);
+	std::vector<stdx::buffer_view> views = out.release();
+	stdx::buffer_view prefix = views.front();
+	if (views.size() != 1)
+	{
+		size_t size = 0;
+		for (auto it = views.begin(), end = views.end(); it != end; ++it)
+		{
+			size += it->size;
+		}
+		stdx::buffer buf = stdx::make_buffer(size);
+		size_t pos = 0;
+		for (auto it = views.begin(), end = views.end(); it != end; ++it)
+		{
+			memcpy((char*)buf + pos, it->data(), it->size);
+			pos += it->size;
+		}
+		prefix = stdx::buffer_view(buf, 0, pos);
+	}
+	return conn.write_file(file->file, begin, length, prefix);
+}
+
+stdx::http_static_file_handler stdx::make_http_static_file_handler(const stdx::string& root, size_t cache_size, uint64_t revalidate_ms)
+{
+	return stdx::http_static_file_handler(std::make_shared<stdx::_HttpStaticFileHandler>(root, cache_size, revalidate_ms));
+}
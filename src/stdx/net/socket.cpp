@@ -1,5 +1,11 @@
 ﻿#include <stdx/net/socket.h>
 #include <stdx/finally.h>
+#ifdef LINUX
+#include <linux/errqueue.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <poll.h>
+#endif
 
 #ifdef WIN32
 #include <Mstcpip.h>
@@ -21,6 +27,74 @@
 #endif
 
 #ifdef _STDX_HAS_SOCKET
+namespace stdx
+{
+	//network_io_context空闲链表,每个线程(事件循环)一个
+	struct _NetworkIOContextCache
+	{
+		_NetworkIOContextCache();
+
+		~_NetworkIOContextCache();
+
+		std::vector<void*> free_list;
+	};
+
+	//0:未初始化 1:可用 2:线程退出中已析构
+	static thread_local int _IOContextCacheState = 0;
+
+	static thread_local stdx::_NetworkIOContextCache _IOContextCache;
+}
+
+stdx::_NetworkIOContextCache::_NetworkIOContextCache()
+	:free_list()
+{
+	free_list.reserve(STDX_IO_CONTEXT_CACHE_SIZE);
+	_IOContextCacheState = 1;
+}
+
+stdx::_NetworkIOContextCache::~_NetworkIOContextCache()
+{
+	_IOContextCacheState = 2;
+	for (auto begin = free_list.begin(), end = free_list.end(); begin != end; ++begin)
+	{
+		::operator delete(*begin);
+	}
+	free_list.clear();
+}
+
+void* stdx::network_io_context::operator new(size_t size)
+{
+	if (size == sizeof(stdx::network_io_context) && _IOContextCacheState != 2)
+	{
+		std::vector<void*>& list = _IOContextCache.free_list;
+		if (!list.empty())
+		{
+			void* p = list.back();
+			list.pop_back();
+			return p;
+		}
+	}
+	return ::operator new(size);
+}
+
+void stdx::network_io_context::operator delete(void* ptr) noexcept
+{
+	if (ptr == nullptr)
+	{
+		return;
+	}
+	if (_IOContextCacheState != 2)
+	{
+		std::vector<void*>& list = _IOContextCache.free_list;
+		if (list.size() < STDX_IO_CONTEXT_CACHE_SIZE)
+		{
+			list.push_back(ptr);
+			return;
+		}
+	}
+	::operator delete(ptr);
+}
+
 int stdx::forward_protocol(const stdx::protocol& protocol)
 {
 	return static_cast<int>(protocol);
@@ -142,6 +216,17 @@ SOCKET stdx::_NetworkIOService::create_wsasocket(const int& addr_family, const i
 }
 #endif
 
+//scatter/gather缓冲区的总字节数
+static size_t _ViewsSize(const std::vector<stdx::buffer_view>& bufs)
+{
+	size_t size = 0;
+	for (auto begin = bufs.begin(), end = bufs.end(); begin != end; ++begin)
+	{
+		size += begin->size;
+	}
+	return size;
+}
+
 void stdx::_NetworkIOService::send(socket_t sock, stdx::buffer buf, const socket_size_t& size, std::function<void(network_send_event, std::exception_ptr)> callback)
 {
 #ifdef WIN32
@@ -155,22 +240,8 @@ void stdx::_NetworkIOService::send(socket_t sock, stdx::buffer buf, const socket
 	context_ptr->buf = buf;
 	context_ptr->buffer.buf = buf;
 	context_ptr->buffer.len = size;
-	std::function <void(network_io_context*, std::exception_ptr)> call  = [callback](network_io_context* context_ptr, std::exception_ptr error)
-	{
-		if (error)
-		{
-			delete context_ptr;
-			callback(network_send_event(), error);
-			return;
-		}
-		network_send_event context(context_ptr);
-		stdx::finally fin([context_ptr]()
-		{
-			delete context_ptr;
-		});
-		callback(context, nullptr);
-	};
-	context_ptr->callback = call;
+	context_ptr->send_callback = std::move(callback);
+	context_ptr->callback = &_CompleteSend;
 	prepare_callback(context_ptr);
 	if (WSASend(sock, &(context_ptr->buffer), 1, &(context_ptr->size), NULL, &(context_ptr->m_ol), NULL) == SOCKET_ERROR)
 	{
@@ -180,8 +251,7 @@ void stdx::_NetworkIOService::send(socket_t sock, stdx::buffer buf, const socket
 		}
 		catch (const std::exception&)
 		{
-			delete context_ptr;
-			callback(stdx::network_send_event(), std::current_exception());
+			_CompleteSend(context_ptr, std::current_exception());
 			return;
 		}
 	}
@@ -198,22 +268,74 @@ void stdx::_NetworkIOService::send(socket_t sock, stdx::buffer buf, const socket
 	context->code = stdx::network_io_context_code::send;
 	context->err_code = 0;
 	context->send_size = size;
-	auto call = [callback](network_io_context *context_ptr, std::exception_ptr error)
+	context->send_callback = std::move(callback);
+	context->callback = &_CompleteSend;
+	prepare_callback(context);
+	try
 	{
-		if (error)
+		stdx::threadpool.get_poller().post(context);
+	}
+	catch (const std::exception&)
+	{
+		_CompleteSend(context, std::current_exception());
+	}
+#endif
+}
+void stdx::_NetworkIOService::send(socket_t sock, std::vector<stdx::buffer_view> bufs, std::function<void(network_send_event, std::exception_ptr)> callback)
+{
+	if (_ViewsSize(bufs) == 0)
+	{
+		//零长度的操作直接完成,否则0字节的结果会被当作对端关闭
+		callback(stdx::network_send_event(), nullptr);
+		return;
+	}
+#ifdef WIN32
+	auto* context_ptr = new network_io_context;
+	if (context_ptr == nullptr)
+	{
+		callback(stdx::network_send_event(), std::make_exception_ptr(std::bad_alloc()));
+		return;
+	}
+	context_ptr->this_socket = sock;
+	context_ptr->bufs = std::move(bufs);
+	context_ptr->buffers.reserve(context_ptr->bufs.size());
+	for (auto begin = context_ptr->bufs.begin(), end = context_ptr->bufs.end(); begin != end; ++begin)
+	{
+		WSABUF wsabuf;
+		wsabuf.buf = begin->data();
+		wsabuf.len = static_cast<ULONG>(begin->size);
+		context_ptr->buffers.push_back(wsabuf);
+	}
+	context_ptr->send_callback = std::move(callback);
+	context_ptr->callback = &_CompleteSend;
+	prepare_callback(context_ptr);
+	if (WSASend(sock, context_ptr->buffers.data(), static_cast<DWORD>(context_ptr->buffers.size()), &(context_ptr->size), NULL, &(context_ptr->m_ol), NULL) == SOCKET_ERROR)
+	{
+		try
 		{
-			delete context_ptr;
-			callback(network_send_event(), error);
-			return;
+			_ThrowWSAError
 		}
-		network_send_event context(context_ptr);
-		stdx::finally fin([context_ptr]()
+		catch (const std::exception&)
 		{
-			delete context_ptr;
-		});
-		callback(context, nullptr);
-	};
-	context->callback = call;
+			_CompleteSend(context_ptr, std::current_exception());
+			return;
+		}
+	}
+#else
+	stdx::network_io_context* context = new stdx::network_io_context;
+	if (context == nullptr)
+	{
+		callback(stdx::network_send_event(), std::make_exception_ptr(std::bad_alloc()));
+		return;
+	}
+	context->bufs = std::move(bufs);
+	context->send_offset = 0;
+	context->send_size = _ViewsSize(context->bufs);
+	context->this_socket = sock;
+	context->code = stdx::network_io_context_code::sendv;
+	context->err_code = 0;
+	context->send_callback = std::move(callback);
+	context->callback = &_CompleteSend;
 	prepare_callback(context);
 	try
 	{
@@ -221,17 +343,29 @@ void stdx::_NetworkIOService::send(socket_t sock, stdx::buffer buf, const socket
 	}
 	catch (const std::exception&)
 	{
-		delete context;
-		callback(stdx::network_send_event(), std::current_exception());
+		_CompleteSend(context, std::current_exception());
 	}
 #endif
 }
+
 void stdx::_NetworkIOService::send_file(socket_t sock, file_handle_t file_with_cache, std::function<void(std::exception_ptr)> callback)
+{
+	send_file(sock, file_with_cache, 0, 0, stdx::buffer_view(), callback);
+}
+
+void stdx::_NetworkIOService::send_file(socket_t sock, file_handle_t file_with_cache, uint64_t offset, uint64_t length, stdx::buffer_view prefix, std::function<void(std::exception_ptr)> callback)
 {
 #ifdef WIN32
 	stdx::network_io_context* context_ptr = new network_io_context;
 	context_ptr->buffer.buf = NULL;
 	context_ptr->buffer.len = 0;
+	//保持前缀存活直到完成
+	context_ptr->bufs.push_back(prefix);
+	::memset(&context_ptr->transmit_buffers, 0, sizeof(TRANSMIT_FILE_BUFFERS));
+	context_ptr->transmit_buffers.Head = context_ptr->bufs.front().data();
+	context_ptr->transmit_buffers.HeadLength = (DWORD)prefix.size;
+	context_ptr->m_ol.Offset = (DWORD)(offset & 0xFFFFFFFF);
+	context_ptr->m_ol.OffsetHigh = (DWORD)(offset >> 32);
 	auto call =  [callback](network_io_context* context_ptr, std::exception_ptr error)
 	{
 		stdx::finally fin([context_ptr]()
@@ -242,7 +376,19 @@ void stdx::_NetworkIOService::send_file(socket_t sock, file_handle_t file_with_c
 	};
 	context_ptr->callback = call;
 	prepare_callback(context_ptr);
-	if (!(::TransmitFile(sock, file_with_cache, 0, 0, &context_ptr->m_ol, NULL, 0)))
+	//TransmitFile单次最多发送2^31-2字节,发送到文件末尾时可以传0
+	if (length > 2147483646)
+	{
+		LARGE_INTEGER file_size;
+		if (!::GetFileSizeEx(file_with_cache, &file_size) || offset + length != (uint64_t)file_size.QuadPart)
+		{
+			delete context_ptr;
+			callback(std::make_exception_ptr(std::length_error("length of send_file is larger than TransmitFile supports")));
+			return;
+		}
+		length = 0;
+	}
+	if (!(::TransmitFile(sock, file_with_cache, (DWORD)length, 0, &context_ptr->m_ol, prefix.size ? &context_ptr->transmit_buffers : NULL, 0)))
 	{
 		try
 		{
@@ -256,19 +402,86 @@ void stdx::_NetworkIOService::send_file(socket_t sock, file_handle_t file_with_c
 		}
 	}
 #else
+	struct stat st;
+	if (::fstat(file_with_cache, &st) < 0)
+	{
+		callback(std::make_exception_ptr(std::system_error(std::error_code(errno, std::system_category()))));
+		return;
+	}
+	bool is_pipe = S_ISFIFO(st.st_mode);
+	uint64_t remain = length;
+	if (!is_pipe)
+	{
+		uint64_t file_size = (uint64_t)st.st_size;
+		if (offset > file_size)
+		{
+			callback(std::make_exception_ptr(std::system_error(std::error_code(EINVAL, std::system_category()))));
+			return;
+		}
+		if (remain == 0 || remain > file_size - offset)
+		{
+			remain = file_size - offset;
+		}
+	}
+	else if (remain == 0)
+	{
+		//管道读到EOF为止
+		remain = UINT64_MAX;
+	}
+	int file_fd = file_with_cache;
+	if (is_pipe)
+	{
+		//空管道时要在事件循环中等待可读,注册dup出的fd,完成后关闭
+		file_fd = ::fcntl(file_with_cache, F_DUPFD_CLOEXEC, 0);
+		if (file_fd < 0)
+		{
+			callback(std::make_exception_ptr(std::system_error(std::error_code(errno, std::system_category()))));
+			return;
+		}
+		stdx::threadpool.get_poller().bind(file_fd);
+	}
 	stdx::network_io_context* context = new stdx::network_io_context;
 	if (context == nullptr)
 	{
+		if (is_pipe)
+		{
+			_ReleaseSendFilePipe(file_fd);
+		}
 		callback(std::make_exception_ptr(std::bad_alloc()));
 		return;
 	}
-	context->target_socket = file_with_cache;
+	context->target_socket = file_fd;
+	context->bufs.push_back(prefix);
 	context->send_offset = 0;
+	context->send_size = prefix.size;
+	context->file_offset = (off_t)offset;
+	context->file_remain = remain;
+	context->file_is_pipe = is_pipe;
 	context->this_socket = sock;
-	context->code = stdx::network_io_context_code::send;
+	context->code = stdx::network_io_context_code::sendfile;
 	context->err_code = 0;
 	auto call =  [callback](network_io_context* context_ptr, std::exception_ptr error)
 	{
+		bool wait_pipe = context_ptr->code == stdx::network_io_context_code::sendfile_wait;
+		if (!error && (wait_pipe || context_ptr->send_offset != context_ptr->send_size || context_ptr->file_remain != 0))
+		{
+			//本轮已发送STDX_SENDFILE_CHUNK字节,或管道为空需要等待可读,重新投递
+			context_ptr->events = _GetEvents(context_ptr);
+			context_ptr->key = wait_pipe ? context_ptr->target_socket : context_ptr->this_socket;
+			try
+			{
+				stdx::threadpool.get_poller().post(context_ptr);
+				return;
+			}
+			catch (const std::exception&)
+			{
+				error = std::current_exception();
+			}
+		}
+		if (context_ptr->file_is_pipe)
+		{
+			_ReleaseSendFilePipe(context_ptr->target_socket);
+		}
 		if (error)
 		{
 			delete context_ptr;
@@ -308,35 +521,8 @@ void stdx::_NetworkIOService::recv(socket_t sock,stdx::buffer buf, std::function
 	context_ptr->buf = buf;
 	context_ptr->buffer.buf = buf;
 	context_ptr->buffer.len = static_cast<ULONG>(buf.size());
-	auto call = [callback](network_io_context* context_ptr, std::exception_ptr error)
-	{
-		if (error)
-		{
-			delete context_ptr;
-			callback(network_recv_event(), error);
-			return;
-		}
-		if (context_ptr->size < 1)
-		{
-			try
-			{
-				throw std::system_error(std::error_code(WSAEDISCON, std::system_category()));
-			}
-			catch (const std::exception&)
-			{
-				delete context_ptr;
-				callback(network_recv_event(), std::current_exception());
-				return;
-			}
-		}
-		network_recv_event context(context_ptr);
-		stdx::finally fin([context_ptr]() 
-		{
-			delete context_ptr;
-		});
-		callback(context, std::exception_ptr(nullptr));
-	};
-	context_ptr->callback = call;
+	context_ptr->recv_callback = std::move(callback);
+	context_ptr->callback = &_CompleteRecv;
 	prepare_callback(context_ptr);
 	if (WSARecv(sock, &(context_ptr->buffer), 1, &(context_ptr->size), &(_NetworkIOService::recv_flag), &(context_ptr->m_ol), NULL) == SOCKET_ERROR)
 	{
@@ -346,8 +532,7 @@ void stdx::_NetworkIOService::recv(socket_t sock,stdx::buffer buf, std::function
 		}
 		catch (const std::exception&)
 		{
-			delete context_ptr;
-			callback(stdx::network_recv_event(), std::current_exception());
+			_CompleteRecv(context_ptr, std::current_exception());
 			return;
 		}
 	}
@@ -362,22 +547,76 @@ void stdx::_NetworkIOService::recv(socket_t sock,stdx::buffer buf, std::function
 	context->this_socket = sock;
 	context->size = buf.size();
 	context->buf = buf;
-	std::function<void(stdx::network_io_context*, std::exception_ptr)> call = [callback](stdx::network_io_context* context, std::exception_ptr err) mutable
+	context->recv_callback = std::move(callback);
+	context->callback = &_CompleteRecv;
+	prepare_callback(context);
+	try
 	{
-		if (err)
+		stdx::threadpool.get_poller().post(context);
+	}
+	catch (const std::exception&)
+	{
+		_CompleteRecv(context, std::current_exception());
+	}
+#endif
+}
+
+void stdx::_NetworkIOService::recv(socket_t sock, std::vector<stdx::buffer_view> bufs, std::function<void(network_recv_event, std::exception_ptr)> callback)
+{
+	if (_ViewsSize(bufs) == 0)
+	{
+		//零长度的操作直接完成,否则0字节的结果会被当作对端关闭
+		callback(stdx::network_recv_event(), nullptr);
+		return;
+	}
+#ifdef WIN32
+	auto* context_ptr = new network_io_context;
+	if (context_ptr == nullptr)
+	{
+		callback(stdx::network_recv_event(), std::make_exception_ptr(std::bad_alloc()));
+		return;
+	}
+	context_ptr->this_socket = sock;
+	context_ptr->bufs = std::move(bufs);
+	context_ptr->buffers.reserve(context_ptr->bufs.size());
+	for (auto begin = context_ptr->bufs.begin(), end = context_ptr->bufs.end(); begin != end; ++begin)
+	{
+		WSABUF wsabuf;
+		wsabuf.buf = begin->data();
+		wsabuf.len = static_cast<ULONG>(begin->size);
+		context_ptr->buffers.push_back(wsabuf);
+	}
+	context_ptr->recv_callback = std::move(callback);
+	context_ptr->callback = &_CompleteRecv;
+	prepare_callback(context_ptr);
+	if (WSARecv(sock, context_ptr->buffers.data(), static_cast<DWORD>(context_ptr->buffers.size()), &(context_ptr->size), &(_NetworkIOService::recv_flag), &(context_ptr->m_ol), NULL) == SOCKET_ERROR)
+	{
+		try
 		{
-			delete context;
-			callback(stdx::network_recv_event(), err);
+			_ThrowWSAError
+		}
+		catch (const std::exception&)
+		{
+			_CompleteRecv(context_ptr, std::current_exception());
 			return;
 		}
-		stdx::network_recv_event ev(context);
-		stdx::finally fin([context]()
-			{
-				delete context;
-			});
-		callback(ev, err);
-	};
-	context->callback = call;
+	}
+#else
+	stdx::network_io_context* context = new stdx::network_io_context;
+	if (context == nullptr)
+	{
+		callback(stdx::network_recv_event(), std::make_exception_ptr(std::bad_alloc()));
+		return;
+	}
+	context->code = stdx::network_io_context_code::recvv;
+	context->this_socket = sock;
+	context->bufs = std::move(bufs);
+	context->size = 0;
+	//recvv用send_offset/send_size记录已接收/总字节数
+	context->send_offset = 0;
+	context->send_size = _ViewsSize(context->bufs);
+	context->recv_callback = std::move(callback);
+	context->callback = &_CompleteRecv;
 	prepare_callback(context);
 	try
 	{
@@ -385,8 +624,7 @@ void stdx::_NetworkIOService::recv(socket_t sock,stdx::buffer buf, std::function
 	}
 	catch (const std::exception&)
 	{
-		delete context;
-		callback(stdx::network_recv_event(), std::current_exception());
+		_CompleteRecv(context, std::current_exception());
 	}
 #endif
 }
@@ -403,18 +641,20 @@ void stdx::_NetworkIOService::listen(socket_t sock, int backlog)
 	{
 		_ThrowLinuxError
 	}
+	//a stream socket reports EPOLLHUP until it listens,rebind to reset its state
+	stdx::threadpool.get_poller().bind(sock);
 #endif
 }
 
-void stdx::_NetworkIOService::bind(socket_t sock, ipv4_addr& addr)
+void stdx::_NetworkIOService::bind(socket_t sock, const socket_addr& addr)
 {
 #ifdef WIN32
-	if (::bind(sock, addr, ipv4_addr::addr_len) == SOCKET_ERROR)
+	if (::bind(sock, addr.data(), addr.length()) == SOCKET_ERROR)
 	{
 		_ThrowWSAError
 	}
 #else
-	if (::bind(sock, addr, ipv4_addr::addr_len) == -1)
+	if (::bind(sock, addr.data(), addr.length()) == -1)
 	{
 		_ThrowLinuxError
 	}
@@ -422,7 +662,7 @@ void stdx::_NetworkIOService::bind(socket_t sock, ipv4_addr& addr)
 }
 
 
-void stdx::_NetworkIOService::send_to(socket_t sock, const ipv4_addr& addr, stdx::buffer buf, const socket_size_t& size, std::function<void(stdx::network_send_event, std::exception_ptr)> callback)
+void stdx::_NetworkIOService::send_to(socket_t sock, const socket_addr& addr, stdx::buffer buf, const socket_size_t& size, std::function<void(stdx::network_send_event, std::exception_ptr)> callback)
 {
 #ifdef WIN32
 	stdx::network_io_context* context_ptr = new stdx::network_io_context;
@@ -436,24 +676,10 @@ void stdx::_NetworkIOService::send_to(socket_t sock, const ipv4_addr& addr, stdx
 	context_ptr->buf = buf;
 	context_ptr->buffer.buf = buf;
 	context_ptr->buffer.len = size;
-	auto call = [callback](network_io_context* context_ptr, std::exception_ptr error)
-	{
-		if (error)
-		{
-			delete context_ptr;
-			callback(network_send_event(), error);
-			return;
-		}
-		network_send_event context(context_ptr);
-		stdx::finally fin([context_ptr]()
-			{
-				delete context_ptr;
-			});
-		callback(context, nullptr);
-	};
-	context_ptr->callback = call;
+	context_ptr->send_callback = std::move(callback);
+	context_ptr->callback = &_CompleteSend;
 	prepare_callback(context_ptr);
-	if (WSASendTo(sock, &(context_ptr->buffer), 1, &(context_ptr->size), NULL, (context_ptr->addr), ipv4_addr::addr_len, &(context_ptr->m_ol), NULL) == SOCKET_ERROR)
+	if (WSASendTo(sock, &(context_ptr->buffer), 1, &(context_ptr->size), NULL, (context_ptr->addr), context_ptr->addr.length(), &(context_ptr->m_ol), NULL) == SOCKET_ERROR)
 	{
 		try
 		{
@@ -461,8 +687,7 @@ void stdx::_NetworkIOService::send_to(socket_t sock, const ipv4_addr& addr, stdx
 		}
 		catch (const std::exception&)
 		{
-			delete context_ptr;
-			callback(stdx::network_send_event(), std::current_exception());
+			_CompleteSend(context_ptr, std::current_exception());
 			return;
 		}
 	}
@@ -480,31 +705,16 @@ void stdx::_NetworkIOService::send_to(socket_t sock, const ipv4_addr& addr, stdx
 	context->code = stdx::network_io_context_code::sendto;
 	context->err_code = 0;
 	context->addr = addr;
-	auto call =  [callback](network_io_context* context_ptr, std::exception_ptr error)
-	{
-		if (error)
-		{
-			delete context_ptr;
-			callback(network_send_event(), error);
-			return;
-		}
-		network_send_event context(context_ptr);
-		stdx::finally fin([context_ptr]()
-			{
-				delete context_ptr;
-			});
-		callback(context, nullptr);
-	};
-	context->callback = call;
-	prepare_callback(context);
-	try
+	context->send_callback = std::move(callback);
+	context->callback = &_CompleteSend;
+	prepare_callback(context);
+	try
 	{
 		stdx::threadpool.get_poller().post(context);
 	}
 	catch (const std::exception&)
 	{
-		delete context;
-		callback(stdx::network_send_event(), std::current_exception());
+		_CompleteSend(context, std::current_exception());
 	}
 #endif
 
@@ -523,14 +733,14 @@ void stdx::_NetworkIOService::recv_from(socket_t sock, stdx::buffer buf, std::fu
 	context_ptr->buf = buf;
 	context_ptr->buffer.buf = buf;
 	context_ptr->buffer.len = static_cast<ULONG>(buf.size());
-	SOCKADDR_IN* addr = (SOCKADDR_IN*)stdx::malloc(sizeof(SOCKADDR_IN));
+	SOCKADDR_STORAGE* addr = (SOCKADDR_STORAGE*)stdx::malloc(sizeof(SOCKADDR_STORAGE));
 	if (addr == nullptr)
 	{
 		delete context_ptr;
 		callback(stdx::network_recv_event(), std::make_exception_ptr(std::bad_alloc()));
 		return;
 	}
-	memset(addr, 0, sizeof(SOCKADDR_IN));
+	memset(addr, 0, sizeof(SOCKADDR_STORAGE));
 	int* addr_size = (int*)stdx::malloc(sizeof(int));
 	if (addr_size == nullptr)
 	{
@@ -539,7 +749,7 @@ void stdx::_NetworkIOService::recv_from(socket_t sock, stdx::buffer buf, std::fu
 		callback(stdx::network_recv_event(), std::make_exception_ptr(std::bad_alloc()));
 		return;
 	}
-	*addr_size = sizeof(SOCKADDR_IN);
+	*addr_size = sizeof(SOCKADDR_STORAGE);
 	context_ptr->callback = [callback, addr, addr_size](network_io_context* context_ptr, std::exception_ptr error)
 	{
 		if (error)
@@ -574,7 +784,7 @@ void stdx::_NetworkIOService::recv_from(socket_t sock, stdx::buffer buf, std::fu
 			}
 			return;
 		}
-		context_ptr->addr = *addr;
+		context_ptr->addr = stdx::socket_addr((SOCKADDR*)addr, *addr_size);
 		stdx::free(addr);
 		stdx::free(addr_size);
 		network_recv_event context(context_ptr);
@@ -612,22 +822,8 @@ void stdx::_NetworkIOService::recv_from(socket_t sock, stdx::buffer buf, std::fu
 	context->this_socket = sock;
 	context->size = buf.size();
 	context->buf = buf;
-	std::function<void(stdx::network_io_context*, std::exception_ptr)> call =  [callback](stdx::network_io_context* context, std::exception_ptr err) mutable
-	{
-		if (err)
-		{
-			delete context;
-			callback(stdx::network_recv_event(), err);
-			return;
-		}
-		stdx::network_recv_event ev(context);
-		stdx::finally fin([context]()
-			{
-				delete context;
-			});
-		callback(ev, err);
-	};
-	context->callback = call;
+	context->recv_callback = std::move(callback);
+	context->callback = &_CompleteRecv;
 	prepare_callback(context);
 	try
 	{
@@ -635,8 +831,7 @@ void stdx::_NetworkIOService::recv_from(socket_t sock, stdx::buffer buf, std::fu
 	}
 	catch (const std::exception &err)
 	{
-		delete context;
-		callback(stdx::network_recv_event(), std::current_exception());
+		_CompleteRecv(context, std::current_exception());
 	}
 #endif
 
@@ -657,14 +852,10 @@ void stdx::_NetworkIOService::close(socket_t sock)
 #endif
 }
 
-stdx::ipv4_addr stdx::_NetworkIOService::get_local_addr(socket_t sock) const
+stdx::socket_addr stdx::_NetworkIOService::get_local_addr(socket_t sock) const
 {
-	ipv4_addr addr;
-#ifdef WIN32
-	int len = ipv4_addr::addr_len;
-#else
-	socklen_t len = ipv4_addr::addr_len;
-#endif
+	socket_addr addr;
+	socket_addr::length_t len = socket_addr::capacity;
 	if (getsockname(sock, addr, &len) == -1)
 	{
 #ifdef WIN32
@@ -673,33 +864,33 @@ stdx::ipv4_addr stdx::_NetworkIOService::get_local_addr(socket_t sock) const
 		_ThrowLinuxError
 #endif
 	}
+	addr.length(len);
 	return addr;
 }
 
-stdx::ipv4_addr stdx::_NetworkIOService::get_remote_addr(socket_t sock) const
+stdx::socket_addr stdx::_NetworkIOService::get_remote_addr(socket_t sock) const
 {
+	socket_addr addr;
+	socket_addr::length_t len = socket_addr::capacity;
 #ifdef WIN32
-	ipv4_addr addr;
-	int len = ipv4_addr::addr_len;
 	if (getpeername(sock, addr, &len) == SOCKET_ERROR)
 	{
 		_ThrowWSAError
 	}
-	return addr;
 #else
-	ipv4_addr addr;
-	socklen_t len = ipv4_addr::addr_len;
 	if (getpeername(sock, addr, &len) == -1)
 	{
 		_ThrowLinuxError
 	}
-	return addr;
 #endif
+	addr.length(len);
+	return addr;
 }
 
-void stdx::_NetworkIOService::accept_ex(socket_t sock, std::function<void(network_accept_event, std::exception_ptr)> callback)
+void stdx::_NetworkIOService::accept_ex(socket_t sock, std::function<void(network_accept_event, std::exception_ptr)> callback, bool same_loop)
 {
 #ifdef WIN32
+	NO_USED(same_loop);
 	try
 	{
 		_InitExFn(sock);
@@ -715,8 +906,9 @@ void stdx::_NetworkIOService::accept_ex(socket_t sock, std::function<void(networ
 		callback(stdx::network_accept_event(), std::make_exception_ptr(std::bad_alloc()));
 		return;
 	}
-	context->buffer.len = 128;
-	context->buffer.buf = (char*)stdx::calloc(128,sizeof(char));
+	//本地与远端地址各占sizeof(SOCKADDR_STORAGE)+16
+	context->buffer.len = 2 * (sizeof(SOCKADDR_STORAGE) + 16);
+	context->buffer.buf = (char*)stdx::calloc(context->buffer.len,sizeof(char));
 	if (context->buffer.buf == nullptr)
 	{
 		delete context;
@@ -733,13 +925,12 @@ void stdx::_NetworkIOService::accept_ex(socket_t sock, std::function<void(networ
 			callback(stdx::network_accept_event(), error);
 			return;
 		}
-		int local_len, remote_len;
-		stdx::ipv4_addr local, remote;
-		sockaddr* local_ptr = local, * remote_ptr = remote;
-		stdx::_NetworkIOService::m_get_addr_ex(context_ptr->buffer.buf, 0, stdx::ipv4_addr::addr_len + 16, stdx::ipv4_addr::addr_len + 16, &local_ptr, &local_len, &remote_ptr, &remote_len);
+		int local_len = 0, remote_len = 0;
+		sockaddr* local_ptr = nullptr, * remote_ptr = nullptr;
+		stdx::_NetworkIOService::m_get_addr_ex(context_ptr->buffer.buf, 0, sizeof(SOCKADDR_STORAGE) + 16, sizeof(SOCKADDR_STORAGE) + 16, &local_ptr, &local_len, &remote_ptr, &remote_len);
 		stdx::network_accept_event ev;
 		ev.accept = context_ptr->target_socket;
-		ev.addr = remote;
+		ev.addr = stdx::socket_addr(remote_ptr, remote_len);
 		stdx::free(context_ptr->buffer.buf);
 		stdx::finally fin([context_ptr]()
 			{
@@ -750,11 +941,12 @@ void stdx::_NetworkIOService::accept_ex(socket_t sock, std::function<void(networ
 	socket_t new_sock = INVALID_SOCKET;
 	try
 	{
-		new_sock = create_wsasocket(stdx::forward_addr_family(stdx::addr_family::ip), stdx::forward_socket_type(stdx::socket_type::stream), stdx::forward_protocol(stdx::protocol::ip));
+		//接受的socket与监听socket同一地址族
+		new_sock = create_wsasocket(get_local_addr(sock).family(), stdx::forward_socket_type(stdx::socket_type::stream), stdx::forward_protocol(stdx::protocol::ip));
 		context->target_socket = new_sock;
 		context->this_socket = sock;
 		prepare_callback(context);
-		BOOL r = m_accept_ex(sock, context->target_socket, context->buffer.buf, 0, sizeof(SOCKADDR_IN) + 16, sizeof(SOCKADDR_IN) + 16, &(context->buffer.len), &(context->m_ol));
+		BOOL r = m_accept_ex(sock, context->target_socket, context->buffer.buf, 0, sizeof(SOCKADDR_STORAGE) + 16, sizeof(SOCKADDR_STORAGE) + 16, &(context->buffer.len), &(context->m_ol));
 		if (r == FALSE)
 		{
 			_ThrowWSAError
@@ -779,21 +971,9 @@ void stdx::_NetworkIOService::accept_ex(socket_t sock, std::function<void(networ
 	}
 	context->code = stdx::network_io_context_code::accept;
 	context->this_socket = sock;
-	std::function<void(stdx::network_io_context*, std::exception_ptr)> call = [callback](stdx::network_io_context* context_ptr, std::exception_ptr err) mutable
-	{
-		if (err)
-		{
-			delete context_ptr;
-			callback(stdx::network_accept_event(), err);
-			return;
-		}
-		stdx::network_accept_event ev;
-		ev.accept = context_ptr->target_socket;
-		ev.addr = context_ptr->addr;
-		delete context_ptr;
-		callback(ev, err);
-	};
-	context->callback = call;
+	context->same_loop = same_loop;
+	context->accept_callback = std::move(callback);
+	context->callback = &_CompleteAccept;
 	prepare_callback(context);
 	try
 	{
@@ -801,13 +981,12 @@ void stdx::_NetworkIOService::accept_ex(socket_t sock, std::function<void(networ
 	}
 	catch (const std::exception&)
 	{
-		delete context;
-		callback(stdx::network_accept_event(), std::current_exception());
+		_CompleteAccept(context, std::current_exception());
 	}
 #endif
 }
 
-void stdx::_NetworkIOService::connect_ex(socket_t sock,stdx::ipv4_addr addr, std::function<void(std::exception_ptr)> callback)
+void stdx::_NetworkIOService::connect_ex(socket_t sock,stdx::socket_addr addr, std::function<void(std::exception_ptr)> callback)
 {
 #ifdef WIN32
 	try
@@ -825,18 +1004,12 @@ void stdx::_NetworkIOService::connect_ex(socket_t sock,stdx::ipv4_addr addr, std
 		callback(std::make_exception_ptr(std::bad_alloc()));
 		return;
 	}
-	context_ptr->callback = [callback](stdx::network_io_context* context, std::exception_ptr err)
-	{
-		stdx::finally fin([context]()
-			{
-				delete context;
-			});
-		callback(err);
-	};
+	context_ptr->done_callback = std::move(callback);
+	context_ptr->callback = &_CompleteDone;
 	prepare_callback(context_ptr);
 	try
 	{
-		BOOL r =  m_connect_ex(sock, addr, addr.addr_len, NULL, 0, NULL,&(context_ptr->m_ol));
+		BOOL r =  m_connect_ex(sock, addr, addr.length(), NULL, 0, NULL,&(context_ptr->m_ol));
 		if (r == FALSE)
 		{
 			_ThrowWSAError
@@ -844,14 +1017,14 @@ void stdx::_NetworkIOService::connect_ex(socket_t sock,stdx::ipv4_addr addr, std
 	}
 	catch (const std::exception &)
 	{
-		delete context_ptr;
-		callback(std::current_exception());
+		_CompleteDone(context_ptr, std::current_exception());
 	}
 #else
 	
-	int r = ::connect(sock, addr, addr.addr_len);
+	int r = ::connect(sock, addr, addr.length());
 	if (r == 0)
 	{
+		stdx::threadpool.get_poller().bind(sock);
 		callback(nullptr);
 		return;
 	}
@@ -867,6 +1040,7 @@ void stdx::_NetworkIOService::connect_ex(socket_t sock,stdx::ipv4_addr addr, std
 		}
 		return;
 	}
+	stdx::threadpool.get_poller().bind(sock);
 	network_io_context* context_ptr = new network_io_context;
 	if (context_ptr == nullptr)
 	{
@@ -875,14 +1049,8 @@ void stdx::_NetworkIOService::connect_ex(socket_t sock,stdx::ipv4_addr addr, std
 	}
 	context_ptr->code = stdx::network_io_context_code::connect;
 	context_ptr->this_socket = sock;
-	context_ptr->callback = [callback](stdx::network_io_context* context, std::exception_ptr err)
-	{
-		stdx::finally fin([context]()
-			{
-				delete context;
-			});
-		callback(err);
-	};
+	context_ptr->done_callback = std::move(callback);
+	context_ptr->callback = &_CompleteDone;
 	prepare_callback(context_ptr);
 	try
 	{
@@ -890,8 +1058,7 @@ void stdx::_NetworkIOService::connect_ex(socket_t sock,stdx::ipv4_addr addr, std
 	}
 	catch (const std::exception&)
 	{
-		delete context_ptr;
-		callback(std::current_exception());
+		_CompleteDone(context_ptr, std::current_exception());
 	}
 #endif
 }
@@ -918,6 +1085,100 @@ void stdx::_NetworkIOService::set_keepalive(socket_t sock, bool opt)
 #endif
 }
 
+void stdx::_NetworkIOService::set_v6only(socket_t sock, bool opt)
+{
+#ifdef WIN32
+	DWORD val = opt ? 1 : 0;
+	if (::setsockopt(sock, IPPROTO_IPV6, IPV6_V6ONLY, (const char*)&val, sizeof(val)) == SOCKET_ERROR)
+	{
+		_ThrowWSAError
+	}
+#else
+	int val = opt ? 1 : 0;
+	if (::setsockopt(sock, IPPROTO_IPV6, IPV6_V6ONLY, &val, sizeof(val)) < 0)
+	{
+		_ThrowLinuxError
+	}
+#endif
+}
+
+bool stdx::_NetworkIOService::is_idle_alive(socket_t sock) const
+{
+	//空闲连接可读意味着对端关闭、出错或发来了多余的数据,都不能复用
+#ifdef WIN32
+	fd_set read_set;
+	FD_ZERO(&read_set);
+	FD_SET(sock, &read_set);
+	timeval timeout;
+	timeout.tv_sec = 0;
+	timeout.tv_usec = 0;
+	int r = ::select(0, &read_set, NULL, NULL, &timeout);
+	return r == 0;
+#else
+	char ch;
+	ssize_t r = ::recv(sock, &ch, 1, MSG_PEEK | MSG_DONTWAIT);
+	return r < 0 && (errno == EAGAIN || errno == EWOULDBLOCK);
+#endif
+}
+
+void stdx::_NetworkIOService::_CompleteSend(stdx::network_io_context* context_ptr, std::exception_ptr error)
+{
+	std::function<void(network_send_event, std::exception_ptr)> callback = std::move(context_ptr->send_callback);
+	if (error)
+	{
+		delete context_ptr;
+		callback(stdx::network_send_event(), error);
+		return;
+	}
+	stdx::network_send_event ev(context_ptr);
+	//先归还context,回调中发起的下一次IO可以复用
+	delete context_ptr;
+	callback(ev, nullptr);
+}
+
+void stdx::_NetworkIOService::_CompleteRecv(stdx::network_io_context* context_ptr, std::exception_ptr error)
+{
+	std::function<void(network_recv_event, std::exception_ptr)> callback = std::move(context_ptr->recv_callback);
+#ifdef WIN32
+	if (!error && context_ptr->size < 1)
+	{
+		error = std::make_exception_ptr(std::system_error(std::error_code(WSAEDISCON, std::system_category())));
+	}
+#endif
+	if (error)
+	{
+		delete context_ptr;
+		callback(stdx::network_recv_event(), error);
+		return;
+	}
+	stdx::network_recv_event ev(context_ptr);
+	delete context_ptr;
+	callback(ev, nullptr);
+}
+
+void stdx::_NetworkIOService::_CompleteAccept(stdx::network_io_context* context_ptr, std::exception_ptr error)
+{
+	std::function<void(network_accept_event, std::exception_ptr)> callback = std::move(context_ptr->accept_callback);
+	if (error)
+	{
+		delete context_ptr;
+		callback(stdx::network_accept_event(), error);
+		return;
+	}
+	stdx::network_accept_event ev;
+	ev.accept = context_ptr->target_socket;
+	ev.addr = context_ptr->addr;
+	delete context_ptr;
+	callback(ev, nullptr);
+}
+
+void stdx::_NetworkIOService::_CompleteDone(stdx::network_io_context* context_ptr, std::exception_ptr error)
+{
+	std::function<void(std::exception_ptr)> callback = std::move(context_ptr->done_callback);
+	delete context_ptr;
+	callback(error);
+}
+
 void stdx::_NetworkIOService::prepare_callback(stdx::network_io_context* context)
 {
 #ifdef WIN32
@@ -969,7 +1230,34 @@ void stdx::_NetworkIOService::prepare_callback(stdx::network_io_context* context
 		{
 			return true;
 		}
-		return _IOOperate(context);
+		if (context->sock_err != 0)
+		{
+			//poller已取走的套接字错误(如ICMP不可达)
+			context->err_code = context->sock_err;
+			context->sock_err = 0;
+			context->is_persistent = false;
+			context->size = 0;
+			return true;
+		}
+		if (!context->is_persistent)
+		{
+			return _IOOperate(context);
+		}
+		if (context->cancel && context->cancel->is_cancel())
+		{
+			//已取消的持久注册不再读取,数据留给之后的recv
+			context->is_persistent = false;
+			context->err_code = 0;
+			context->size = 0;
+			return true;
+		}
+		bool r = _IOOperate(context);
+		if (r && context->err_code != 0)
+		{
+			//出错或对端关闭,结束持久注册
+			context->is_persistent = false;
+		}
+		return r;
 	};
 	context->execute = [](stdx::stand_context *cont) 
 	{
@@ -991,7 +1279,31 @@ void stdx::_NetworkIOService::prepare_callback(stdx::network_io_context* context
 		}
 		else if (context->code == stdx::network_io_context_code::accept || context->code == stdx::network_io_context_code::accept_ipv6)
 		{
-			stdx::threadpool.get_poller().bind(context->target_socket);
+			auto poller = stdx::threadpool.get_poller();
+			if (context->same_loop)
+			{
+				poller.bind_at(context->target_socket, poller.index_of(context->this_socket));
+			}
+			else
+			{
+				poller.bind(context->target_socket);
+			}
+		}
+		else if (context->code == stdx::network_io_context_code::accept_batch)
+		{
+			auto poller = stdx::threadpool.get_poller();
+			size_t index = context->same_loop ? poller.index_of(context->this_socket) : 0;
+			for (auto begin = context->accepted.begin(), end = context->accepted.end(); begin != end; ++begin)
+			{
+				if (context->same_loop)
+				{
+					poller.bind_at(*begin, index);
+				}
+				else
+				{
+					poller.bind(*begin);
+				}
+			}
 		}
 		try
 		{
@@ -1010,148 +1322,933 @@ void stdx::_NetworkIOService::prepare_callback(stdx::network_io_context* context
 
 #ifdef LINUX
 
-void stdx::_NetworkIOService::_SetNonBlocking(socket_t sock)
+void stdx::_NetworkIOService::set_reuse_port(socket_t sock, bool opt)
 {
-	int flags = fcntl(sock, F_GETFL, 0);
-	flags |= SOCK_NONBLOCK;
-	fcntl(sock, F_SETFL, flags);
+	int val = opt ? 1 : 0;
+	if (::setsockopt(sock, SOL_SOCKET, SO_REUSEPORT, &val, sizeof(val)) < 0)
+	{
+		_ThrowLinuxError
+	}
 }
 
-void stdx::_NetworkIOService::_SetReuseAddr(socket_t sock)
+void stdx::_NetworkIOService::bind_loop(socket_t sock, size_t index)
 {
-	int opt = 1;
-	::setsockopt(sock, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+	auto poller = stdx::threadpool.get_poller();
+	poller.bind_at(sock, index % poller.size());
 }
 
-bool stdx::_NetworkIOService::_IOOperate(stdx::network_io_context* context)
+void stdx::_NetworkIOService::set_busy_poll(socket_t sock, uint32_t us)
 {
-	ssize_t r = 0;
-	if (context->code == stdx::network_io_context_code::recv)
+	int val = stdx::implicit_cast<int>(us);
+	if (::setsockopt(sock, SOL_SOCKET, SO_BUSY_POLL, &val, sizeof(val)) < 0)
 	{
-		r = ::recv(context->this_socket,(char *)context->buf, context->size, MSG_NOSIGNAL | MSG_DONTWAIT);
+		_ThrowLinuxError
 	}
-	else if (context->code == stdx::network_io_context_code::recvfrom)
-	{
-		sockaddr_in addr;
-		socklen_t addr_size = sizeof(sockaddr_in);
-		r = ::recvfrom(context->this_socket, (char *)context->buf, context->size, MSG_NOSIGNAL | MSG_DONTWAIT, (sockaddr*)&addr, &addr_size);
-		context->addr = stdx::ipv4_addr(addr);
 }
-	else if (context->code == stdx::network_io_context_code::accept)
-	{
-		sockaddr_in addr;
-		socklen_t addr_size = sizeof(sockaddr_in);
-		context->target_socket = ::accept4(context->this_socket, (sockaddr*)&addr, &addr_size,SOCK_NONBLOCK|SOCK_CLOEXEC);
-		if (errno == EAGAIN || errno == EWOULDBLOCK)
-		{
-			return false;
-		}
-		//else if(errno == EMFILE)
-		//{
-		//	//Too may files open
-		//	::close(stdx::_NetworkIOService::m_null_fd);
-		//	stdx::_NetworkIOService::m_null_fd = ::accept4(context->this_socket, (sockaddr*)&addr, &addr_size, SOCK_NONBLOCK | SOCK_CLOEXEC);
-		//	::close(stdx::_NetworkIOService::m_null_fd);
-		//	stdx::_NetworkIOService::m_null_fd = stdx::_NetworkIOService::open_null_fd();
-		//	context->target_socket = -1;
-		//	r = -1;
-		//}
-		else
-		{
-			if (context->target_socket != -1)
-			{
-				context->addr = stdx::ipv4_addr(addr);
-				_SetNonBlocking(context->target_socket);
-				r = 1;
-			}
-			else
-			{
-				r = -1;
-			}
-		}
-	}
-	else if (context->code == stdx::network_io_context_code::send)
-	{
-		char* buf = context->buf;
-		buf += context->send_offset;
-		size_t buf_size = context->send_size;
-		buf_size -= context->send_offset;
-		r = ::send(context->this_socket, buf, buf_size, MSG_NOSIGNAL | MSG_DONTWAIT);
-		if (r != context->send_size && r > 0)
-		{
-			context->send_offset += r;
-			if (context->send_offset != context->send_size)
-			{
-				return false;
-			}
-		}
-	}
-	else if (context->code == stdx::network_io_context_code::sendto)
+
+void stdx::_NetworkIOService::recv_from_batch(socket_t sock, std::vector<stdx::buffer> bufs, std::function<void(std::vector<stdx::network_recv_event>, std::exception_ptr)> callback)
+{
+	if (bufs.empty())
 	{
-		char* buf = context->buf;
-		buf += context->send_offset;
-		size_t buf_size = context->send_size;
-		buf_size -= context->send_offset;
-		r = ::sendto(context->this_socket,buf,buf_size, MSG_NOSIGNAL | MSG_DONTWAIT,(sockaddr*)context->addr,stdx::ipv4_addr::addr_len);
-		if (r != context->send_size && r > 0)
-		{
-			context->send_offset += r;
-			if (context->send_offset != context->send_size)
-			{
-				return false;
-			}
-		}
+		//recvmmsg的数量为0时返回0,无法完成
+		callback(std::vector<stdx::network_recv_event>(), nullptr);
+		return;
 	}
-	else if (context->code == stdx::network_io_context_code::sendfile)
+	stdx::network_io_context* context = new stdx::network_io_context;
+	if (context == nullptr)
 	{
-		off_t off = context->send_offset;
-		r = ::sendfile(context->this_socket, context->target_socket, &off, context->send_size);
-		context->send_offset = off;
+		callback(std::vector<stdx::network_recv_event>(), std::make_exception_ptr(std::bad_alloc()));
+		return;
 	}
-	else if (context->code == stdx::network_io_context_code::connect)
+	context->code = stdx::network_io_context_code::recvfrom_batch;
+	context->this_socket = sock;
+	context->size = 0;
+	context->bufs.reserve(bufs.size());
+	for (auto begin = bufs.begin(), end = bufs.end(); begin != end; ++begin)
 	{
-		r = 1;
+		context->bufs.push_back(stdx::buffer_view(*begin));
 	}
-	if (r < 0)
+	context->addrs.resize(bufs.size());
+	std::function<void(stdx::network_io_context*, std::exception_ptr)> call = [callback](stdx::network_io_context* context, std::exception_ptr err) mutable
 	{
-		if (errno == EWOULDBLOCK || errno == EAGAIN)
+		if (err)
 		{
-			return false;
+			delete context;
+			callback(std::vector<stdx::network_recv_event>(), err);
+			return;
 		}
-		context->err_code = errno;
-	}
-	else if(r == 0)
+		std::vector<stdx::network_recv_event> evs;
+		evs.reserve(context->size);
+		for (size_t i = 0; i < context->size; ++i)
+		{
+			stdx::network_recv_event ev;
+			ev.buffer = context->bufs[i].buffer;
+			ev.size = context->bufs[i].size;
+			ev.addr = context->addrs[i];
+			evs.push_back(std::move(ev));
+		}
+		delete context;
+		callback(std::move(evs), err);
+	};
+	context->callback = call;
+	prepare_callback(context);
+	try
 	{
-		context->err_code = ECONNRESET;
+		stdx::threadpool.get_poller().post(context);
 	}
-	else
+	catch (const std::exception&)
 	{
-		context->err_code = 0;
+		delete context;
+		callback(std::vector<stdx::network_recv_event>(), std::current_exception());
 	}
-	context->size = (size_t)r;
-	return true;
 }
 
-uint32_t stdx::_NetworkIOService::_GetEvents(stdx::network_io_context* context)
+void stdx::_NetworkIOService::send_to_batch(socket_t sock, std::vector<stdx::network_datagram> datagrams, std::function<void(size_t, std::exception_ptr)> callback)
 {
-	constexpr uint32_t check_in = stdx::network_io_context_code::accept | 
-		stdx::network_io_context_code::accept_ipv6 | 
-		stdx::network_io_context_code::recv | 
-		stdx::network_io_context_code::recvfrom | 
-		stdx::network_io_context_code::recvfrom_ipv6;
-	if (context->code & check_in)
+	if (datagrams.empty())
 	{
-		return stdx::epoll_events::in;
+		callback(0, nullptr);
+		return;
 	}
-	constexpr uint32_t check_out = stdx::network_io_context_code::send |
-		stdx::network_io_context_code::sendfile |
-		stdx::network_io_context_code::sendto |
-		stdx::network_io_context_code::sendto_ipv6 |
+	stdx::network_io_context* context = new stdx::network_io_context;
+	if (context == nullptr)
+	{
+		callback(0, std::make_exception_ptr(std::bad_alloc()));
+		return;
+	}
+	context->code = stdx::network_io_context_code::sendto_batch;
+	context->this_socket = sock;
+	context->err_code = 0;
+	context->send_offset = 0;
+	context->send_size = datagrams.size();
+	context->bufs.reserve(datagrams.size());
+	context->addrs.reserve(datagrams.size());
+	for (auto begin = datagrams.begin(), end = datagrams.end(); begin != end; ++begin)
+	{
+		context->bufs.push_back(stdx::buffer_view(begin->buffer, 0, begin->size));
+		context->addrs.push_back(begin->addr);
+	}
+	auto call = [callback](network_io_context* context_ptr, std::exception_ptr error)
+	{
+		size_t n = context_ptr->send_offset;
+		delete context_ptr;
+		callback(n, error);
+	};
+	context->callback = call;
+	prepare_callback(context);
+	try
+	{
+		stdx::threadpool.get_poller().post(context);
+	}
+	catch (const std::exception&)
+	{
+		delete context;
+		callback(0, std::current_exception());
+	}
+}
+
+void stdx::_NetworkIOService::recv_until(socket_t sock, stdx::buffer buf, stdx::cancel_token token, std::function<void(network_recv_event, std::exception_ptr)> callback)
+{
+	if (token.is_cancel())
+	{
+		return;
+	}
+	stdx::network_io_context* context = new stdx::network_io_context;
+	if (context == nullptr)
+	{
+		callback(stdx::network_recv_event(), std::make_exception_ptr(std::bad_alloc()));
+		return;
+	}
+	context->code = stdx::network_io_context_code::recv;
+	context->this_socket = sock;
+	context->size = buf.size();
+	context->buf = buf;
+	context->err_code = 0;
+	context->is_persistent = true;
+	context->cancel = std::make_shared<stdx::cancel_token>(token);
+	//每块数据在事件循环内回调,注册结束时(出错/取消/关闭)再回调一次并释放
+	std::function<void(stdx::network_io_context*, std::exception_ptr)> call = [callback, token](stdx::network_io_context* context, std::exception_ptr err) mutable
+	{
+		if (context->is_persistent)
+		{
+			//读取之后才被取消时数据仍然交给回调,不能丢弃
+			stdx::network_recv_event ev(context);
+			std::exception_ptr error(nullptr);
+			try
+			{
+				callback(ev, nullptr);
+			}
+			catch (const std::exception&)
+			{
+				error = std::current_exception();
+			}
+			if (error)
+			{
+				//回调的异常走错误回调,注册继续
+				try
+				{
+					callback(stdx::network_recv_event(), error);
+				}
+				catch (const std::exception& ex)
+				{
+					DBG_VAR(ex);
+#ifdef DEBUG
+					::printf("[NetworkIOService]Callback error: %s\n", ex.what());
+#endif
+				}
+			}
+			if (token.is_cancel())
+			{
+				context->is_persistent = false;
+			}
+			return;
+		}
+		delete context;
+		if (err && !token.is_cancel())
+		{
+			callback(stdx::network_recv_event(), err);
+		}
+	};
+	context->callback = call;
+	prepare_callback(context);
+	try
+	{
+		stdx::threadpool.get_poller().post(context);
+	}
+	catch (const std::exception&)
+	{
+		delete context;
+		callback(stdx::network_recv_event(), std::current_exception());
+	}
+}
+
+stdx::network_io_context* stdx::_NetworkIOService::_MakeAcceptBatch(socket_t sock, size_t budget, bool same_loop)
+{
+	stdx::network_io_context* context = new stdx::network_io_context;
+	if (context == nullptr)
+	{
+		return nullptr;
+	}
+	context->code = stdx::network_io_context_code::accept_batch;
+	context->this_socket = sock;
+	context->same_loop = same_loop;
+	context->err_code = 0;
+	context->send_size = budget ? budget : 1;
+	context->accepted.reserve(context->send_size);
+	context->addrs.reserve(context->send_size);
+	return context;
+}
+
+static std::vector<stdx::network_accept_event> _TakeAccepted(stdx::network_io_context* context)
+{
+	std::vector<stdx::network_accept_event> evs;
+	evs.reserve(context->accepted.size());
+	for (size_t i = 0; i < context->accepted.size(); ++i)
+	{
+		stdx::network_accept_event ev;
+		ev.accept = context->accepted[i];
+		ev.addr = context->addrs[i];
+		evs.push_back(ev);
+	}
+	context->accepted.clear();
+	context->addrs.clear();
+	return evs;
+}
+
+void stdx::_NetworkIOService::accept_batch(socket_t sock, size_t budget, std::function<void(std::vector<network_accept_event>, std::exception_ptr)> callback, bool same_loop)
+{
+	stdx::network_io_context* context = _MakeAcceptBatch(sock, budget, same_loop);
+	if (context == nullptr)
+	{
+		callback(std::vector<stdx::network_accept_event>(), std::make_exception_ptr(std::bad_alloc()));
+		return;
+	}
+	std::function<void(stdx::network_io_context*, std::exception_ptr)> call = [callback](stdx::network_io_context* context_ptr, std::exception_ptr err) mutable
+	{
+		if (err)
+		{
+			delete context_ptr;
+			callback(std::vector<stdx::network_accept_event>(), err);
+			return;
+		}
+		std::vector<stdx::network_accept_event> evs = _TakeAccepted(context_ptr);
+		delete context_ptr;
+		callback(std::move(evs), err);
+	};
+	context->callback = call;
+	prepare_callback(context);
+	try
+	{
+		stdx::threadpool.get_poller().post(context);
+	}
+	catch (const std::exception&)
+	{
+		delete context;
+		callback(std::vector<stdx::network_accept_event>(), std::current_exception());
+	}
+}
+
+void stdx::_NetworkIOService::accept_until(socket_t sock, size_t budget, stdx::cancel_token token, std::function<void(std::vector<network_accept_event>, std::exception_ptr)> callback, bool same_loop)
+{
+	if (token.is_cancel())
+	{
+		return;
+	}
+	stdx::network_io_context* context = _MakeAcceptBatch(sock, budget, same_loop);
+	if (context == nullptr)
+	{
+		callback(std::vector<stdx::network_accept_event>(), std::make_exception_ptr(std::bad_alloc()));
+		return;
+	}
+	context->is_persistent = true;
+	std::function<void(stdx::network_io_context*, std::exception_ptr)> call = [callback, token](stdx::network_io_context* context_ptr, std::exception_ptr err) mutable
+	{
+		if (context_ptr->is_persistent)
+		{
+			std::vector<stdx::network_accept_event> evs = _TakeAccepted(context_ptr);
+			try
+			{
+				callback(std::move(evs), nullptr);
+			}
+			catch (const std::exception& ex)
+			{
+				DBG_VAR(ex);
+#ifdef DEBUG
+				::printf("[NetworkIOService]Callback error: %s\n", ex.what());
+#endif
+			}
+			if (token.is_cancel())
+			{
+				context_ptr->is_persistent = false;
+			}
+			return;
+		}
+		std::vector<stdx::network_accept_event> evs = _TakeAccepted(context_ptr);
+		delete context_ptr;
+		if (!evs.empty())
+		{
+			callback(std::move(evs), nullptr);
+		}
+		if (err)
+		{
+			callback(std::vector<stdx::network_accept_event>(), err);
+		}
+	};
+	context->callback = call;
+	prepare_callback(context);
+	try
+	{
+		stdx::threadpool.get_poller().post(context);
+	}
+	catch (const std::exception&)
+	{
+		delete context;
+		callback(std::vector<stdx::network_accept_event>(), std::current_exception());
+	}
+}
+
+void stdx::_NetworkIOService::set_zerocopy(socket_t sock, bool opt)
+{
+	int val = opt ? 1 : 0;
+	if (::setsockopt(sock, SOL_SOCKET, SO_ZEROCOPY, &val, sizeof(val)) < 0)
+	{
+		_ThrowLinuxError
+	}
+}
+
+void stdx::_NetworkIOService::send_zerocopy(socket_t sock, std::shared_ptr<stdx::zerocopy_state> state, stdx::buffer buf, const stdx::socket_size_t& size, std::function<void(network_send_event, std::exception_ptr)> callback)
+{
+	stdx::network_io_context* context = new stdx::network_io_context;
+	if (context == nullptr)
+	{
+		callback(stdx::network_send_event(), std::make_exception_ptr(std::bad_alloc()));
+		return;
+	}
+	context->buf = buf;
+	context->send_offset = 0;
+	context->send_size = size;
+	context->this_socket = sock;
+	context->code = stdx::network_io_context_code::send_zerocopy;
+	context->err_code = 0;
+	context->zerocopy = state;
+	context->zc_begin = 0;
+	context->zc_end = 0;
+	context->zc_err = 0;
+	auto call = [callback](network_io_context* context_ptr, std::exception_ptr error)
+	{
+		if (context_ptr->code == stdx::network_io_context_code::send_zerocopy && context_ptr->zc_begin != context_ptr->zc_end)
+		{
+			//发送阶段结束,等待内核释放buffer后再回调
+			context_ptr->zc_err = context_ptr->err_code;
+			context_ptr->err_code = 0;
+			context_ptr->code = stdx::network_io_context_code::zerocopy_wait;
+			context_ptr->events = _GetEvents(context_ptr);
+			try
+			{
+				stdx::threadpool.get_poller().post(context_ptr);
+				return;
+			}
+			catch (const std::exception&)
+			{
+				error = std::current_exception();
+			}
+		}
+		if (error)
+		{
+			delete context_ptr;
+			callback(network_send_event(), error);
+			return;
+		}
+		network_send_event context(context_ptr);
+		stdx::finally fin([context_ptr]()
+		{
+			delete context_ptr;
+		});
+		callback(context, nullptr);
+	};
+	context->callback = call;
+	prepare_callback(context);
+	try
+	{
+		stdx::threadpool.get_poller().post(context);
+	}
+	catch (const std::exception&)
+	{
+		delete context;
+		callback(stdx::network_send_event(), std::current_exception());
+	}
+}
+
+static void _MarkZerocopy(stdx::zerocopy_state& state, uint32_t lo, uint32_t hi)
+{
+	if (lo != state.done)
+	{
+		state.pending.push_back(std::make_pair(lo, hi));
+		return;
+	}
+	state.done = hi + 1;
+	bool merged = true;
+	while (merged)
+	{
+		merged = false;
+		for (auto begin = state.pending.begin(), end = state.pending.end(); begin != end; ++begin)
+		{
+			if (begin->first == state.done)
+			{
+				state.done = begin->second + 1;
+				state.pending.erase(begin);
+				merged = true;
+				break;
+			}
+		}
+	}
+}
+
+bool stdx::_NetworkIOService::_ReapZerocopy(stdx::network_io_context* context)
+{
+	stdx::zerocopy_state& state = *(context->zerocopy);
+	char control[128];
+	while (true)
+	{
+		msghdr msg;
+		memset(&msg, 0, sizeof(msghdr));
+		msg.msg_control = control;
+		msg.msg_controllen = sizeof(control);
+		if (::recvmsg(context->this_socket, &msg, MSG_ERRQUEUE | MSG_DONTWAIT) == -1)
+		{
+			break;
+		}
+		for (cmsghdr* cm = CMSG_FIRSTHDR(&msg); cm != nullptr; cm = CMSG_NXTHDR(&msg, cm))
+		{
+			bool is_recverr = (cm->cmsg_level == SOL_IP && cm->cmsg_type == IP_RECVERR) || (cm->cmsg_level == SOL_IPV6 && cm->cmsg_type == IPV6_RECVERR);
+			if (!is_recverr)
+			{
+				continue;
+			}
+			sock_extended_err* err = (sock_extended_err*)CMSG_DATA(cm);
+			if (err->ee_errno != 0 || err->ee_origin != SO_EE_ORIGIN_ZEROCOPY)
+			{
+				continue;
+			}
+			//[ee_info,ee_data]区间的发送已完成(ee_code为SO_EE_CODE_ZEROCOPY_COPIED时内核做了复制)
+			_MarkZerocopy(state, err->ee_info, err->ee_data);
+		}
+	}
+	return (int32_t)(state.done - context->zc_end) >= 0;
+}
+
+void stdx::_NetworkIOService::_ReleaseSendFilePipe(int fd)
+{
+	stdx::threadpool.get_poller().unbind(fd, [](int fd)
+	{
+		::close(fd);
+	});
+}
+
+void stdx::_NetworkIOService::_SetNonBlocking(socket_t sock)
+{
+	int flags = fcntl(sock, F_GETFL, 0);
+	flags |= SOCK_NONBLOCK;
+	fcntl(sock, F_SETFL, flags);
+}
+
+void stdx::_NetworkIOService::_SetReuseAddr(socket_t sock)
+{
+	int opt = 1;
+	::setsockopt(sock, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+}
+
+bool stdx::_NetworkIOService::_IOOperate(stdx::network_io_context* context)
+{
+	ssize_t r = 0;
+	if (context->code == stdx::network_io_context_code::recv)
+	{
+		r = ::recv(context->this_socket,(char *)context->buf, context->buf.size(), MSG_NOSIGNAL | MSG_DONTWAIT);
+	}
+	else if (context->code == stdx::network_io_context_code::recvfrom)
+	{
+		sockaddr_storage addr;
+		socklen_t addr_size = sizeof(sockaddr_storage);
+		r = ::recvfrom(context->this_socket, (char *)context->buf, context->size, MSG_NOSIGNAL | MSG_DONTWAIT, (sockaddr*)&addr, &addr_size);
+		if (r >= 0)
+		{
+			context->addr = stdx::socket_addr((sockaddr*)&addr, addr_size);
+		}
+}
+	else if (context->code == stdx::network_io_context_code::accept)
+	{
+		sockaddr_storage addr;
+		socklen_t addr_size = sizeof(sockaddr_storage);
+		context->target_socket = ::accept4(context->this_socket, (sockaddr*)&addr, &addr_size,SOCK_NONBLOCK|SOCK_CLOEXEC);
+		if (context->target_socket == -1 && (errno == EAGAIN || errno == EWOULDBLOCK))
+		{
+			return false;
+		}
+		//else if(errno == EMFILE)
+		//{
+		//	//Too may files open
+		//	::close(stdx::_NetworkIOService::m_null_fd);
+		//	stdx::_NetworkIOService::m_null_fd = ::accept4(context->this_socket, (sockaddr*)&addr, &addr_size, SOCK_NONBLOCK | SOCK_CLOEXEC);
+		//	::close(stdx::_NetworkIOService::m_null_fd);
+		//	stdx::_NetworkIOService::m_null_fd = stdx::_NetworkIOService::open_null_fd();
+		//	context->target_socket = -1;
+		//	r = -1;
+		//}
+		else
+		{
+			if (context->target_socket != -1)
+			{
+				context->addr = stdx::socket_addr((sockaddr*)&addr, addr_size);
+				_SetNonBlocking(context->target_socket);
+				r = 1;
+			}
+			else
+			{
+				r = -1;
+			}
+		}
+	}
+	else if (context->code == stdx::network_io_context_code::accept_batch)
+	{
+		//accept直到EAGAIN或用完budget(send_size)
+		while (context->accepted.size() < context->send_size)
+		{
+			sockaddr_storage addr;
+			socklen_t addr_size = sizeof(sockaddr_storage);
+			int fd = ::accept4(context->this_socket, (sockaddr*)&addr, &addr_size, SOCK_NONBLOCK | SOCK_CLOEXEC);
+			if (fd == -1)
+			{
+				break;
+			}
+			context->accepted.push_back(fd);
+			context->addrs.push_back(stdx::socket_addr((sockaddr*)&addr, addr_size));
+		}
+		//已接受的连接先交付,错误留给下一次
+		r = context->accepted.empty() ? -1 : (ssize_t)context->accepted.size();
+	}
+	else if (context->code == stdx::network_io_context_code::send_zerocopy)
+	{
+		stdx::zerocopy_state& state = *(context->zerocopy);
+		if (context->zc_begin == context->zc_end)
+		{
+			//尚未占用编号
+			context->zc_begin = state.next_id;
+			context->zc_end = state.next_id;
+		}
+		while (context->send_offset != context->send_size)
+		{
+			char* buf = context->buf;
+			buf += context->send_offset;
+			size_t buf_size = context->send_size - context->send_offset;
+			r = ::send(context->this_socket, buf, buf_size, MSG_NOSIGNAL | MSG_DONTWAIT | MSG_ZEROCOPY);
+			if (r > 0)
+			{
+				//每次成功的zerocopy发送占用一个通知编号
+				state.next_id += 1;
+			}
+			else if (r < 0 && errno == ENOBUFS)
+			{
+				//超出optmem限制,退回普通发送
+				r = ::send(context->this_socket, buf, buf_size, MSG_NOSIGNAL | MSG_DONTWAIT);
+			}
+			if (r <= 0)
+			{
+				break;
+			}
+			context->send_offset += r;
+		}
+		context->zc_end = state.next_id;
+		if (context->send_offset == context->send_size)
+		{
+			r = (ssize_t)context->send_offset;
+		}
+	}
+	else if (context->code == stdx::network_io_context_code::zerocopy_wait)
+	{
+		if (!_ReapZerocopy(context))
+		{
+			return false;
+		}
+		context->err_code = context->zc_err;
+		context->size = context->send_offset;
+		return true;
+	}
+	else if (context->code == stdx::network_io_context_code::send)
+	{
+		char* buf = context->buf;
+		buf += context->send_offset;
+		size_t buf_size = context->send_size;
+		buf_size -= context->send_offset;
+		r = ::send(context->this_socket, buf, buf_size, MSG_NOSIGNAL | MSG_DONTWAIT);
+		if (r != context->send_size && r > 0)
+		{
+			context->send_offset += r;
+			if (context->send_offset != context->send_size)
+			{
+				return false;
+			}
+		}
+	}
+	else if (context->code == stdx::network_io_context_code::sendto)
+	{
+		char* buf = context->buf;
+		buf += context->send_offset;
+		size_t buf_size = context->send_size;
+		buf_size -= context->send_offset;
+		r = ::sendto(context->this_socket,buf,buf_size, MSG_NOSIGNAL | MSG_DONTWAIT,context->addr,context->addr.length());
+		if (r != context->send_size && r > 0)
+		{
+			context->send_offset += r;
+			if (context->send_offset != context->send_size)
+			{
+				return false;
+			}
+		}
+	}
+	else if (context->code == stdx::network_io_context_code::sendv)
+	{
+		iovec iov[64];
+		while (true)
+		{
+			size_t bytes = 0;
+			size_t n = _MakeIovec(context, iov, stdx::sizeof_array(iov), context->send_offset, bytes);
+			msghdr msg;
+			memset(&msg, 0, sizeof(msghdr));
+			msg.msg_iov = iov;
+			msg.msg_iovlen = n;
+			r = ::sendmsg(context->this_socket, &msg, MSG_NOSIGNAL | MSG_DONTWAIT);
+			if (r <= 0)
+			{
+				break;
+			}
+			context->send_offset += r;
+			if (context->send_offset == context->send_size)
+			{
+				r = (ssize_t)context->send_offset;
+				break;
+			}
+			if ((size_t)r < bytes)
+			{
+				//发送缓冲区已满,等待下一次可写
+				return false;
+			}
+			//iovec超过单次上限,继续发送剩余部分
+		}
+	}
+	else if (context->code == stdx::network_io_context_code::recvv)
+	{
+		//读到EAGAIN或缓冲区填满为止
+		iovec iov[64];
+		while (context->send_offset < context->send_size)
+		{
+			size_t bytes = 0;
+			size_t n = _MakeIovec(context, iov, stdx::sizeof_array(iov), context->send_offset, bytes);
+			msghdr msg;
+			memset(&msg, 0, sizeof(msghdr));
+			msg.msg_iov = iov;
+			msg.msg_iovlen = n;
+			r = ::recvmsg(context->this_socket, &msg, MSG_DONTWAIT);
+			if (r <= 0)
+			{
+				break;
+			}
+			context->send_offset += r;
+		}
+		if (context->send_offset != 0)
+		{
+			//EOF或错误留给下一次接收
+			r = (ssize_t)context->send_offset;
+		}
+	}
+	else if (context->code == stdx::network_io_context_code::recvfrom_batch)
+	{
+		mmsghdr msgs[STDX_DATAGRAM_BATCH];
+		iovec iov[STDX_DATAGRAM_BATCH];
+		sockaddr_storage addrs[STDX_DATAGRAM_BATCH];
+		size_t n = context->bufs.size() - context->size;
+		if (n > STDX_DATAGRAM_BATCH)
+		{
+			n = STDX_DATAGRAM_BATCH;
+		}
+		memset(msgs, 0, sizeof(mmsghdr) * n);
+		for (size_t i = 0; i < n; ++i)
+		{
+			auto& view = context->bufs[context->size + i];
+			iov[i].iov_base = view.data();
+			iov[i].iov_len = view.size;
+			msgs[i].msg_hdr.msg_iov = &iov[i];
+			msgs[i].msg_hdr.msg_iovlen = 1;
+			msgs[i].msg_hdr.msg_name = &addrs[i];
+			msgs[i].msg_hdr.msg_namelen = sizeof(sockaddr_storage);
+		}
+		r = ::recvmmsg(context->this_socket, msgs, (unsigned int)n, MSG_DONTWAIT, nullptr);
+		if (r > 0)
+		{
+			for (ssize_t i = 0; i < r; ++i)
+			{
+				context->bufs[context->size + i].size = msgs[i].msg_len;
+				context->addrs[context->size + i] = stdx::socket_addr((sockaddr*)&addrs[i], msgs[i].msg_hdr.msg_namelen);
+			}
+			context->size += (size_t)r;
+			r = (ssize_t)context->size;
+		}
+		else if (r < 0 && context->size != 0)
+		{
+			//已收到的数据报先交付
+			r = (ssize_t)context->size;
+		}
+		else if (r == 0)
+		{
+			//空批次在提交前已完成,不应出现,避免被当作断开连接
+			return false;
+		}
+	}
+	else if (context->code == stdx::network_io_context_code::sendto_batch)
+	{
+		mmsghdr msgs[STDX_DATAGRAM_BATCH];
+		iovec iov[STDX_DATAGRAM_BATCH];
+		while (context->send_offset != context->send_size)
+		{
+			size_t n = context->send_size - context->send_offset;
+			if (n > STDX_DATAGRAM_BATCH)
+			{
+				n = STDX_DATAGRAM_BATCH;
+			}
+			memset(msgs, 0, sizeof(mmsghdr) * n);
+			for (size_t i = 0; i < n; ++i)
+			{
+				auto& view = context->bufs[context->send_offset + i];
+				iov[i].iov_base = view.data();
+				iov[i].iov_len = view.size;
+				msgs[i].msg_hdr.msg_iov = &iov[i];
+				msgs[i].msg_hdr.msg_iovlen = 1;
+				stdx::socket_addr& addr = context->addrs[context->send_offset + i];
+				msgs[i].msg_hdr.msg_name = (sockaddr*)addr;
+				msgs[i].msg_hdr.msg_namelen = addr.length();
+			}
+			r = ::sendmmsg(context->this_socket, msgs, (unsigned int)n, MSG_NOSIGNAL | MSG_DONTWAIT);
+			if (r < 0)
+			{
+				break;
+			}
+			context->send_offset += (size_t)r;
+		}
+		if (context->send_offset == context->send_size)
+		{
+			r = 1;
+		}
+	}
+	else if (context->code == stdx::network_io_context_code::sendfile)
+	{
+		//先发送前缀,文件内容未发完时带MSG_MORE
+		int flags = MSG_NOSIGNAL | MSG_DONTWAIT;
+		if (context->file_remain != 0)
+		{
+			flags |= MSG_MORE;
+		}
+		r = 1;
+		while (context->send_offset != context->send_size)
+		{
+			auto& prefix = context->bufs.front();
+			r = ::send(context->this_socket, prefix.data() + context->send_offset, context->send_size - context->send_offset, flags);
+			if (r <= 0)
+			{
+				break;
+			}
+			context->send_offset += (size_t)r;
+		}
+		//每轮最多发送STDX_SENDFILE_CHUNK字节
+		size_t budget = STDX_SENDFILE_CHUNK;
+		while (r > 0 && context->send_offset == context->send_size && context->file_remain != 0 && budget != 0)
+		{
+			size_t n = budget;
+			if (context->file_remain < n)
+			{
+				n = (size_t)context->file_remain;
+			}
+			if (context->file_is_pipe)
+			{
+				r = ::splice(context->target_socket, nullptr, context->this_socket, nullptr, n, SPLICE_F_MOVE | SPLICE_F_NONBLOCK | SPLICE_F_MORE);
+			}
+			else
+			{
+				r = ::sendfile(context->this_socket, context->target_socket, &context->file_offset, n);
+			}
+			if (r == 0)
+			{
+				if (!context->file_is_pipe)
+				{
+					//文件被截断,无法发完已声明的长度
+					errno = EIO;
+					r = -1;
+					break;
+				}
+				//管道写端关闭
+				context->file_remain = 0;
+				r = 1;
+				break;
+			}
+			if (r > 0)
+			{
+				context->file_remain -= (uint64_t)r;
+				budget -= (size_t)r;
+			}
+		}
+		if (r < 0 && context->file_is_pipe && (errno == EAGAIN || errno == EWOULDBLOCK))
+		{
+			//splice的EAGAIN也可能来自空管道:socket仍可写时改为等待管道可读
+			pollfd pfd;
+			pfd.fd = context->this_socket;
+			pfd.events = POLLOUT;
+			pfd.revents = 0;
+			if (::poll(&pfd, 1, 0) == 1 && (pfd.revents & POLLOUT))
+			{
+				context->code = stdx::network_io_context_code::sendfile_wait;
+				r = 1;
+			}
+			else
+			{
+				errno = EAGAIN;
+			}
+		}
+	}
+	else if (context->code == stdx::network_io_context_code::sendfile_wait)
+	{
+		//管道可读或写端关闭后回到socket继续发送
+		pollfd pfd;
+		pfd.fd = context->target_socket;
+		pfd.events = POLLIN;
+		pfd.revents = 0;
+		if (::poll(&pfd, 1, 0) == 1 && pfd.revents != 0)
+		{
+			context->code = stdx::network_io_context_code::sendfile;
+			r = 1;
+		}
+		else
+		{
+			errno = EAGAIN;
+			r = -1;
+		}
+	}
+	else if (context->code == stdx::network_io_context_code::connect)
+	{
+		r = 1;
+	}
+	if (r < 0)
+	{
+		if (errno == EWOULDBLOCK || errno == EAGAIN)
+		{
+			return false;
+		}
+		context->err_code = errno;
+	}
+	else if(r == 0)
+	{
+		context->err_code = ECONNRESET;
+	}
+	else
+	{
+		context->err_code = 0;
+	}
+	context->size = (size_t)r;
+	return true;
+}
+
+size_t stdx::_NetworkIOService::_MakeIovec(stdx::network_io_context* context, iovec* iov, size_t max, size_t skip, size_t& bytes)
+{
+	size_t n = 0;
+	bytes = 0;
+	for (auto begin = context->bufs.begin(), end = context->bufs.end(); begin != end && n < max; ++begin)
+	{
+		if (skip >= begin->size)
+		{
+			skip -= begin->size;
+			continue;
+		}
+		iov[n].iov_base = begin->data() + skip;
+		iov[n].iov_len = begin->size - skip;
+		bytes += iov[n].iov_len;
+		skip = 0;
+		n += 1;
+	}
+	return n;
+}
+
+uint32_t stdx::_NetworkIOService::_GetEvents(stdx::network_io_context* context)
+{
+	constexpr uint32_t check_in = stdx::network_io_context_code::accept | 
+		stdx::network_io_context_code::accept_ipv6 | 
+		stdx::network_io_context_code::recv | 
+		stdx::network_io_context_code::recvfrom | 
+		stdx::network_io_context_code::recvfrom_ipv6 |
+		stdx::network_io_context_code::recvv |
+		stdx::network_io_context_code::recvfrom_batch |
+		stdx::network_io_context_code::accept_batch |
+		stdx::network_io_context_code::sendfile_wait;
+	if (context->code & check_in)
+	{
+		return stdx::epoll_events::in;
+	}
+	constexpr uint32_t check_out = stdx::network_io_context_code::send |
+		stdx::network_io_context_code::sendfile |
+		stdx::network_io_context_code::sendto |
+		stdx::network_io_context_code::sendto_ipv6 |
+		stdx::network_io_context_code::sendv |
+		stdx::network_io_context_code::sendto_batch |
 		stdx::network_io_context_code::connect;
 	if (context->code & check_out)
 	{
 		return stdx::epoll_events::out;
 	}
+	if (context->code == stdx::network_io_context_code::send_zerocopy)
+	{
+		//完成通知经错误队列返回
+		return stdx::epoll_events::out | stdx::epoll_events::err;
+	}
+	if (context->code == stdx::network_io_context_code::zerocopy_wait)
+	{
+		return stdx::epoll_events::err;
+	}
 	return 0;
 }
 #endif // LINUX
@@ -1164,6 +2261,7 @@ DWORD stdx::_NetworkIOService::recv_flag = 0;
 stdx::_Socket::_Socket(const io_service_t& io_service, socket_t s)
 	:m_io_service(io_service)
 	, m_handle(s)
+	, m_same_loop(false)
 {}
 
 stdx::_Socket::_Socket(const io_service_t& io_service)
@@ -1173,6 +2271,7 @@ stdx::_Socket::_Socket(const io_service_t& io_service)
 #else
 	, m_handle(-1)
 #endif
+	, m_same_loop(false)
 {}
 
 stdx::_Socket::~_Socket()
@@ -1187,7 +2286,65 @@ stdx::task<stdx::network_send_event> stdx::_Socket::send(stdx::buffer buf, const
 		throw std::logic_error("this io service has been free");
 	}
 	stdx::task_completion_event<stdx::network_send_event> ce;
-	m_io_service.send(m_handle, buf, size, [ce](stdx::network_send_event context, std::exception_ptr error) mutable
+	std::function<void(stdx::network_send_event, std::exception_ptr)> call = [ce](stdx::network_send_event context, std::exception_ptr error) mutable
+		{
+			if (error)
+			{
+				ce.set_exception(error);
+			}
+			else
+			{
+				ce.set_value(context);
+			}
+			ce.run_on_this_thread();
+		};
+#ifdef LINUX
+	if (m_zerocopy && size >= STDX_ZEROCOPY_THRESHOLD)
+	{
+		m_io_service.send_zerocopy(m_handle, m_zerocopy, buf, size, std::move(call));
+	}
+	else
+	{
+		m_io_service.send(m_handle, buf, size, std::move(call));
+	}
+#else
+	m_io_service.send(m_handle, buf, size, std::move(call));
+#endif
+	auto t = ce.get_task();
+	return t;
+}
+
+stdx::task<stdx::network_send_event> stdx::_Socket::send(std::vector<stdx::buffer_view> bufs)
+{
+	if (!m_io_service)
+	{
+		throw std::logic_error("this io service has been free");
+	}
+	stdx::task_completion_event<stdx::network_send_event> ce;
+	m_io_service.send(m_handle, std::move(bufs), [ce](stdx::network_send_event context, std::exception_ptr error) mutable
+		{
+			if (error)
+			{
+				ce.set_exception(error);
+			}
+			else
+			{
+				ce.set_value(context);
+			}
+			ce.run_on_this_thread();
+		});
+	auto t = ce.get_task();
+	return t;
+}
+
+stdx::task<stdx::network_recv_event> stdx::_Socket::recv(std::vector<stdx::buffer_view> bufs)
+{
+	if (!m_io_service)
+	{
+		throw std::logic_error("this io service has been free");
+	}
+	stdx::task_completion_event<stdx::network_recv_event> ce;
+	m_io_service.recv(m_handle, std::move(bufs), [ce](stdx::network_recv_event context, std::exception_ptr error) mutable
 		{
 			if (error)
 			{
@@ -1204,13 +2361,18 @@ stdx::task<stdx::network_send_event> stdx::_Socket::send(stdx::buffer buf, const
 }
 
 stdx::task<void> stdx::_Socket::send_file(file_handle_t file_handle)
+{
+	return send_file(file_handle, 0, 0, stdx::buffer_view());
+}
+
+stdx::task<void> stdx::_Socket::send_file(file_handle_t file_handle, uint64_t offset, uint64_t length, stdx::buffer_view prefix)
 {
 	if (!m_io_service)
 	{
 		throw std::logic_error("this io service has been free");
 	}
 	stdx::task_completion_event<void> ce;
-	m_io_service.send_file(m_handle, file_handle, [ce](std::exception_ptr error) mutable
+	m_io_service.send_file(m_handle, file_handle, offset, length, prefix, [ce](std::exception_ptr error) mutable
 		{
 			if (error)
 			{
@@ -1226,7 +2388,7 @@ stdx::task<void> stdx::_Socket::send_file(file_handle_t file_handle)
 	return t;
 }
 
-stdx::task<stdx::network_send_event> stdx::_Socket::send_to(const ipv4_addr& addr, stdx::buffer buf, const socket_size_t& size)
+stdx::task<stdx::network_send_event> stdx::_Socket::send_to(const socket_addr& addr, stdx::buffer buf, const socket_size_t& size)
 {
 	if (!m_io_service)
 	{
@@ -1291,7 +2453,7 @@ stdx::task<stdx::network_accept_event> stdx::_Socket::accept()
 				ce.set_value(context);
 			}
 			ce.run_on_this_thread();
-	});
+	},m_same_loop);
 	auto t = ce.get_task();
 	return t;
 }
@@ -1325,6 +2487,24 @@ void stdx::_Socket::recv_until(stdx::buffer buf, stdx::cancel_token token, std::
 	{
 		return;
 	}
+#ifdef LINUX
+	m_io_service.recv_until(m_handle, buf, token, [fn, err_handler](stdx::network_recv_event ev, std::exception_ptr err) mutable
+	{
+			if (err)
+			{
+				err_handler(err);
+				return;
+			}
+			try
+			{
+				fn(ev);
+			}
+			catch (const std::exception&)
+			{
+				err_handler(std::current_exception());
+			}
+	});
+#else
 	m_io_service.recv(m_handle,buf, [token,fn,err_handler,this,buf](stdx::network_recv_event ev,std::exception_ptr err) mutable
 	{
 			try
@@ -1347,6 +2527,7 @@ void stdx::_Socket::recv_until(stdx::buffer buf, stdx::cancel_token token, std::
 				recv_until(buf, token, fn, err_handler);
 			}
 	});
+#endif
 }
 
 void stdx::_Socket::close()
@@ -1366,7 +2547,7 @@ void stdx::_Socket::close()
 #endif
 }
 
-stdx::task<void> stdx::_Socket::connect(ipv4_addr& addr)
+stdx::task<void> stdx::_Socket::connect(const socket_addr& addr)
 {
 	stdx::task_completion_event<void> ce;
 	m_io_service.connect_ex(m_handle, addr, [ce](std::exception_ptr err) mutable
@@ -1396,6 +2577,37 @@ void stdx::_Socket::accept_until(stdx::cancel_token token, std::function<void(st
 	{
 		return;
 	}
+#ifdef LINUX
+	m_io_service.accept_until(m_handle, STDX_ACCEPT_BATCH, token, [fn, err_handler, token, this](std::vector<stdx::network_accept_event> evs, std::exception_ptr err) mutable
+	{
+			if (err)
+			{
+				try
+				{
+					err_handler(err);
+				}
+				catch (const std::exception&)
+				{
+				}
+				//与原先一致:出错后重新注册
+				if (!token.is_cancel())
+				{
+					accept_until(token, fn, err_handler);
+				}
+				return;
+			}
+			for (auto begin = evs.begin(), end = evs.end(); begin != end; ++begin)
+			{
+				try
+				{
+					fn(*begin);
+				}
+				catch (const std::exception&)
+				{
+				}
+			}
+	}, m_same_loop);
+#else
 	m_io_service.accept_ex(m_handle, [fn,err_handler,token,this](stdx::network_accept_event ev,std::exception_ptr err) mutable
 	{
 			try
@@ -1416,7 +2628,8 @@ void stdx::_Socket::accept_until(stdx::cancel_token token, std::function<void(st
 			{
 				accept_until(token, fn, err_handler);
 			}
-	});
+	},m_same_loop);
+#endif
 }
 
 void stdx::_Socket::set_keepalive(bool opt)
@@ -1424,6 +2637,125 @@ void stdx::_Socket::set_keepalive(bool opt)
 	m_io_service.set_keepalive(m_handle,opt);
 }
 
+void stdx::_Socket::set_v6only(bool opt)
+{
+	m_io_service.set_v6only(m_handle, opt);
+}
+
+#ifdef LINUX
+void stdx::_Socket::set_reuse_port(bool opt)
+{
+	m_io_service.set_reuse_port(m_handle, opt);
+}
+
+void stdx::_Socket::bind_loop(size_t index)
+{
+	m_io_service.bind_loop(m_handle, index);
+	m_same_loop = true;
+}
+
+void stdx::_Socket::set_busy_poll(uint32_t us)
+{
+	m_io_service.set_busy_poll(m_handle, us);
+}
+
+void stdx::_Socket::set_zerocopy(bool opt)
+{
+	m_io_service.set_zerocopy(m_handle, opt);
+	if (opt)
+	{
+		if (!m_zerocopy)
+		{
+			m_zerocopy = std::make_shared<stdx::zerocopy_state>();
+		}
+	}
+	else
+	{
+		m_zerocopy.reset();
+	}
+}
+
+stdx::task<std::vector<stdx::network_recv_event>> stdx::_Socket::recv_from_batch(std::vector<stdx::buffer> bufs)
+{
+	if (!m_io_service)
+	{
+		throw std::logic_error("this io service has been free");
+	}
+	stdx::task_completion_event<std::vector<stdx::network_recv_event>> ce;
+	m_io_service.recv_from_batch(m_handle, std::move(bufs), [ce](std::vector<stdx::network_recv_event> evs, std::exception_ptr error) mutable
+		{
+			if (error)
+			{
+				ce.set_exception(error);
+			}
+			else
+			{
+				ce.set_value(std::move(evs));
+			}
+			ce.run_on_this_thread();
+		});
+	auto t = ce.get_task();
+	return t;
+}
+
+stdx::task<std::vector<stdx::network_recv_event>> stdx::_Socket::recv_from_batch(size_t n, size_t size)
+{
+	std::vector<stdx::buffer> bufs;
+	bufs.reserve(n);
+	for (size_t i = 0; i < n; ++i)
+	{
+		bufs.push_back(stdx::make_buffer(size));
+	}
+	return recv_from_batch(std::move(bufs));
+}
+
+stdx::task<std::vector<stdx::network_accept_event>> stdx::_Socket::accept_batch(size_t budget)
+{
+	if (!m_io_service)
+	{
+		throw std::logic_error("this io service has been free");
+	}
+	stdx::task_completion_event<std::vector<stdx::network_accept_event>> ce;
+	m_io_service.accept_batch(m_handle, budget, [ce](std::vector<stdx::network_accept_event> evs, std::exception_ptr error) mutable
+		{
+			if (error)
+			{
+				ce.set_exception(error);
+			}
+			else
+			{
+				ce.set_value(std::move(evs));
+			}
+			ce.run_on_this_thread();
+		}, m_same_loop);
+	auto t = ce.get_task();
+	return t;
+}
+
+stdx::task<size_t> stdx::_Socket::send_to_batch(std::vector<stdx::network_datagram> datagrams)
+{
+	if (!m_io_service)
+	{
+		throw std::logic_error("this io service has been free");
+	}
+	stdx::task_completion_event<size_t> ce;
+	m_io_service.send_to_batch(m_handle, std::move(datagrams), [ce](size_t n, std::exception_ptr error) mutable
+		{
+			if (error)
+			{
+				ce.set_exception(error);
+			}
+			else
+			{
+				ce.set_value(n);
+			}
+			ce.run_on_this_thread();
+		});
+	auto t = ce.get_task();
+	return t;
+}
+#endif
+
 stdx::task<stdx::network_connected_event> stdx::socket::accept()
 {
 	io_service_t io_service = m_impl->get_io_service();
@@ -1445,6 +2777,24 @@ stdx::task<stdx::network_connected_event> stdx::socket::accept()
 
 
 
+#ifdef LINUX
+stdx::task<std::vector<stdx::network_connected_event>> stdx::socket::accept_batch(size_t budget)
+{
+	io_service_t io_service = m_impl->get_io_service();
+	return m_impl->accept_batch(budget).then([io_service](std::vector<stdx::network_accept_event> evs) mutable
+	{
+			std::vector<stdx::network_connected_event> conns;
+			conns.reserve(evs.size());
+			for (auto begin = evs.begin(), end = evs.end(); begin != end; ++begin)
+			{
+				stdx::socket _sock(io_service, begin->accept);
+				conns.push_back(stdx::network_connected_event(_sock, begin->addr));
+			}
+			return conns;
+	});
+}
+#endif
+
 void stdx::socket::accept_until(stdx::cancel_token token, std::function<void(stdx::network_connected_event)> fn, std::function<void(std::exception_ptr)> err_handler)
 {
 	m_impl->accept_until(token, [fn,this](stdx::network_accept_event ev) mutable 
@@ -1476,6 +2826,48 @@ stdx::socket stdx::open_udpsocket(const stdx::network_io_service& io_service)
 {
 	return stdx::open_socket(io_service, stdx::addr_family::ip, stdx::socket_type::dgram, stdx::protocol::udp);
 }
+
+stdx::socket stdx::open_socket(const stdx::network_io_service& io_service, const stdx::socket_addr& addr, const stdx::socket_type& sock_type)
+{
+	//Unix域socket只能使用默认协议
+	return stdx::open_socket(io_service, addr.family(), stdx::forward_socket_type(sock_type), 0);
+}
+
+std::vector<stdx::socket> stdx::open_reuse_port_tcpsockets(const stdx::network_io_service& io_service, const stdx::socket_addr& addr, int backlog, size_t num)
+{
+	std::vector<stdx::socket> socks;
+#ifdef WIN32
+	//IOCP没有分离的事件循环
+	NO_USED(num);
+	stdx::socket sock = stdx::open_socket(io_service, addr, stdx::socket_type::stream);
+	sock.bind(addr);
+	sock.listen(backlog);
+	socks.push_back(sock);
+#else
+	size_t loops = stdx::threadpool.get_poller().size();
+	if (num == 0)
+	{
+		num = loops;
+	}
+	socks.reserve(num);
+	stdx::socket_addr bind_addr = addr;
+	for (size_t i = 0; i < num; ++i)
+	{
+		stdx::socket sock = stdx::open_socket(io_service, addr, stdx::socket_type::stream);
+		sock.set_reuse_port(true);
+		sock.bind_loop(i % loops);
+		sock.bind(bind_addr);
+		if (i == 0)
+		{
+			//端口为0时其余socket绑定到第一个socket分配的端口
+			bind_addr = sock.local_addr();
+		}
+		sock.listen(backlog);
+		socks.push_back(sock);
+	}
+#endif
+	return socks;
+}
 #endif
 
 #ifdef WIN32
@@ -0,0 +1,493 @@
+﻿#include "http_test.h"
+#include "test_util.h"
+#include <stdx/net/http_acceptor.h>
+#include <stdx/net/http_static.h>
+#include <mutex>
+#include <atomic>
+#include <vector>
+#ifdef LINUX
+#include <sys/stat.h>
+#endif
+
+//按请求路径返回预先写好的原始响应,close为true时发送后关闭连接
+using _RawHandler = std::function<std::string(const std::string& path, bool& close)>;
+
+//每个连接一个线程的阻塞服务器,用于构造不规范的响应
+class _RawHttpServer
+{
+public:
+	_RawHttpServer(stdx::network_io_service& io_service, uint16_t port, _RawHandler handler)
+		:m_io_service(io_service)
+		,m_addr(U("127.0.0.1"), port)
+		,m_listener(stdx::open_tcpsocket(io_service))
+		,m_handler(handler)
+		,m_accepted(0)
+		,m_stop(false)
+	{
+		m_listener.bind(m_addr);
+		m_listener.listen(16);
+		m_acceptor = std::thread([this]() {_Accept(); });
+	}
+
+	~_RawHttpServer()
+	{
+		stop();
+	}
+
+	stdx::socket_addr addr() const
+	{
+		return m_addr;
+	}
+
+	int accepted() const
+	{
+		return m_accepted;
+	}
+
+	//调用前客户端需要关闭连接,否则连接线程不会退出
+	void stop()
+	{
+		if (m_stop.exchange(true))
+		{
+			return;
+		}
+		stdx::socket wake = stdx::open_tcpsocket(m_io_service);
+		wake.connect(m_addr).get().get();
+		m_acceptor.join();
+		wake.close();
+		m_listener.close();
+		for (auto begin = m_workers.begin(), end = m_workers.end(); begin != end; ++begin)
+		{
+			begin->join();
+		}
+	}
+private:
+	stdx::network_io_service m_io_service;
+	stdx::ipv4_addr m_addr;
+	stdx::socket m_listener;
+	_RawHandler m_handler;
+	std::thread m_acceptor;
+	std::vector<std::thread> m_workers;
+	std::atomic_int m_accepted;
+	std::atomic_bool m_stop;
+
+	void _Accept()
+	{
+		while (true)
+		{
+			stdx::socket sock = m_listener.accept().get().get().connection;
+			if (m_stop)
+			{
+				sock.close();
+				return;
+			}
+			m_accepted += 1;
+			m_workers.push_back(std::thread([this, sock]() {_Serve(sock); }));
+		}
+	}
+
+	void _Serve(stdx::socket sock)
+	{
+		std::string data;
+		stdx::buffer buf = stdx::make_buffer(4096);
+		while (true)
+		{
+			size_t pos = data.find("\r\n\r\n");
+			if (pos == std::string::npos)
+			{
+				try
+				{
+					stdx::network_recv_event ev = sock.recv(buf).get().get();
+					if (ev.size == 0)
+					{
+						break;
+					}
+					char* p = ev.buffer;
+					data.append(p, ev.size);
+				}
+				catch (const std::exception&)
+				{
+					break;
+				}
+				continue;
+			}
+			//只处理没有请求体的请求
+			size_t begin = data.find(' ') + 1;
+			std::string path = data.substr(begin, data.find(' ', begin) - begin);
+			data.erase(0, pos + 4);
+			bool close = false;
+			std::string res = m_handler(path, close);
+			sock.send(_MakeBuffer(res), res.size()).get().get();
+			if (close)
+			{
+				break;
+			}
+		}
+		sock.close();
+	}
+};
+
+static std::string _Respond(const std::string& path, bool& close)
+{
+	if (path == "/chunked")
+	{
+		return "HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\n5\r\nhello\r\n6\r\n world\r\n0\r\n\r\n";
+	}
+	if (path == "/close")
+	{
+		close = true;
+		return "HTTP/1.1 200 OK\r\nConnection: close\r\nContent-Length: 5\r\n\r\nbye!!";
+	}
+	if (path == "/truncated")
+	{
+		close = true;
+		return "HTTP/1.1 200 OK\r\nContent-Length: 100\r\n\r\nshort";
+	}
+	return "HTTP/1.1 200 OK\r\nContent-Length: 5\r\n\r\nhello";
+}
+
+static std::string _Body(const stdx::http_response& res)
+{
+	std::vector<unsigned char> data = res.response_body().data();
+	return std::string(data.begin(), data.end());
+}
+
+//按slice字节分段推入解析器,slice为0表示一次推入
+static bool _ParseAll(const std::string& data, size_t slice, std::vector<stdx::http_request>& out)
+{
+	stdx::http_request_parser parser(1024 * 1024);
+	if (slice == 0)
+	{
+		slice = data.size();
+	}
+	try
+	{
+		for (size_t pos = 0; pos < data.size(); pos += slice)
+		{
+			std::string part = data.substr(pos, slice);
+			parser.push(_MakeBuffer(part), part.size());
+			while (parser.finish_count() != 0)
+			{
+				out.push_back(parser.pop());
+			}
+		}
+	}
+	catch (const std::exception&)
+	{
+		return false;
+	}
+	return !parser.error();
+}
+
+static std::string _Body(const stdx::http_request& req)
+{
+	std::vector<unsigned char> data = req.form().to_bytes();
+	return std::string(data.begin(), data.end());
+}
+
+static bool _IsRequest(const stdx::http_request& req, stdx::http_method method, const stdx::string& url, const std::string& body)
+{
+	return req.request_header().method() == method && req.request_header().request_url() == url && _Body(req) == body;
+}
+
+//流水线中的定长,chunked(带扩展与trailer)请求在任意分段下都能完整解析
+static bool _ParserPipelined()
+{
+	std::string data = "GET /a HTTP/1.1\r\nHost: t\r\n\r\n"
+		"POST /b HTTP/1.1\r\nHost: t\r\nContent-Type: text/plain\r\nContent-Length: 5\r\n\r\nhello"
+		"POST /c HTTP/1.1\r\nHost: t\r\nContent-Type: text/plain\r\nTransfer-Encoding: chunked\r\n\r\n"
+		"3;ext=1\r\nabc\r\n4\r\ndefg\r\n0\r\nX-Trailer: v\r\n\r\n"
+		"GET /d HTTP/1.1\r\nHost: t\r\n\r\n";
+	size_t slices[] = { 0,1,7 };
+	bool ok = true;
+	for (size_t slice : slices)
+	{
+		std::vector<stdx::http_request> reqs;
+		ok = _ParseAll(data, slice, reqs) && reqs.size() == 4
+			&& _IsRequest(reqs[0], stdx::http_method::get, U("/a"), std::string())
+			&& _IsRequest(reqs[1], stdx::http_method::post, U("/b"), "hello")
+			&& _IsRequest(reqs[2], stdx::http_method::post, U("/c"), "abcdefg")
+			&& _IsRequest(reqs[3], stdx::http_method::get, U("/d"), std::string()) && ok;
+	}
+	return ok;
+}
+
+//同时带Transfer-Encoding与Content-Length的请求被拒绝
+static bool _ParserRejectTeAndCl()
+{
+	std::vector<stdx::http_request> reqs;
+	std::string data = "POST /a HTTP/1.1\r\nHost: t\r\nTransfer-Encoding: chunked\r\nContent-Length: 5\r\n\r\n0\r\n\r\n";
+	return !_ParseAll(data, 0, reqs) && reqs.empty();
+}
+
+//超出uint64_t的Content-Length被拒绝
+static bool _ParserRejectOverflow()
+{
+	std::vector<stdx::http_request> reqs;
+	std::string data = "POST /a HTTP/1.1\r\nHost: t\r\nContent-Length: 18446744073709551616\r\n\r\n";
+	return !_ParseAll(data, 0, reqs) && reqs.empty();
+}
+
+//发送GET请求,失败时返回false
+static bool _Get(stdx::http_client& client, const stdx::socket_addr& addr, const char* path, std::string& body)
+{
+	try
+	{
+		stdx::http_request req(stdx::http_method::get, stdx::string::from_u8_string(path));
+		stdx::http_response res = client.send(addr, req).get().get();
+		body = _Body(res);
+		return res.response_header().status_code() == 200;
+	}
+	catch (const std::exception&)
+	{
+		return false;
+	}
+}
+
+//keep-alive响应读完后归还连接,后续请求复用同一个连接
+static bool _ClientKeepalive(stdx::network_io_service& io_service)
+{
+	_RawHttpServer server(io_service, 18100, _Respond);
+	stdx::http_client client = stdx::make_http_client(io_service);
+	bool ok = true;
+	for (int i = 0; i < 3; ++i)
+	{
+		std::string body;
+		ok = _Get(client, server.addr(), "/keep", body) && body == "hello" && ok;
+	}
+	ok = ok && server.accepted() == 1;
+	client.close();
+	server.stop();
+	return ok;
+}
+
+//响应要求关闭连接时不归还,下一个请求使用新连接
+static bool _ClientConnectionClose(stdx::network_io_service& io_service)
+{
+	_RawHttpServer server(io_service, 18101, _Respond);
+	stdx::http_client client = stdx::make_http_client(io_service);
+	std::string first, second;
+	bool ok = _Get(client, server.addr(), "/close", first) && first == "bye!!";
+	ok = _Get(client, server.addr(), "/keep", second) && second == "hello" && ok;
+	ok = ok && server.accepted() == 2;
+	client.close();
+	server.stop();
+	return ok;
+}
+
+//分块响应合并为完整的响应体,之后连接仍然可以复用
+static bool _ClientChunked(stdx::network_io_service& io_service)
+{
+	_RawHttpServer server(io_service, 18102, _Respond);
+	stdx::http_client client = stdx::make_http_client(io_service);
+	std::string chunked, plain;
+	bool ok = _Get(client, server.addr(), "/chunked", chunked) && chunked == "hello world";
+	ok = _Get(client, server.addr(), "/keep", plain) && plain == "hello" && ok;
+	ok = ok && server.accepted() == 1;
+	client.close();
+	server.stop();
+	return ok;
+}
+
+//响应体没有读完连接就关闭时返回错误,连接不归还
+static bool _ClientTruncated(stdx::network_io_service& io_service)
+{
+	_RawHttpServer server(io_service, 18103, _Respond);
+	stdx::http_client client = stdx::make_http_client(io_service);
+	bool failed = false;
+	try
+	{
+		stdx::http_request req(stdx::http_method::get, U("/truncated"));
+		client.send(server.addr(), req).get().get();
+	}
+	catch (const std::exception&)
+	{
+		failed = true;
+	}
+	std::string body;
+	bool ok = failed && _Get(client, server.addr(), "/keep", body) && body == "hello";
+	ok = ok && server.accepted() == 2;
+	client.close();
+	server.stop();
+	return ok;
+}
+
+#ifdef LINUX
+//root目录下的静态文件服务,root之外放一个不能访问的文件
+struct _StaticFixture
+{
+	std::string dir;
+	std::string content;
+	stdx::http_acceptor acceptor;
+	stdx::cancel_token token;
+	stdx::socket_addr addr;
+};
+
+static bool _StartStatic(stdx::network_io_service& io_service, _StaticFixture& fixture)
+{
+	char dir[] = "/tmp/stdx_static_XXXXXX";
+	if (!::mkdtemp(dir))
+	{
+		return false;
+	}
+	fixture.dir = dir;
+	for (size_t i = 0; i < 1000; ++i)
+	{
+		fixture.content.push_back((char)('a' + i % 26));
+	}
+	if (::mkdir((fixture.dir + "/www").c_str(), 0755) != 0 || !_WriteFile(fixture.dir + "/www/data.txt", fixture.content) || !_WriteFile(fixture.dir + "/secret.txt", "secret"))
+	{
+		return false;
+	}
+	stdx::ipv4_addr addr(U("127.0.0.1"), 18104);
+	fixture.addr = addr;
+	fixture.acceptor = stdx::make_http_acceptor(io_service, addr, 1024 * 1024);
+	stdx::http_static_file_handler files = stdx::make_http_static_file_handler(stdx::string::from_u8_string(fixture.dir + "/www"));
+	fixture.acceptor.accept_until(fixture.token, [files](stdx::http_connection conn) mutable
+	{
+		stdx::cancel_token token;
+		conn.read_until(token, [token, conn, files](stdx::http_request req) mutable
+		{
+			bool keep = req.request_header().is_keepalive();
+			files.handle(conn, req).then([conn, keep](stdx::task_result<void> r) mutable
+			{
+				try
+				{
+					r.get();
+				}
+				catch (const std::exception&)
+				{
+					conn.close();
+					return;
+				}
+				if (!keep)
+				{
+					conn.close();
+				}
+			});
+			if (!keep)
+			{
+				token.cancel();
+			}
+		}, [token, conn](std::exception_ptr) mutable
+		{
+			token.cancel();
+			conn.close();
+		});
+	}, [](std::exception_ptr) {});
+	return true;
+}
+
+static void _StopStatic(_StaticFixture& fixture)
+{
+	fixture.token.cancel();
+	::unlink((fixture.dir + "/www/data.txt").c_str());
+	::rmdir((fixture.dir + "/www").c_str());
+	::unlink((fixture.dir + "/secret.txt").c_str());
+	::rmdir(fixture.dir.c_str());
+}
+
+//发送请求,header为空时不添加头部
+static bool _Send(stdx::http_client& client, const stdx::socket_addr& addr, const char* path, const char* name, const std::string& value, stdx::http_response& res)
+{
+	try
+	{
+		stdx::http_request req(stdx::http_method::get, stdx::string::from_u8_string(path));
+		if (name)
+		{
+			req.request_header().add_header(stdx::string::from_u8_string(name), stdx::string::from_u8_string(value));
+		}
+		res = client.send(addr, req).get().get();
+		return true;
+	}
+	catch (const std::exception&)
+	{
+		return false;
+	}
+}
+
+static std::string _Header(const stdx::http_response& res, const char* name)
+{
+	std::string value;
+	res.response_header().raw_value(name, value);
+	return value;
+}
+
+//单个范围和后缀范围返回206和对应的Content-Range
+static bool _StaticRange(stdx::http_client& client, _StaticFixture& fixture)
+{
+	stdx::http_response res;
+	bool ok = _Send(client, fixture.addr, "/data.txt", "Range", "bytes=10-19", res);
+	ok = ok && res.response_header().status_code() == 206 && _Body(res) == fixture.content.substr(10, 10) && _Header(res, "Content-Range") == "bytes 10-19/1000";
+	ok = _Send(client, fixture.addr, "/data.txt", "Range", "bytes=-5", res) && ok;
+	ok = ok && res.response_header().status_code() == 206 && _Body(res) == fixture.content.substr(995) && _Header(res, "Content-Range") == "bytes 995-999/1000";
+	return ok;
+}
+
+//起点超出文件大小时返回416
+static bool _StaticRangeUnsatisfiable(stdx::http_client& client, _StaticFixture& fixture)
+{
+	stdx::http_response res;
+	bool ok = _Send(client, fixture.addr, "/data.txt", "Range", "bytes=1000-", res);
+	return ok && res.response_header().status_code() == 416 && _Header(res, "Content-Range") == "bytes */1000";
+}
+
+//If-None-Match与ETag相同时返回没有响应体的304
+static bool _StaticNotModified(stdx::http_client& client, _StaticFixture& fixture)
+{
+	stdx::http_response res;
+	bool ok = _Send(client, fixture.addr, "/data.txt", nullptr, std::string(), res);
+	std::string etag = _Header(res, "ETag");
+	ok = ok && res.response_header().status_code() == 200 && _Body(res) == fixture.content && !etag.empty();
+	ok = _Send(client, fixture.addr, "/data.txt", "If-None-Match", etag, res) && ok;
+	ok = ok && res.response_header().status_code() == 304 && _Body(res).empty();
+	ok = _Send(client, fixture.addr, "/data.txt", "If-None-Match", "\"other\"", res) && ok;
+	return ok && res.response_header().status_code() == 200;
+}
+
+//不存在的文件和root之外的路径都返回404
+static bool _StaticNotFound(stdx::http_client& client, _StaticFixture& fixture)
+{
+	const char* paths[] = { "/missing.txt", "/../secret.txt", "/%2e%2e/secret.txt", "/a/../../secret.txt" };
+	bool ok = true;
+	for (size_t i = 0; i < sizeof(paths) / sizeof(paths[0]); ++i)
+	{
+		stdx::http_response res;
+		ok = _Send(client, fixture.addr, paths[i], nullptr, std::string(), res) && res.response_header().status_code() == 404 && ok;
+	}
+	return ok;
+}
+#endif
+
+int http_test(int argc, char** argv)
+{
+	NO_USED(argc);
+	NO_USED(argv);
+	stdx::network_io_service io_service;
+	bool ok = true;
+	ok = _Check(_ParserPipelined(), "parser pipelined requests") && ok;
+	ok = _Check(_ParserRejectTeAndCl(), "parser rejects te and cl") && ok;
+	ok = _Check(_ParserRejectOverflow(), "parser rejects content-length overflow") && ok;
+	ok = _Check(_ClientKeepalive(io_service), "client keep-alive reuse") && ok;
+	ok = _Check(_ClientConnectionClose(io_service), "client connection close") && ok;
+	ok = _Check(_ClientChunked(io_service), "client chunked response") && ok;
+	ok = _Check(_ClientTruncated(io_service), "client truncated response") && ok;
+#ifdef LINUX
+	_StaticFixture fixture;
+	if (_Check(_StartStatic(io_service, fixture), "static handler setup"))
+	{
+		stdx::http_client client = stdx::make_http_client(io_service);
+		ok = _Check(_StaticRange(client, fixture), "static range") && ok;
+		ok = _Check(_StaticRangeUnsatisfiable(client, fixture), "static range not satisfiable") && ok;
+		ok = _Check(_StaticNotModified(client, fixture), "static not modified") && ok;
+		ok = _Check(_StaticNotFound(client, fixture), "static not found and traversal") && ok;
+		client.close();
+	}
+	else
+	{
+		ok = false;
+	}
+	_StopStatic(fixture);
+#endif
+	return ok ? 0 : 1;
+}
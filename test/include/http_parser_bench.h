@@ -0,0 +1,5 @@
+#pragma  once
+#include <stdx/net/http_parser.h>
+
+//请求头解析的微基准,输出吞吐量与每周期字节数
+int http_parser_bench(int argc, char** argv);
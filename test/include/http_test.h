@@ -0,0 +1,5 @@
+#pragma once
+#include <stdx/net/http_client.h>
+
+//http客户端的行为检查,全部通过时返回0
+int http_test(int argc, char** argv);
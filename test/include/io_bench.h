@@ -0,0 +1,5 @@
+#pragma  once
+#include <stdx/net/socket.h>
+
+//loopback上send/recv往返的微基准
+int io_bench(int argc, char** argv);
\ No newline at end of file
@@ -0,0 +1,5 @@
+#pragma once
+#include <stdx/net/socket.h>
+
+//socket各项功能的行为检查,全部通过时返回0
+int socket_test(int argc, char** argv);
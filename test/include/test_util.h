@@ -0,0 +1,97 @@
+#pragma once
+#include <stdx/net/socket.h>
+#include <string>
+#include <functional>
+#include <thread>
+#include <chrono>
+#ifdef LINUX
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+//各项检查共用的辅助函数
+
+//输出检查结果并原样返回
+inline bool _Check(bool ok, const char* name)
+{
+	stdx::printf(U("{0}: {1}\n"), stdx::string::from_u8_string(name), ok ? U("ok") : U("failed"));
+	return ok;
+}
+
+inline stdx::buffer _MakeBuffer(const std::string& str)
+{
+	stdx::buffer buf = stdx::make_buffer(str.size());
+	for (size_t i = 0; i < str.size(); ++i)
+	{
+		buf[i] = str[i];
+	}
+	return buf;
+}
+
+//在timeout_ms内等待条件成立
+inline bool _WaitFor(std::function<bool()> cond, uint32_t timeout_ms)
+{
+	auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+	while (!cond())
+	{
+		if (std::chrono::steady_clock::now() > deadline)
+		{
+			return false;
+		}
+		std::this_thread::sleep_for(std::chrono::milliseconds(5));
+	}
+	return true;
+}
+
+//建立一对loopback连接
+inline void _Connect(stdx::network_io_service& io_service, uint16_t port, stdx::socket& client, stdx::socket& server)
+{
+	stdx::ipv4_addr addr(U("127.0.0.1"), port);
+	stdx::socket listener = stdx::open_tcpsocket(io_service);
+	listener.bind(addr);
+	listener.listen(16);
+	auto accepted = listener.accept();
+	client = stdx::open_tcpsocket(io_service);
+	client.connect(addr).get().get();
+	server = accepted.get().get().connection;
+	listener.close();
+}
+
+//读取size字节,连接关闭或出错时提前返回
+inline std::string _RecvAll(stdx::socket& sock, size_t size)
+{
+	std::string data;
+	stdx::buffer buf = stdx::make_buffer(65536);
+	while (data.size() < size)
+	{
+		try
+		{
+			stdx::network_recv_event ev = sock.recv(buf).get().get();
+			if (ev.size == 0)
+			{
+				break;
+			}
+			char* p = ev.buffer;
+			data.append(p, ev.size);
+		}
+		catch (const std::exception&)
+		{
+			break;
+		}
+	}
+	return data;
+}
+
+#ifdef LINUX
+inline bool _WriteFile(const std::string& path, const std::string& content)
+{
+	int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if (fd < 0)
+	{
+		return false;
+	}
+	bool ok = ::write(fd, content.data(), content.size()) == (ssize_t)content.size();
+	::close(fd);
+	return ok;
+}
+#endif
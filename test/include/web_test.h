@@ -9,5 +9,6 @@
 #include <stdx/debug.h>
 #include <stdx/traits/max_type.h>
 #include <stdx/net/http_acceptor.h>
+#include <stdx/net/http_static.h>
 
 extern int web_test(int argc, char** argv);
\ No newline at end of file
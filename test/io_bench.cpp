@@ -0,0 +1,53 @@
+#include "io_bench.h"
+#include <chrono>
+#include <algorithm>
+
+int io_bench(int argc, char** argv)
+{
+	NO_USED(argc);
+	NO_USED(argv);
+	constexpr size_t round_trips = 100000;
+	constexpr size_t message_size = 64;
+	stdx::network_io_service io_service;
+	stdx::ipv4_addr addr(U("127.0.0.1"), 18080);
+	stdx::socket listener = stdx::open_tcpsocket(io_service);
+	listener.bind(addr);
+	listener.listen(16);
+	auto accepted = listener.accept();
+	stdx::socket client = stdx::open_tcpsocket(io_service);
+	client.connect(addr).get().get();
+	stdx::socket server = accepted.get().get().connection;
+	//echo
+	stdx::cancel_token token;
+	server.recv_until(stdx::make_buffer(message_size), token, [server](stdx::network_recv_event ev) mutable
+		{
+			//接收缓冲区会被下一块数据覆盖,发送复制出的数据
+			stdx::buffer echo = stdx::make_buffer(ev.size);
+			char* data = ev.buffer;
+			std::copy(data, data + ev.size, (char*)echo);
+			auto t = server.send(echo, ev.size);
+			NO_USED(t);
+		}, [](std::exception_ptr) {});
+	stdx::buffer out = stdx::make_buffer(message_size);
+	stdx::buffer in = stdx::make_buffer(message_size);
+	auto begin = std::chrono::steady_clock::now();
+	for (size_t i = 0; i < round_trips; ++i)
+	{
+		client.send(out, message_size).get().get();
+		size_t received = 0;
+		while (received < message_size)
+		{
+			received += client.recv(in).get().get().size;
+		}
+	}
+	auto end = std::chrono::steady_clock::now();
+	double seconds = std::chrono::duration<double>(end - begin).count();
+	stdx::printf(U("round trips: {0}\n"), round_trips);
+	stdx::printf(U("seconds: {0}\n"), seconds);
+	stdx::printf(U("round trips per second: {0}\n"), (uint64_t)(round_trips / seconds));
+	token.cancel();
+	client.close();
+	server.close();
+	listener.close();
+	return 0;
+}
@@ -0,0 +1,915 @@
+#include "socket_test.h"
+#include "test_util.h"
+#include <stdx/net/connection_pool.h>
+#include <stdx/net/buffered_socket.h>
+#include <ctime>
+#include <mutex>
+#include <atomic>
+
+struct _RecvState
+{
+	std::mutex lock;
+	std::string data;
+	std::atomic_int errors;
+};
+
+//持久注册按顺序交付每块数据
+static bool _RecvUntil(stdx::network_io_service& io_service)
+{
+	stdx::socket client, server;
+	_Connect(io_service, 18093, client, server);
+	auto state = std::make_shared<_RecvState>();
+	state->errors = 0;
+	stdx::cancel_token token;
+	server.recv_until(stdx::make_buffer(7), token, [state](stdx::network_recv_event ev)
+	{
+		std::unique_lock<std::mutex> lock(state->lock);
+		char* p = ev.buffer;
+		state->data.append(p, ev.size);
+	}, [state](std::exception_ptr)
+	{
+		state->errors += 1;
+	});
+	std::string expect;
+	for (int i = 0; i < 100; ++i)
+	{
+		std::string msg = "message " + std::to_string(i) + ";";
+		expect += msg;
+		client.send(_MakeBuffer(msg), msg.size()).get().get();
+	}
+	bool ok = _WaitFor([state, &expect]()
+	{
+		std::unique_lock<std::mutex> lock(state->lock);
+		return state->data.size() >= expect.size();
+	}, 3000);
+	token.cancel();
+	{
+		std::unique_lock<std::mutex> lock(state->lock);
+		ok = ok && state->data == expect && state->errors == 0;
+	}
+	client.close();
+	server.close();
+	return ok;
+}
+
+//注册空闲时被取消,之后到达的数据留给下一个recv
+static bool _RecvUntilCancel(stdx::network_io_service& io_service)
+{
+	stdx::socket client, server;
+	_Connect(io_service, 18094, client, server);
+	auto state = std::make_shared<_RecvState>();
+	state->errors = 0;
+	stdx::cancel_token token;
+	server.recv_until(stdx::make_buffer(64), token, [state](stdx::network_recv_event ev)
+	{
+		std::unique_lock<std::mutex> lock(state->lock);
+		char* p = ev.buffer;
+		state->data.append(p, ev.size);
+	}, [state](std::exception_ptr)
+	{
+		state->errors += 1;
+	});
+	client.send(_MakeBuffer("first"), 5).get().get();
+	bool ok = _WaitFor([state]()
+	{
+		std::unique_lock<std::mutex> lock(state->lock);
+		return state->data.size() >= 5;
+	}, 3000);
+	token.cancel();
+	client.send(_MakeBuffer("second"), 6).get().get();
+	std::this_thread::sleep_for(std::chrono::milliseconds(50));
+	auto next = std::make_shared<_RecvState>();
+	next->errors = 0;
+	server.recv(stdx::make_buffer(64)).then([next](stdx::task_result<stdx::network_recv_event> r)
+	{
+		std::unique_lock<std::mutex> lock(next->lock);
+		try
+		{
+			stdx::network_recv_event ev = r.get();
+			char* p = ev.buffer;
+			next->data.append(p, ev.size);
+		}
+		catch (const std::exception&)
+		{
+			next->errors += 1;
+		}
+	});
+	//数据被丢弃时这次recv不会完成
+	ok = _WaitFor([next]()
+	{
+		std::unique_lock<std::mutex> lock(next->lock);
+		return !next->data.empty() || next->errors != 0;
+	}, 1000) && ok;
+	{
+		std::unique_lock<std::mutex> lock(state->lock);
+		std::unique_lock<std::mutex> next_lock(next->lock);
+		ok = ok && state->data == "first" && next->data == "second" && state->errors == 0;
+	}
+	client.close();
+	server.close();
+	return ok;
+}
+
+//回调抛出的异常交给错误回调,注册继续
+static bool _RecvUntilCallbackError(stdx::network_io_service& io_service)
+{
+	stdx::socket client, server;
+	_Connect(io_service, 18095, client, server);
+	auto state = std::make_shared<_RecvState>();
+	state->errors = 0;
+	stdx::cancel_token token;
+	server.recv_until(stdx::make_buffer(64), token, [state](stdx::network_recv_event ev)
+	{
+		std::unique_lock<std::mutex> lock(state->lock);
+		char* p = ev.buffer;
+		state->data.append(p, ev.size);
+		if (state->data == "throw")
+		{
+			throw std::runtime_error("callback error");
+		}
+	}, [state](std::exception_ptr)
+	{
+		state->errors += 1;
+	});
+	client.send(_MakeBuffer("throw"), 5).get().get();
+	bool ok = _WaitFor([state]()
+	{
+		return state->errors == 1;
+	}, 3000);
+	client.send(_MakeBuffer("again"), 5).get().get();
+	ok = _WaitFor([state]()
+	{
+		std::unique_lock<std::mutex> lock(state->lock);
+		return state->data == "throwagain";
+	}, 3000) && ok;
+	token.cancel();
+	client.close();
+	server.close();
+	return ok && state->errors == 1;
+}
+
+//一次accept_batch接受已经排队的多个连接
+static bool _AcceptBatch(stdx::network_io_service& io_service)
+{
+	stdx::ipv4_addr addr(U("127.0.0.1"), 18096);
+	stdx::socket listener = stdx::open_tcpsocket(io_service);
+	listener.bind(addr);
+	listener.listen(64);
+	std::vector<stdx::socket> clients;
+	for (int i = 0; i < 8; ++i)
+	{
+		stdx::socket client = stdx::open_tcpsocket(io_service);
+		client.connect(addr).get().get();
+		clients.push_back(client);
+	}
+	std::vector<stdx::network_connected_event> conns;
+	bool ok = true;
+	for (int round = 0; round < 8 && conns.size() < clients.size(); ++round)
+	{
+		try
+		{
+			std::vector<stdx::network_connected_event> evs = listener.accept_batch(4).get().get();
+			//不超过budget
+			ok = ok && !evs.empty() && evs.size() <= 4;
+			conns.insert(conns.end(), evs.begin(), evs.end());
+		}
+		catch (const std::exception&)
+		{
+			ok = false;
+			break;
+		}
+	}
+	ok = ok && conns.size() == clients.size();
+	//接受的连接可以正常收发
+	if (ok)
+	{
+		clients.front().send(_MakeBuffer("ping"), 4).get().get();
+		std::string data;
+		for (auto begin = conns.begin(), end = conns.end(); begin != end && data.empty(); ++begin)
+		{
+			auto t = begin->connection.recv(stdx::make_buffer(16));
+			if (_WaitFor([&t]() { return t.is_complete(); }, 200))
+			{
+				stdx::network_recv_event ev = t.get().get();
+				char* p = ev.buffer;
+				data.assign(p, ev.size);
+			}
+		}
+		ok = data == "ping";
+	}
+	for (auto begin = clients.begin(), end = clients.end(); begin != end; ++begin)
+	{
+		begin->close();
+	}
+	for (auto begin = conns.begin(), end = conns.end(); begin != end; ++begin)
+	{
+		begin->connection.close();
+	}
+	listener.close();
+	return ok;
+}
+
+//accept_until每个连接回调一次,取消后不再回调
+static bool _AcceptUntil(stdx::network_io_service& io_service)
+{
+	stdx::ipv4_addr addr(U("127.0.0.1"), 18097);
+	stdx::socket listener = stdx::open_tcpsocket(io_service);
+	listener.bind(addr);
+	listener.listen(64);
+	auto count = std::make_shared<std::atomic_int>(0);
+	auto conns = std::make_shared<std::vector<stdx::socket>>();
+	auto lock = std::make_shared<std::mutex>();
+	stdx::cancel_token token;
+	listener.accept_until(token, [count, conns, lock](stdx::network_connected_event ev)
+	{
+		std::unique_lock<std::mutex> guard(*lock);
+		conns->push_back(ev.connection);
+		*count += 1;
+	}, [](std::exception_ptr) {});
+	std::vector<stdx::socket> clients;
+	for (int i = 0; i < 20; ++i)
+	{
+		stdx::socket client = stdx::open_tcpsocket(io_service);
+		client.connect(addr).get().get();
+		clients.push_back(client);
+	}
+	bool ok = _WaitFor([count]() { return *count == 20; }, 3000);
+	token.cancel();
+	std::this_thread::sleep_for(std::chrono::milliseconds(50));
+	ok = ok && *count == 20;
+	for (auto begin = clients.begin(), end = clients.end(); begin != end; ++begin)
+	{
+		begin->close();
+	}
+	{
+		std::unique_lock<std::mutex> guard(*lock);
+		for (auto begin = conns->begin(), end = conns->end(); begin != end; ++begin)
+		{
+			begin->close();
+		}
+	}
+	listener.close();
+	return ok;
+}
+
+#ifdef LINUX
+//MSG_ZEROCOPY发送在内核释放buffer后完成,数据不变
+static bool _Zerocopy(stdx::network_io_service& io_service)
+{
+	stdx::socket client, server;
+	_Connect(io_service, 18098, client, server);
+	server.set_zerocopy(true);
+	constexpr size_t block = 65536;
+	constexpr size_t count = 32;
+	std::string expect;
+	std::thread reader([client, &expect]() mutable
+	{
+		expect = _RecvAll(client, block * count);
+	});
+	std::string sent;
+	bool ok = true;
+	for (size_t i = 0; i < count; ++i)
+	{
+		std::string msg(block, (char)('A' + i % 26));
+		sent += msg;
+		try
+		{
+			ok = server.send(_MakeBuffer(msg), block).get().get().size == block && ok;
+		}
+		catch (const std::exception&)
+		{
+			ok = false;
+		}
+	}
+	reader.join();
+	client.close();
+	server.close();
+	return ok && expect == sent;
+}
+
+//使用过错误队列后,普通的套接字错误仍然结束等待中的操作
+static bool _ZerocopySocketError(stdx::network_io_service& io_service)
+{
+	//没有监听的端口,数据报会引起ICMP端口不可达
+	stdx::ipv4_addr addr(U("127.0.0.1"), 18099);
+	stdx::socket sock = stdx::open_udpsocket(io_service);
+	sock.connect(addr).get().get();
+	sock.set_zerocopy(true);
+	auto t = sock.recv(stdx::make_buffer(64));
+	try
+	{
+		sock.send(stdx::make_buffer(STDX_ZEROCOPY_THRESHOLD), STDX_ZEROCOPY_THRESHOLD).get().get();
+	}
+	catch (const std::exception&)
+	{
+	}
+	bool ok = _WaitFor([&t]() { return t.is_complete(); }, 1000);
+	if (ok)
+	{
+		try
+		{
+			t.get().get();
+			ok = false;
+		}
+		catch (const std::exception&)
+		{
+		}
+	}
+	sock.close();
+	return ok;
+}
+
+//前缀和文件的指定区间按顺序发送
+static bool _SendFileRange(stdx::network_io_service& io_service)
+{
+	stdx::socket client, server;
+	_Connect(io_service, 18090, client, server);
+	std::string content;
+	for (size_t i = 0; i < 300000; ++i)
+	{
+		content.push_back((char)('a' + i % 26));
+	}
+	char path[] = "/tmp/stdx_sendfile_XXXXXX";
+	int fd = ::mkstemp(path);
+	::unlink(path);
+	bool ok = fd >= 0 && ::write(fd, content.data(), content.size()) == (ssize_t)content.size();
+	std::string prefix("HTTP/1.1 200 OK\r\n\r\n");
+	stdx::buffer head = _MakeBuffer(prefix);
+	auto t = server.send_file(fd, 1000, 200000, stdx::buffer_view(head, 0, prefix.size()));
+	std::string data = _RecvAll(client, prefix.size() + 200000);
+	try
+	{
+		t.get().get();
+	}
+	catch (const std::exception&)
+	{
+		ok = false;
+	}
+	ok = ok && data == prefix + content.substr(1000, 200000);
+	::close(fd);
+	client.close();
+	server.close();
+	return ok;
+}
+
+//发送期间文件被截断时以错误结束,不能当作发送成功
+static bool _SendFileTruncated(stdx::network_io_service& io_service)
+{
+	stdx::socket client, server;
+	_Connect(io_service, 18091, client, server);
+	char path[] = "/tmp/stdx_sendfile_XXXXXX";
+	int fd = ::mkstemp(path);
+	::unlink(path);
+	bool ok = fd >= 0 && ::ftruncate(fd, 64 * 1024 * 1024) == 0;
+	auto t = server.send_file(fd, 0, 0);
+	//对端还没有读,发送会停在socket缓冲区满的位置
+	std::this_thread::sleep_for(std::chrono::milliseconds(100));
+	ok = ok && ::ftruncate(fd, 1024 * 1024) == 0;
+	std::thread reader([client]() mutable
+	{
+		_RecvAll(client, 64 * 1024 * 1024);
+	});
+	bool failed = false;
+	try
+	{
+		t.get().get();
+	}
+	catch (const std::exception&)
+	{
+		failed = true;
+	}
+	//关闭后读取端读到EOF结束
+	server.close();
+	reader.join();
+	client.close();
+	::close(fd);
+	return ok && failed;
+}
+
+//管道为空时等待可读而不是空转,写端关闭后正常结束
+static bool _SendFilePipe(stdx::network_io_service& io_service)
+{
+	stdx::socket client, server;
+	_Connect(io_service, 18092, client, server);
+	int fds[2];
+	if (::pipe2(fds, O_CLOEXEC) != 0)
+	{
+		return false;
+	}
+	auto t = server.send_file(fds[0], 0, 0);
+	std::clock_t cpu = std::clock();
+	std::thread writer([fds]()
+	{
+		ssize_t r = ::write(fds[1], "hello ", 6);
+		std::this_thread::sleep_for(std::chrono::milliseconds(300));
+		r = ::write(fds[1], "world", 5);
+		NO_USED(r);
+		::close(fds[1]);
+	});
+	std::string data = _RecvAll(client, 11);
+	bool ok = true;
+	try
+	{
+		t.get().get();
+	}
+	catch (const std::exception&)
+	{
+		ok = false;
+	}
+	writer.join();
+	double cpu_ms = (double)(std::clock() - cpu) * 1000 / CLOCKS_PER_SEC;
+	::close(fds[0]);
+	client.close();
+	server.close();
+	return ok && data == "hello world" && cpu_ms < 150;
+}
+#endif
+
+//零长度的scatter/gather立即以0字节完成,连接仍可使用
+static bool _EmptyVectored(stdx::network_io_service& io_service)
+{
+	stdx::socket client, server;
+	_Connect(io_service, 18111, client, server);
+	auto send = client.send(std::vector<stdx::buffer_view>());
+	auto recv = server.recv(std::vector<stdx::buffer_view>(1, stdx::buffer_view(stdx::make_buffer(16), 0, 0)));
+	bool ok = _WaitFor([&recv, &send]() { return recv.is_complete() && send.is_complete(); }, 1000);
+	try
+	{
+		ok = ok && send.get().get().size == 0 && recv.get().get().size == 0;
+		client.send(_MakeBuffer("ping"), 4).get().get();
+		ok = ok && _RecvAll(server, 4) == "ping";
+	}
+	catch (const std::exception&)
+	{
+		ok = false;
+	}
+	client.close();
+	server.close();
+	return ok;
+}
+
+#ifdef LINUX
+//端口为0时所有监听socket共用第一个socket分配的端口
+static bool _ReusePortEphemeral(stdx::network_io_service& io_service)
+{
+	std::vector<stdx::socket> listeners = stdx::open_reuse_port_tcpsockets(io_service, stdx::ipv4_addr(U("127.0.0.1"), 0), 16, 3);
+	uint16_t port = listeners.front().local_addr().port();
+	bool ok = listeners.size() == 3 && port != 0;
+	for (auto begin = listeners.begin(), end = listeners.end(); begin != end; ++begin)
+	{
+		ok = ok && begin->local_addr().port() == port;
+	}
+	stdx::socket client = stdx::open_tcpsocket(io_service);
+	try
+	{
+		client.connect(stdx::ipv4_addr(U("127.0.0.1"), port)).get().get();
+	}
+	catch (const std::exception&)
+	{
+		ok = false;
+	}
+	client.close();
+	for (auto begin = listeners.begin(), end = listeners.end(); begin != end; ++begin)
+	{
+		begin->close();
+	}
+	return ok;
+}
+
+//空批次立即完成,不会一直留在poller中
+static bool _EmptyBatch(stdx::network_io_service& io_service)
+{
+	stdx::socket sock = stdx::open_udpsocket(io_service);
+	sock.bind(stdx::ipv4_addr(U("127.0.0.1"), 18110));
+	auto recv = sock.recv_from_batch(std::vector<stdx::buffer>());
+	auto send = sock.send_to_batch(std::vector<stdx::network_datagram>());
+	bool ok = _WaitFor([&recv, &send]() { return recv.is_complete() && send.is_complete(); }, 1000);
+	try
+	{
+		ok = ok && recv.get().get().empty() && send.get().get() == 0;
+	}
+	catch (const std::exception&)
+	{
+		ok = false;
+	}
+	sock.close();
+	return ok;
+}
+#endif
+
+static std::string _ViewString(const stdx::buffer_view& view)
+{
+	stdx::buffer_view v(view);
+	return std::string(v.data(), v.size);
+}
+
+//分隔符跨越多次接收时也能找到
+static bool _BufferedReadUntil(stdx::network_io_service& io_service)
+{
+	stdx::socket client, server;
+	_Connect(io_service, 18116, client, server);
+	stdx::buffered_socket_reader reader = stdx::make_buffered_socket_reader(server, 8);
+	bool ok = true;
+	try
+	{
+		auto line = reader.read_until("\r\n");
+		const char* parts[] = { "hel","lo wor","ld\r","\nsecond\r\n" };
+		for (auto part : parts)
+		{
+			std::string str(part);
+			client.send(_MakeBuffer(str), str.size()).get().get();
+			std::this_thread::sleep_for(std::chrono::milliseconds(20));
+		}
+		ok = _ViewString(line.get().get()) == "hello world\r\n";
+		ok = ok && _ViewString(reader.read_until("\r\n").get().get()) == "second\r\n" && reader.buffered_size() == 0;
+	}
+	catch (const std::exception&)
+	{
+		ok = false;
+	}
+	client.close();
+	server.close();
+	return ok;
+}
+
+//read_exact等到足够的数据,多余的数据留给下一次读
+static bool _BufferedReadExact(stdx::network_io_service& io_service)
+{
+	stdx::socket client, server;
+	_Connect(io_service, 18117, client, server);
+	stdx::buffered_socket_reader reader = stdx::make_buffered_socket_reader(server, 4);
+	bool ok = true;
+	try
+	{
+		auto first = reader.read_exact(6);
+		client.send(_MakeBuffer("abc"), 3).get().get();
+		std::this_thread::sleep_for(std::chrono::milliseconds(20));
+		client.send(_MakeBuffer("defghij"), 7).get().get();
+		ok = _ViewString(first.get().get()) == "abcdef";
+		ok = ok && _ViewString(reader.read_exact(4).get().get()) == "ghij";
+	}
+	catch (const std::exception&)
+	{
+		ok = false;
+	}
+	client.close();
+	server.close();
+	return ok;
+}
+
+//超过max_size的行和read_exact以length_error结束
+static bool _BufferedMaxSize(stdx::network_io_service& io_service)
+{
+	stdx::socket client, server;
+	_Connect(io_service, 18118, client, server);
+	stdx::buffered_socket_reader reader = stdx::make_buffered_socket_reader(server, 8, 16);
+	bool ok = false;
+	try
+	{
+		reader.read_exact(17).get().get();
+	}
+	catch (const std::length_error&)
+	{
+		ok = true;
+	}
+	catch (const std::exception&)
+	{
+	}
+	bool line_ok = false;
+	try
+	{
+		client.send(_MakeBuffer(std::string(32, 'a')), 32).get().get();
+		reader.read_until("\n").get().get();
+	}
+	catch (const std::length_error&)
+	{
+		line_ok = true;
+	}
+	catch (const std::exception&)
+	{
+	}
+	client.close();
+	server.close();
+	return ok && line_ok;
+}
+
+//先发出对端不读取的大块数据,保持发送状态
+static void _StartBulk(stdx::buffered_socket_writer& writer, size_t size)
+{
+	stdx::buffer bulk = stdx::make_buffer(size);
+	for (size_t i = 0; i < size; ++i)
+	{
+		bulk[i] = 'z';
+	}
+	writer.write(bulk, size);
+}
+
+//发送期间的小写入合并到同一批
+static bool _BufferedWriterCoalesce(stdx::network_io_service& io_service)
+{
+	stdx::socket client, server;
+	_Connect(io_service, 18119, client, server);
+	stdx::buffered_socket_writer writer = stdx::make_buffered_socket_writer(client);
+	const size_t bulk_size = 32 * 1024 * 1024;
+	_StartBulk(writer, bulk_size);
+	std::string expect;
+	for (int i = 0; i < 10; ++i)
+	{
+		std::string str = "w" + std::to_string(i);
+		writer.write(str.data(), str.size());
+		expect += str;
+	}
+	//上一批没有完成时都在同一个输出块中
+	bool ok = writer.pending_size() == expect.size();
+	auto flush = writer.flush();
+	std::string data = _RecvAll(server, bulk_size + expect.size());
+	ok = ok && _WaitFor([&flush]() { return flush.is_complete(); }, 3000);
+	try
+	{
+		flush.get().get();
+		ok = ok && data.size() == bulk_size + expect.size() && data.compare(bulk_size, expect.size(), expect) == 0 && writer.pending_size() == 0;
+	}
+	catch (const std::exception&)
+	{
+		ok = false;
+	}
+	client.close();
+	server.close();
+	return ok;
+}
+
+//flush按调用顺序完成,完成时之前的数据都已发送
+static bool _BufferedFlushOrder(stdx::network_io_service& io_service)
+{
+	stdx::socket client, server;
+	_Connect(io_service, 18120, client, server);
+	stdx::buffered_socket_writer writer = stdx::make_buffered_socket_writer(client);
+	const size_t bulk_size = 32 * 1024 * 1024;
+	auto lock = std::make_shared<std::mutex>();
+	auto order = std::make_shared<std::vector<int>>();
+	_StartBulk(writer, bulk_size);
+	std::vector<stdx::task<void>> flushes;
+	for (int i = 0; i < 3; ++i)
+	{
+		std::string str = "f" + std::to_string(i);
+		writer.write(str.data(), str.size());
+		flushes.push_back(writer.flush().then([lock, order, i]()
+		{
+			std::unique_lock<std::mutex> guard(*lock);
+			order->push_back(i);
+		}));
+	}
+	bool ok = !flushes.front().is_complete();
+	std::string data = _RecvAll(server, bulk_size + 6);
+	try
+	{
+		for (auto begin = flushes.begin(), end = flushes.end(); begin != end; ++begin)
+		{
+			begin->get().get();
+		}
+		std::unique_lock<std::mutex> guard(*lock);
+		ok = ok && data.size() == bulk_size + 6 && data.compare(bulk_size, 6, "f0f1f2") == 0 && *order == std::vector<int>({ 0,1,2 });
+		guard.unlock();
+		//没有待发送数据时立即完成
+		ok = ok && writer.flush().is_complete();
+	}
+	catch (const std::exception&)
+	{
+		ok = false;
+	}
+	client.close();
+	server.close();
+	return ok;
+}
+
+//发送失败后,后续的write和flush都返回该错误
+static bool _BufferedWriterError(stdx::network_io_service& io_service)
+{
+	stdx::socket client, server;
+	_Connect(io_service, 18121, client, server);
+	stdx::buffered_socket_writer writer = stdx::make_buffered_socket_writer(client);
+	server.close();
+	std::this_thread::sleep_for(std::chrono::milliseconds(20));
+	std::string data(STDX_WRITE_COPY_LIMIT, 'e');
+	bool failed = false;
+	for (int i = 0; i < 100 && !failed; ++i)
+	{
+		try
+		{
+			writer.write(data.data(), data.size());
+			writer.flush().get().get();
+		}
+		catch (const std::exception&)
+		{
+			failed = true;
+		}
+	}
+	bool ok = failed;
+	try
+	{
+		writer.flush().get().get();
+		ok = false;
+	}
+	catch (const std::exception&)
+	{
+	}
+	try
+	{
+		writer.write("x", 1);
+		ok = false;
+	}
+	catch (const std::exception&)
+	{
+	}
+	client.close();
+	return ok;
+}
+
+//接受连接并保存,供连接池测试检查建立了几个连接
+struct _PoolServer
+{
+	_PoolServer(stdx::network_io_service& io_service, uint16_t port)
+		:addr(stdx::ipv4_addr(U("127.0.0.1"), port))
+		,listener(stdx::open_tcpsocket(io_service))
+		,token()
+		,lock(std::make_shared<std::mutex>())
+		,conns(std::make_shared<std::vector<stdx::socket>>())
+	{
+		listener.bind(addr);
+		listener.listen(16);
+		auto lock = this->lock;
+		auto conns = this->conns;
+		listener.accept_until(token, [lock, conns](stdx::network_connected_event ev)
+		{
+			std::unique_lock<std::mutex> guard(*lock);
+			conns->push_back(ev.connection);
+		}, [](std::exception_ptr) {});
+	}
+
+	~_PoolServer()
+	{
+		token.cancel();
+		listener.close();
+		std::unique_lock<std::mutex> guard(*lock);
+		for (auto begin = conns->begin(), end = conns->end(); begin != end; ++begin)
+		{
+			begin->close();
+		}
+	}
+
+	size_t count()
+	{
+		std::unique_lock<std::mutex> guard(*lock);
+		return conns->size();
+	}
+
+	stdx::socket_addr addr;
+	stdx::socket listener;
+	stdx::cancel_token token;
+	std::shared_ptr<std::mutex> lock;
+	std::shared_ptr<std::vector<stdx::socket>> conns;
+};
+
+//达到每个地址的上限后get等待,不会建立新连接
+static bool _PoolPerHostLimit(stdx::network_io_service& io_service)
+{
+	_PoolServer server(io_service, 18112);
+	stdx::connection_pool pool = stdx::make_connection_pool(io_service, 1);
+	bool ok = true;
+	try
+	{
+		stdx::socket first = pool.get(server.addr).get().get();
+		auto second = pool.get(server.addr);
+		std::this_thread::sleep_for(std::chrono::milliseconds(100));
+		ok = !second.is_complete() && _WaitFor([&server]() { return server.count() == 1; }, 1000);
+		pool.release(server.addr, first, false);
+		//关闭的名额转给等待者
+		ok = ok && _WaitFor([&second]() { return second.is_complete(); }, 1000);
+		stdx::socket sock = second.get().get();
+		ok = ok && !(sock == first) && _WaitFor([&server]() { return server.count() == 2; }, 1000);
+		pool.release(server.addr, sock, false);
+	}
+	catch (const std::exception&)
+	{
+		ok = false;
+	}
+	pool.close();
+	return ok;
+}
+
+//归还的连接直接交给等待者
+static bool _PoolWaiterHandoff(stdx::network_io_service& io_service)
+{
+	_PoolServer server(io_service, 18113);
+	stdx::connection_pool pool = stdx::make_connection_pool(io_service, 1);
+	bool ok = true;
+	try
+	{
+		stdx::socket first = pool.get(server.addr).get().get();
+		ok = _WaitFor([&server]() { return server.count() == 1; }, 1000);
+		auto second = pool.get(server.addr);
+		pool.release(server.addr, first);
+		ok = ok && _WaitFor([&second]() { return second.is_complete(); }, 1000);
+		stdx::socket sock = second.get().get();
+		ok = ok && sock == first && pool.idle_count(server.addr) == 0;
+		pool.release(server.addr, sock);
+		//没有建立第二个连接
+		ok = ok && pool.idle_count(server.addr) == 1 && server.count() == 1;
+	}
+	catch (const std::exception&)
+	{
+		ok = false;
+	}
+	pool.close();
+	return ok;
+}
+
+//对端已关闭的空闲连接不会被复用
+static bool _PoolStaleRejected(stdx::network_io_service& io_service)
+{
+	_PoolServer server(io_service, 18114);
+	stdx::connection_pool pool = stdx::make_connection_pool(io_service, 1);
+	bool ok = true;
+	try
+	{
+		stdx::socket first = pool.get(server.addr).get().get();
+		pool.release(server.addr, first);
+		ok = pool.idle_count(server.addr) == 1 && _WaitFor([&server]() { return server.count() == 1; }, 1000);
+		{
+			std::unique_lock<std::mutex> guard(*server.lock);
+			server.conns->front().close();
+		}
+		ok = ok && _WaitFor([&first]() { return !first.is_idle_alive(); }, 1000);
+		stdx::socket sock = pool.get(server.addr).get().get();
+		ok = ok && !(sock == first) && pool.idle_count(server.addr) == 0 && _WaitFor([&server]() { return server.count() == 2; }, 1000);
+		pool.release(server.addr, sock, false);
+	}
+	catch (const std::exception&)
+	{
+		ok = false;
+	}
+	pool.close();
+	return ok;
+}
+
+//没有新的请求时,超时的空闲连接也会被关闭
+static bool _PoolEvictIdle(stdx::network_io_service& io_service)
+{
+	_PoolServer server(io_service, 18115);
+	stdx::connection_pool pool = stdx::make_connection_pool(io_service, 4, 100);
+	bool ok = true;
+	try
+	{
+		stdx::socket first = pool.get(server.addr).get().get();
+		stdx::socket second = pool.get(server.addr).get().get();
+		pool.release(server.addr, first);
+		std::this_thread::sleep_for(std::chrono::milliseconds(50));
+		pool.release(server.addr, second);
+		ok = pool.idle_count(server.addr) == 2;
+		ok = ok && _WaitFor([&pool, &server]() { return pool.idle_count(server.addr) == 0; }, 2000);
+		//再次归还时重新计时
+		stdx::socket third = pool.get(server.addr).get().get();
+		pool.release(server.addr, third);
+		ok = ok && _WaitFor([&pool, &server]() { return pool.idle_count(server.addr) == 0; }, 2000);
+	}
+	catch (const std::exception&)
+	{
+		ok = false;
+	}
+	pool.close();
+	return ok;
+}
+
+int socket_test(int argc, char** argv)
+{
+	NO_USED(argc);
+	NO_USED(argv);
+	stdx::network_io_service io_service;
+	bool ok = true;
+	ok = _Check(_RecvUntil(io_service), "recv_until delivers every chunk") && ok;
+	ok = _Check(_RecvUntilCancel(io_service), "recv_until cancel keeps later data") && ok;
+	ok = _Check(_RecvUntilCallbackError(io_service), "recv_until callback error") && ok;
+	ok = _Check(_AcceptBatch(io_service), "accept_batch") && ok;
+	ok = _Check(_AcceptUntil(io_service), "accept_until") && ok;
+	ok = _Check(_EmptyVectored(io_service), "empty scatter/gather") && ok;
+	ok = _Check(_BufferedReadUntil(io_service), "buffered read_until across segments") && ok;
+	ok = _Check(_BufferedReadExact(io_service), "buffered read_exact") && ok;
+	ok = _Check(_BufferedMaxSize(io_service), "buffered reader max size") && ok;
+	ok = _Check(_BufferedWriterCoalesce(io_service), "buffered writer coalesces small writes") && ok;
+	ok = _Check(_BufferedFlushOrder(io_service), "buffered writer flush order") && ok;
+	ok = _Check(_BufferedWriterError(io_service), "buffered writer error propagation") && ok;
+	ok = _Check(_PoolPerHostLimit(io_service), "connection pool per-host limit") && ok;
+	ok = _Check(_PoolWaiterHandoff(io_service), "connection pool waiter hand-off") && ok;
+	ok = _Check(_PoolStaleRejected(io_service), "connection pool rejects stale connections") && ok;
+	ok = _Check(_PoolEvictIdle(io_service), "connection pool evicts idle connections") && ok;
+#ifdef LINUX
+	ok = _Check(_Zerocopy(io_service), "zerocopy send") && ok;
+	ok = _Check(_ZerocopySocketError(io_service), "zerocopy socket error") && ok;
+	ok = _Check(_SendFileRange(io_service), "send_file range with prefix") && ok;
+	ok = _Check(_SendFileTruncated(io_service), "send_file truncated file") && ok;
+	ok = _Check(_SendFilePipe(io_service), "send_file pipe") && ok;
+	ok = _Check(_EmptyBatch(io_service), "empty datagram batch") && ok;
+	ok = _Check(_ReusePortEphemeral(io_service), "reuse port listeners share an ephemeral port") && ok;
+#endif
+	return ok ? 0 : 1;
+}
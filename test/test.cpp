@@ -3,8 +3,44 @@
 #include "lock_test.h"
 #include "task_test.h"
 #include "file_test.h"
+#include "io_bench.h"
+#include "http_parser_bench.h"
+#include "socket_test.h"
+#include "http_test.h"
+#include <string>
+
+struct test_entry
+{
+	const char* name;
+	int(*fn)(int, char**);
+};
+
+//teststdx <name> [args...]运行指定的测试,不带名称时运行web_test
+static const test_entry tests[] =
+{
+	{"web_test",web_test},
+	{"client_test",client_test},
+	{"lock_test",lock_test},
+	{"task_test",task_test},
+	{"file_test",file_test},
+	{"io_bench",io_bench},
+	{"http_parser_bench",http_parser_bench},
+	{"socket_test",socket_test},
+	{"http_test",http_test}
+};
 
 int main(int argc, char** argv)
 {
+	if (argc > 1)
+	{
+		std::string name(argv[1]);
+		for (size_t i = 0; i < sizeof(tests) / sizeof(tests[0]); ++i)
+		{
+			if (name == tests[i].name)
+			{
+				return tests[i].fn(argc - 1, argv + 1);
+			}
+		}
+	}
 	return web_test(argc, argv);
-}
\ No newline at end of file
+}
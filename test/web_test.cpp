@@ -8,75 +8,27 @@ void add_keepalive(stdx::http_response& res, bool keep)
 	}
 }
 
-bool handle_request(stdx::http_connection conn, stdx::http_request req, stdx::file_io_service& ios)
+bool handle_request(stdx::http_connection conn, stdx::http_request req, stdx::http_static_file_handler& files)
 {
-	if (req.request_header().request_url() == U("/"))
-	{
-		req.request_header().request_url().append(U("index.html"));
-	}
 	bool keep = req.request_header().is_keepalive();
-	stdx::string path(U("."));
-	path.append(req.request_header().request_url());
-	stdx::file file(ios, path);
-	if (!path.end_with(U('/')) && file.exist())
-	{
-		auto stream = file.open_stream(stdx::file_access_type::read, stdx::file_open_type::open);
-		auto  x = stream.read_to_end(0)
-			.then([stream, conn, keep](stdx::task_result<stdx::file_read_event> r) mutable
-				{
-					stream.close();
-					try
-					{
-						auto ev = r.get();
-						stdx::http_response response(200);
-						//response.response_header().add_header(U("Content-Type"), U("text/html"));
-						response.response_body().push((const unsigned char*)(const char*)ev.buffer, ev.buffer.size());
-						add_keepalive(response, keep);
-						auto t = conn.write(response)
-							.then([conn, keep](stdx::task_result<size_t> r)mutable
-								{
-									if (!keep)
-									{
-										conn.close();
-									}
-								});
-					}
-					catch (const std::exception& err)
-					{
-						stdx::perrorf(U("请求处理出错:{0}\n"), err.what());
-						stdx::http_response response(502);
-						response.response_header().add_header(U("Content-Type"), U("text/html"));
-						stdx::string body = U("<html><body><h1>Server Unavailable</h1></body></html>");
-						response.response_body().push(body);
-						add_keepalive(response, keep);
-						auto t = conn.write(response)
-							.then([conn, keep](stdx::task_result<size_t> r)mutable
-								{
-									if (!keep)
-									{
-										conn.close();
-									}
-								});
-					}
-				});
-		NO_USED(x);
-	}
-	else
-	{
-		stdx::http_response response(404);
-		response.response_header().add_header(U("Content-Type"), U("text/html"));
-		stdx::string body = U("<html><body><h1>Not Found</h1></body></html>");
-		response.response_body().push(body);
-		add_keepalive(response, keep);
-		auto t = conn.write(response)
-			.then([conn, keep](stdx::task_result<size_t> r)mutable
-				{
-					if (!keep)
-					{
-						conn.close();
-					}
-				});
-	}
+	//文件内容通过send_file发送,不读入内存
+	files.handle(conn, req).then([conn, keep](stdx::task_result<void> r) mutable
+		{
+			try
+			{
+				r.get();
+			}
+			catch (const std::exception& err)
+			{
+				stdx::perrorf(U("请求处理出错:{0}\n"), err.what());
+				conn.close();
+				return;
+			}
+			if (!keep)
+			{
+				conn.close();
+			}
+		});
 	return keep;
 }
 